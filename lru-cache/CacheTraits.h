@@ -0,0 +1,78 @@
+#ifndef LRU_CACHE_CACHETRAITS_H
+#define LRU_CACHE_CACHETRAITS_H
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Hash used by the cache indexes. It is std::hash<Key>, except for
+// std::string, where a transparent hash lets lookups by std::string_view or
+// const char* probe the index without building a temporary std::string.
+template <typename Key>
+struct KeyHash : std::hash<Key> {};
+
+template <>
+struct KeyHash<std::string> {
+    using is_transparent = void;
+
+    // std::hash<std::string_view> agrees with std::hash<std::string> for equal
+    // character sequences, so both key forms land in the same bucket.
+    [[nodiscard]] std::size_t operator()(const std::string_view key) const noexcept {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+template <typename Key>
+concept TransparentKeyHash = requires { typename KeyHash<Key>::is_transparent; };
+
+// Types a lookup (Get, GetWith, Contains) accepts: with a transparent
+// KeyHash<Key>, anything it hashes and compares against Key directly;
+// otherwise anything convertible to Key.
+template <typename K, typename Key>
+concept LookupKey =
+    (TransparentKeyHash<Key> && std::invocable<const KeyHash<Key>&, const K&> &&
+     requires(const Key& stored, const K& key) {
+         { stored == key } -> std::convertible_to<bool>;
+     }) ||
+    (!TransparentKeyHash<Key> && std::convertible_to<const K&, Key>);
+
+// Keys LRUCache stores inline in its SIMD-probed table (SwissLRUCache.h)
+// instead of in hash-map nodes: small trivially copyable types such as
+// integers, enums and pointers.
+template <typename Key>
+concept InlineKey = std::is_trivially_copyable_v<Key> && sizeof(Key) <= 16U && !TransparentKeyHash<Key> &&
+                    std::equality_comparable<Key>;
+
+// Weight of one entry in the unit of the cache's weight budget (bytes, for
+// example). Called once per insert or update, under the cache lock.
+template <typename Weigher, typename Key, typename Value>
+concept EntryWeigher = std::copy_constructible<Weigher> &&
+                       std::invocable<const Weigher&, const Key&, const Value&> &&
+                       std::convertible_to<std::invoke_result_t<const Weigher&, const Key&, const Value&>,
+                                           std::size_t>;
+
+// Default weigher: every entry weighs 1, so the weight budget is an entry
+// count and WeightedSize() equals Size().
+struct UnitWeigher {
+    template <typename Key, typename Value>
+    [[nodiscard]] constexpr std::size_t operator()(const Key&, const Value&) const noexcept {
+        return 1U;
+    }
+};
+
+// Overwrites `target` with a value built from `args`. A single assignable
+// argument is assigned directly so the existing value can reuse its buffers.
+template <typename Value, typename... Args>
+void AssignValue(Value& target, Args&&... args) {
+    if constexpr (sizeof...(Args) == 1 && (std::is_assignable_v<Value&, Args&&> && ...)) {
+        ((target = std::forward<Args>(args)), ...);
+    } else {
+        target = Value(std::forward<Args>(args)...);
+    }
+}
+
+#endif  // LRU_CACHE_CACHETRAITS_H
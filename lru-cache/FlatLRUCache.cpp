@@ -0,0 +1,268 @@
+#ifndef LRU_CACHE_FLATLRUCACHE_CPP
+#define LRU_CACHE_FLATLRUCACHE_CPP
+
+#include "FlatLRUCache.h"
+
+#include <bit>
+
+template <typename Key, typename Value>
+FlatLRUCache<Key, Value>::FlatLRUCache(const std::size_t capacity) : capacity_(capacity) {
+    if (capacity_ == 0U) {
+        throw std::invalid_argument("FlatLRUCache capacity must be greater than zero");
+    }
+    if (capacity_ > static_cast<std::size_t>(kNoSlot) / 2U) {
+        throw std::invalid_argument("FlatLRUCache capacity exceeds 32-bit slot range");
+    }
+
+    // Keep the index at most half full so linear probe sequences stay short.
+    const std::size_t bucket_count = std::bit_ceil(capacity_ * 2U);
+    bucket_mask_ = bucket_count - 1U;
+    entries_.resize(capacity_);
+    buckets_.resize(bucket_count);
+}
+
+template <typename Key, typename Value>
+FlatLRUCache<Key, Value>::FlatLRUCache(FlatLRUCache&& other) noexcept {
+    std::scoped_lock lock(other.mutex_);
+    capacity_ = other.capacity_;
+    bucket_mask_ = other.bucket_mask_;
+    entries_ = std::move(other.entries_);
+    buckets_ = std::move(other.buckets_);
+    size_ = std::exchange(other.size_, 0U);
+    head_ = std::exchange(other.head_, kNoSlot);
+    tail_ = std::exchange(other.tail_, kNoSlot);
+    free_ = std::exchange(other.free_, kNoSlot);
+}
+
+template <typename Key, typename Value>
+FlatLRUCache<Key, Value>& FlatLRUCache<Key, Value>::operator=(FlatLRUCache&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    std::scoped_lock lock(mutex_, other.mutex_);
+    capacity_ = other.capacity_;
+    bucket_mask_ = other.bucket_mask_;
+    entries_ = std::move(other.entries_);
+    buckets_ = std::move(other.buckets_);
+    size_ = std::exchange(other.size_, 0U);
+    head_ = std::exchange(other.head_, kNoSlot);
+    tail_ = std::exchange(other.tail_, kNoSlot);
+    free_ = std::exchange(other.free_, kNoSlot);
+    return *this;
+}
+
+template <typename Key, typename Value>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> FlatLRUCache<Key, Value>::Get(const K& key) {
+    const std::uint32_t hash = HashOf(key);
+    std::scoped_lock lock(mutex_);
+
+    const Bucket& bucket = buckets_[FindBucket(key, hash)];
+    if (bucket.slot == kNoSlot) {
+        return std::nullopt;
+    }
+
+    MoveToFront(bucket.slot);
+    return entries_[bucket.slot].value;
+}
+
+template <typename Key, typename Value>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool FlatLRUCache<Key, Value>::GetWith(const K& key, Visitor&& visitor) {
+    const std::uint32_t hash = HashOf(key);
+    std::scoped_lock lock(mutex_);
+
+    const Bucket& bucket = buckets_[FindBucket(key, hash)];
+    if (bucket.slot == kNoSlot) {
+        return false;
+    }
+
+    MoveToFront(bucket.slot);
+    std::invoke(visitor, std::as_const(entries_[bucket.slot].value));
+    return true;
+}
+
+template <typename Key, typename Value>
+template <typename K>
+    requires LookupKey<K, Key>
+bool FlatLRUCache<Key, Value>::Contains(const K& key) const {
+    const std::uint32_t hash = HashOf(key);
+    std::scoped_lock lock(mutex_);
+    return buckets_[FindBucket(key, hash)].slot != kNoSlot;
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::Put(const Key& key, const Value& value) {
+    Emplace(key, value);
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::Put(Key&& key, Value&& value) {
+    Emplace(std::move(key), std::move(value));
+}
+
+template <typename Key, typename Value>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void FlatLRUCache<Key, Value>::Emplace(K&& key, Args&&... args) {
+    const std::uint32_t hash = HashOf(key);
+    std::scoped_lock lock(mutex_);
+
+    std::size_t position = FindBucket(key, hash);
+    if (buckets_[position].slot != kNoSlot) {
+        const SlotIndex slot = buckets_[position].slot;
+        AssignValue(entries_[slot].value, std::forward<Args>(args)...);
+        MoveToFront(slot);
+        return;
+    }
+
+    // A free slot is claimed only once both assignments succeed. Slots freed
+    // by a failed Put come first; without them the used slots are dense.
+    const bool fill = size_ < capacity_;
+    SlotIndex slot = free_ != kNoSlot ? free_ : static_cast<SlotIndex>(size_);
+    if (!fill) {
+        // Recycle the LRU slot in place; its key and value buffers are reused
+        // by assignment instead of being freed and reallocated.
+        slot = tail_;
+        Unlink(slot);
+        EraseBucket(FindBucket(entries_[slot].key, HashOf(entries_[slot].key)));
+        position = FindBucket(key, hash);
+    }
+
+    Entry& entry = entries_[slot];
+    try {
+        AssignValue(entry.key, std::forward<K>(key));
+        AssignValue(entry.value, std::forward<Args>(args)...);
+    } catch (...) {
+        // As in LRUCache, the victim stays evicted and nothing is inserted;
+        // its slot joins the free list.
+        if (!fill) {
+            entries_[slot].next = free_;
+            free_ = slot;
+            --size_;
+        }
+        throw;
+    }
+    if (fill) {
+        if (slot == free_) {
+            free_ = entry.next;
+        }
+        ++size_;
+    }
+    LinkFront(slot);
+    buckets_[position] = Bucket{slot, hash};
+}
+
+template <typename Key, typename Value>
+std::size_t FlatLRUCache<Key, Value>::Size() const {
+    std::scoped_lock lock(mutex_);
+    return size_;
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::Clear() {
+    std::scoped_lock lock(mutex_);
+    for (Bucket& bucket : buckets_) {
+        bucket = Bucket{};
+    }
+    for (SlotIndex slot = head_; slot != kNoSlot;) {
+        const SlotIndex next = entries_[slot].next;
+        entries_[slot] = Entry{};
+        slot = next;
+    }
+    size_ = 0U;
+    head_ = kNoSlot;
+    tail_ = kNoSlot;
+    free_ = kNoSlot;
+}
+
+template <typename Key, typename Value>
+template <typename K>
+std::uint32_t FlatLRUCache<Key, Value>::HashOf(const K& key) {
+    // std::hash is the identity for integers on common standard libraries, so
+    // fold it through a 64-bit finalizer before masking.
+    std::uint64_t hash = static_cast<std::uint64_t>(KeyHash<Key>{}(key));
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    return static_cast<std::uint32_t>(hash);
+}
+
+template <typename Key, typename Value>
+template <typename K>
+std::size_t FlatLRUCache<Key, Value>::FindBucket(const K& key, const std::uint32_t hash) const {
+    std::size_t position = hash & bucket_mask_;
+    while (true) {
+        const Bucket& bucket = buckets_[position];
+        if (bucket.slot == kNoSlot ||
+            (bucket.hash == hash && entries_[bucket.slot].key == key)) {
+            return position;
+        }
+        position = (position + 1U) & bucket_mask_;
+    }
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::EraseBucket(std::size_t position) noexcept {
+    // Backward-shift deletion keeps probe sequences intact without tombstones.
+    std::size_t next = (position + 1U) & bucket_mask_;
+    while (buckets_[next].slot != kNoSlot) {
+        const std::size_t home = buckets_[next].hash & bucket_mask_;
+        const std::size_t next_distance = (next - home) & bucket_mask_;
+        const std::size_t hole_distance = (next - position) & bucket_mask_;
+        if (next_distance >= hole_distance) {
+            buckets_[position] = buckets_[next];
+            position = next;
+        }
+        next = (next + 1U) & bucket_mask_;
+    }
+
+    buckets_[position] = Bucket{};
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::Unlink(const SlotIndex slot) noexcept {
+    Entry& entry = entries_[slot];
+    if (entry.prev != kNoSlot) {
+        entries_[entry.prev].next = entry.next;
+    } else {
+        head_ = entry.next;
+    }
+    if (entry.next != kNoSlot) {
+        entries_[entry.next].prev = entry.prev;
+    } else {
+        tail_ = entry.prev;
+    }
+    entry.prev = kNoSlot;
+    entry.next = kNoSlot;
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::LinkFront(const SlotIndex slot) noexcept {
+    Entry& entry = entries_[slot];
+    entry.prev = kNoSlot;
+    entry.next = head_;
+    if (head_ != kNoSlot) {
+        entries_[head_].prev = slot;
+    }
+    head_ = slot;
+    if (tail_ == kNoSlot) {
+        tail_ = slot;
+    }
+}
+
+template <typename Key, typename Value>
+void FlatLRUCache<Key, Value>::MoveToFront(const SlotIndex slot) noexcept {
+    if (slot == head_) {
+        return;
+    }
+
+    Unlink(slot);
+    LinkFront(slot);
+}
+
+#endif  // LRU_CACHE_FLATLRUCACHE_CPP
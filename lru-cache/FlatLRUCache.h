@@ -0,0 +1,106 @@
+#ifndef LRU_CACHE_FLATLRUCACHE_H
+#define LRU_CACHE_FLATLRUCACHE_H
+
+#include "CacheTraits.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Thread-safe LRU cache backed by flat, preallocated storage:
+// - entries live in a capacity-sized slab linked by 32-bit prev/next indices
+// - an open-addressing (linear probing) index maps key hashes to slab slots
+// - no allocation happens after construction except inside Key/Value themselves
+template <typename Key, typename Value>
+class FlatLRUCache final {
+public:
+    explicit FlatLRUCache(std::size_t capacity);
+    ~FlatLRUCache() = default;
+
+    FlatLRUCache(const FlatLRUCache&) = delete;
+    FlatLRUCache& operator=(const FlatLRUCache&) = delete;
+    FlatLRUCache(FlatLRUCache&& other) noexcept;
+    FlatLRUCache& operator=(FlatLRUCache&& other) noexcept;
+
+    // Lookups accept the same heterogeneous key types as LRUCache.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    // Runs `visitor(const Value&)` on the cached value in place, under the
+    // lock, and marks the entry as used. Returns false on a miss. The visitor
+    // must not call back into the cache.
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor);
+    // Presence check that does not count as a use.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    // Slots are always live objects, so Emplace assigns into the recycled
+    // slot; a value built from several arguments is constructed, then moved.
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
+    [[nodiscard]] std::size_t Size() const;
+    void Clear();
+
+private:
+    using SlotIndex = std::uint32_t;
+
+    static constexpr SlotIndex kNoSlot = std::numeric_limits<SlotIndex>::max();
+
+    struct Entry {
+        Key key{};
+        Value value{};
+        SlotIndex prev = kNoSlot;
+        SlotIndex next = kNoSlot;
+    };
+
+    // Index buckets keep the mixed hash next to the slot so most probe
+    // mismatches are rejected without touching the slab.
+    struct Bucket {
+        SlotIndex slot = kNoSlot;
+        std::uint32_t hash = 0;
+    };
+
+    template <typename K>
+    [[nodiscard]] static std::uint32_t HashOf(const K& key);
+    template <typename K>
+    [[nodiscard]] std::size_t FindBucket(const K& key, std::uint32_t hash) const;
+    void EraseBucket(std::size_t position) noexcept;
+    void Unlink(SlotIndex slot) noexcept;
+    void LinkFront(SlotIndex slot) noexcept;
+    void MoveToFront(SlotIndex slot) noexcept;
+
+    std::size_t capacity_;
+    std::size_t bucket_mask_;
+    std::vector<Entry> entries_;
+    std::vector<Bucket> buckets_;
+    std::size_t size_ = 0;
+    SlotIndex head_ = kNoSlot;
+    SlotIndex tail_ = kNoSlot;
+    // Slots left empty by a failed Put, linked through `next`.
+    SlotIndex free_ = kNoSlot;
+    mutable std::mutex mutex_;
+};
+
+// Values held behind shared_ptr<const Value>: a hit copies only the handle
+// (one refcount increment) under the lock, and the caller may keep reading it
+// after the entry is evicted or overwritten.
+template <typename Key, typename Value>
+using SharedValueFlatLRUCache = FlatLRUCache<Key, std::shared_ptr<const Value>>;
+
+#include "FlatLRUCache.cpp"
+
+#endif  // LRU_CACHE_FLATLRUCACHE_H
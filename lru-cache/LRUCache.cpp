@@ -3,36 +3,52 @@
 
 #include "LRUCache.h"
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>::LRUCache(const std::size_t capacity) : capacity_(capacity) {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Weigher>::LRUCache(const std::size_t capacity)
+    : LRUCache(capacity, capacity) {}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Weigher>::LRUCache(const std::size_t capacity, const std::size_t max_weight,
+                                        Weigher weigher)
+    : capacity_(capacity), max_weight_(max_weight), weigher_(std::move(weigher)) {
     if (capacity_ == 0U) {
         throw std::invalid_argument("LRUCache capacity must be greater than zero");
     }
+    if (max_weight_ == 0U) {
+        throw std::invalid_argument("LRUCache max_weight must be greater than zero");
+    }
 }
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>::LRUCache(LRUCache&& other) noexcept {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Weigher>::LRUCache(LRUCache&& other) noexcept : weigher_(other.weigher_) {
     std::scoped_lock lock(other.mutex_);
     capacity_ = other.capacity_;
-    entries_ = std::move(other.entries_);
+    max_weight_ = other.max_weight_;
+    weight_ = std::exchange(other.weight_, 0U);
+    order_ = std::move(other.order_);
     index_ = std::move(other.index_);
 }
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>& LRUCache<Key, Value>::operator=(LRUCache&& other) noexcept {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Weigher>& LRUCache<Key, Value, Weigher>::operator=(LRUCache&& other) noexcept {
     if (this == &other) {
         return *this;
     }
 
     std::scoped_lock lock(mutex_, other.mutex_);
     capacity_ = other.capacity_;
-    entries_ = std::move(other.entries_);
+    max_weight_ = other.max_weight_;
+    weight_ = std::exchange(other.weight_, 0U);
+    weigher_ = other.weigher_;
+    order_ = std::move(other.order_);
     index_ = std::move(other.index_);
     return *this;
 }
 
-template <typename Key, typename Value>
-std::optional<Value> LRUCache<Key, Value>::Get(const Key& key) {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> LRUCache<Key, Value, Weigher>::Get(const K& key) {
     std::scoped_lock lock(mutex_);
 
     const auto iterator = index_.find(key);
@@ -40,51 +56,138 @@ std::optional<Value> LRUCache<Key, Value>::Get(const Key& key) {
         return std::nullopt;
     }
 
-    MoveToFront(iterator->second);
-    return iterator->second->second;
+    MoveToFront(iterator->second.position);
+    return iterator->second.value;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool LRUCache<Key, Value, Weigher>::GetWith(const K& key, Visitor&& visitor) {
+    std::scoped_lock lock(mutex_);
+
+    const auto iterator = index_.find(key);
+    if (iterator == index_.end()) {
+        return false;
+    }
+
+    MoveToFront(iterator->second.position);
+    std::invoke(visitor, std::as_const(iterator->second.value));
+    return true;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+bool LRUCache<Key, Value, Weigher>::Contains(const K& key) const {
+    std::scoped_lock lock(mutex_);
+    return index_.find(key) != index_.end();
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::Put(const Key& key, const Value& value) {
+    Emplace(key, value);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::Put(Key&& key, Value&& value) {
+    Emplace(std::move(key), std::move(value));
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::Put(const Key& key, const Value& value) {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void LRUCache<Key, Value, Weigher>::Emplace(K&& key, Args&&... args) {
     std::scoped_lock lock(mutex_);
 
     const auto found = index_.find(key);
     if (found != index_.end()) {
-        found->second->second = value;
-        MoveToFront(found->second);
+        Entry& entry = found->second;
+        AssignValue(entry.value, std::forward<Args>(args)...);
+        const std::size_t weight = weigher_(found->first, std::as_const(entry.value));
+        if (weight > max_weight_) {
+            Erase(found);
+            return;
+        }
+
+        weight_ = weight_ - entry.weight + weight;
+        entry.weight = weight;
+        MoveToFront(entry.position);
+        // The updated entry is now the most recent and fits on its own, so
+        // the loop stops before reaching it.
+        while (weight_ > max_weight_) {
+            EvictLeastRecent();
+        }
         return;
     }
 
-    entries_.emplace_front(key, value);
-    index_[key] = entries_.begin();
-
-    if (index_.size() > capacity_) {
-        const auto& lru_key = entries_.back().first;
-        index_.erase(lru_key);
-        entries_.pop_back();
+    // The key is built directly in the index node from whatever form the
+    // caller passed; try_emplace would need a ready-made Key. The node is
+    // weighed before it joins the recency list, so eviction never picks it.
+    const auto emplaced =
+        index_.emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::in_place, std::forward<Args>(args)...));
+    const auto inserted = emplaced.first;
+    try {
+        const std::size_t weight = weigher_(inserted->first, std::as_const(inserted->second.value));
+        if (weight > max_weight_) {
+            index_.erase(inserted);
+            return;
+        }
+
+        while (index_.size() > capacity_ || weight_ + weight > max_weight_) {
+            EvictLeastRecent();
+        }
+        order_.push_front(&inserted->first);
+        inserted->second.weight = weight;
+        weight_ += weight;
+    } catch (...) {
+        index_.erase(inserted);
+        throw;
     }
+    inserted->second.position = order_.begin();
 }
 
-template <typename Key, typename Value>
-std::size_t LRUCache<Key, Value>::Size() const {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+std::size_t LRUCache<Key, Value, Weigher>::Size() const {
     std::scoped_lock lock(mutex_);
     return index_.size();
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::Clear() {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+std::size_t LRUCache<Key, Value, Weigher>::WeightedSize() const {
+    std::scoped_lock lock(mutex_);
+    return weight_;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::Clear() {
     std::scoped_lock lock(mutex_);
+    order_.clear();
     index_.clear();
-    entries_.clear();
+    weight_ = 0U;
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::MoveToFront(const NodeIterator iterator) noexcept {
-    if (iterator == entries_.begin()) {
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::MoveToFront(const RecencyIterator iterator) noexcept {
+    if (iterator == order_.begin()) {
         return;
     }
 
-    entries_.splice(entries_.begin(), entries_, iterator);
+    order_.splice(order_.begin(), order_, iterator);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::EvictLeastRecent() {
+    Erase(index_.find(*order_.back()));
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Weigher>::Erase(const typename Index::iterator entry) noexcept {
+    order_.erase(entry->second.position);
+    weight_ -= entry->second.weight;
+    index_.erase(entry);
 }
 
 #endif  // LRU_CACHE_LRUCACHE_CPP
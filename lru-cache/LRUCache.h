@@ -1,21 +1,35 @@
 #ifndef LRU_CACHE_LRUCACHE_H
 #define LRU_CACHE_LRUCACHE_H
 
+#include "CacheTraits.h"
+
+#include <concepts>
 #include <cstddef>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <tuple>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
 
 // Thread-safe LRU cache using list+hash-map:
-// - list keeps recency order (front = most recently used)
-// - map stores key -> list iterator for O(1) lookup and promotion
-template <typename Key, typename Value>
+// - map owns each key once and stores its value beside a list position
+// - list keeps recency order as pointers to the map's keys (front = most
+//   recently used); unordered_map nodes never move, so the pointers stay valid
+// - capacity bounds the entry count; a weighted cache also bounds the summed
+//   Weigher(key, value) of its entries and evicts until both limits hold
+// Small trivially copyable keys select the node-free specialization in
+// SwissLRUCache.h, which has the same interface and behaviour.
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher = UnitWeigher>
 class LRUCache final {
 public:
     explicit LRUCache(std::size_t capacity);
+    // Weighted cache: at most `capacity` entries whose weights sum to at most
+    // `max_weight`. An entry heavier than `max_weight` is never stored.
+    LRUCache(std::size_t capacity, std::size_t max_weight, Weigher weigher = {});
     ~LRUCache() = default;
 
     LRUCache(const LRUCache&) = delete;
@@ -23,24 +37,72 @@ public:
     LRUCache(LRUCache&& other) noexcept;
     LRUCache& operator=(LRUCache&& other) noexcept;
 
-    [[nodiscard]] std::optional<Value> Get(const Key& key);
+    // Lookups take Key or, for std::string keys, std::string_view/const char*
+    // without allocating (see CacheTraits.h).
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    // Runs `visitor(const Value&)` on the cached value in place, under the
+    // lock, and marks the entry as used. Returns false on a miss. The visitor
+    // must not call back into the cache.
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor);
+    // Presence check that does not count as a use.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    // Inserting evicts least recently used entries until the new one fits.
+    // A value too heavy for the whole budget is dropped instead, along with
+    // any older value cached under its key; nothing else is evicted for it.
     void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    // Inserts or replaces the entry for `key` with a value constructed from
+    // `args`, like Put. A new key is copied or moved into the index once.
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
     [[nodiscard]] std::size_t Size() const;
+    // Sum of the resident entries' weights; equals Size() for UnitWeigher.
+    [[nodiscard]] std::size_t WeightedSize() const;
     void Clear();
 
 private:
-    using Node = std::pair<Key, Value>;
-    using NodeList = std::list<Node>;
-    using NodeIterator = typename NodeList::iterator;
+    using RecencyList = std::list<const Key*>;
+    using RecencyIterator = typename RecencyList::iterator;
+
+    struct Entry {
+        template <typename... Args>
+        explicit Entry(std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+
+        Value value;
+        RecencyIterator position{};
+        std::size_t weight = 0;
+    };
 
-    void MoveToFront(NodeIterator iterator) noexcept;
+    using Index = std::unordered_map<Key, Entry, KeyHash<Key>, std::equal_to<>>;
+
+    void MoveToFront(RecencyIterator iterator) noexcept;
+    void EvictLeastRecent();
+    void Erase(typename Index::iterator entry) noexcept;
 
     std::size_t capacity_;
-    NodeList entries_;
-    std::unordered_map<Key, NodeIterator> index_;
+    std::size_t max_weight_;
+    std::size_t weight_ = 0;
+    Weigher weigher_;
+    RecencyList order_;
+    Index index_;
     mutable std::mutex mutex_;
 };
 
+// Values held behind shared_ptr<const Value>: a hit copies only the handle
+// (one refcount increment) under the lock, and the caller may keep reading it
+// after the entry is evicted or overwritten.
+template <typename Key, typename Value, EntryWeigher<Key, std::shared_ptr<const Value>> Weigher = UnitWeigher>
+using SharedValueLRUCache = LRUCache<Key, std::shared_ptr<const Value>, Weigher>;
+
 #include "LRUCache.cpp"
+#include "SwissLRUCache.h"
 
 #endif  // LRU_CACHE_LRUCACHE_H
@@ -0,0 +1,537 @@
+#ifndef LRU_CACHE_SWISSLRUCACHE_CPP
+#define LRU_CACHE_SWISSLRUCACHE_CPP
+
+#include "SwissLRUCache.h"
+
+#include <algorithm>
+#include <bit>
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+LRUCache<Key, Value, Weigher>::LRUCache(const std::size_t capacity)
+    : LRUCache(capacity, capacity) {}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+LRUCache<Key, Value, Weigher>::LRUCache(const std::size_t capacity, const std::size_t max_weight,
+                                        Weigher weigher)
+    : capacity_(capacity), max_weight_(max_weight), weigher_(std::move(weigher)) {
+    if (capacity_ == 0U) {
+        throw std::invalid_argument("LRUCache capacity must be greater than zero");
+    }
+    if (max_weight_ == 0U) {
+        throw std::invalid_argument("LRUCache max_weight must be greater than zero");
+    }
+    if (capacity_ > std::numeric_limits<SlotIndex>::max() / 4U) {
+        throw std::invalid_argument("LRUCache capacity exceeds the inline table's 32-bit slot range");
+    }
+
+    slot_count_ = std::max(kGroupWidth, std::bit_ceil(capacity_ + capacity_ / 4U));
+    growth_limit_ = slot_count_ - slot_count_ / 8U;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+LRUCache<Key, Value, Weigher>::~LRUCache() {
+    DestroyAll();
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+LRUCache<Key, Value, Weigher>::LRUCache(LRUCache&& other) noexcept
+    : capacity_(0), max_weight_(0), weigher_(other.weigher_), slot_count_(0), growth_limit_(0) {
+    std::scoped_lock lock(other.mutex_);
+    TakeFrom(other);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+LRUCache<Key, Value, Weigher>& LRUCache<Key, Value, Weigher>::operator=(LRUCache&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    std::scoped_lock lock(mutex_, other.mutex_);
+    DestroyAll();
+    weigher_ = other.weigher_;
+    TakeFrom(other);
+    return *this;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> LRUCache<Key, Value, Weigher>::Get(const K& key) {
+    const Key probe(key);
+    const std::uint64_t hash = HashOf(probe);
+    std::scoped_lock lock(mutex_);
+
+    const SlotIndex slot = Find(probe, hash);
+    if (slot == kNoSlot) {
+        return std::nullopt;
+    }
+
+    MoveToFront(slot);
+    return slots_[slot].value;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool LRUCache<Key, Value, Weigher>::GetWith(const K& key, Visitor&& visitor) {
+    const Key probe(key);
+    const std::uint64_t hash = HashOf(probe);
+    std::scoped_lock lock(mutex_);
+
+    const SlotIndex slot = Find(probe, hash);
+    if (slot == kNoSlot) {
+        return false;
+    }
+
+    MoveToFront(slot);
+    std::invoke(visitor, std::as_const(slots_[slot].value));
+    return true;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+template <typename K>
+    requires LookupKey<K, Key>
+bool LRUCache<Key, Value, Weigher>::Contains(const K& key) const {
+    const Key probe(key);
+    const std::uint64_t hash = HashOf(probe);
+    std::scoped_lock lock(mutex_);
+    return Find(probe, hash) != kNoSlot;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Put(const Key& key, const Value& value) {
+    Emplace(key, value);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Put(Key&& key, Value&& value) {
+    Emplace(key, std::move(value));
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void LRUCache<Key, Value, Weigher>::Emplace(K&& key, Args&&... args) {
+    const Key inline_key(std::forward<K>(key));
+    const std::uint64_t hash = HashOf(inline_key);
+    std::scoped_lock lock(mutex_);
+
+    const SlotIndex found = Find(inline_key, hash);
+    if (found != kNoSlot) {
+        Slot& entry = slots_[found];
+        AssignValue(entry.value, std::forward<Args>(args)...);
+        const std::size_t weight = weigher_(entry.key, std::as_const(entry.value));
+        if (weight > max_weight_) {
+            Erase(found);
+            return;
+        }
+
+        weight_ = weight_ - WeightOf(entry) + weight;
+        SetWeight(entry, weight);
+        MoveToFront(found);
+        while (weight_ > max_weight_) {
+            EvictLeastRecent();
+        }
+        return;
+    }
+
+    if (!groups_) {
+        Allocate();
+    } else if (size_ + deleted_ >= growth_limit_) {
+        Rehash();
+    }
+
+    // The slot is claimed before eviction runs, so an eviction in an earlier
+    // group of this probe sequence sees it as full and leaves a tombstone.
+    const SlotIndex slot = FindFreeSlot(hash);
+    std::int8_t& ctrl = CtrlOf(slot);
+    const std::int8_t previous = ctrl;
+    Slot* const inserted = std::construct_at(&slots_[slot], inline_key, std::forward<Args>(args)...);
+    ctrl = TagOf(hash);
+    const auto release = [&]() noexcept {
+        std::destroy_at(inserted);
+        ctrl = previous;
+    };
+    try {
+        const std::size_t weight = weigher_(inserted->key, std::as_const(inserted->value));
+        if (weight > max_weight_) {
+            release();
+            return;
+        }
+
+        while (size_ >= capacity_ || weight > max_weight_ - weight_) {
+            EvictLeastRecent();
+        }
+        SetWeight(*inserted, weight);
+        weight_ += weight;
+    } catch (...) {
+        release();
+        throw;
+    }
+
+    if (previous == kDeleted) {
+        --deleted_;
+    }
+    LinkFront(slot);
+    ++size_;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::size_t LRUCache<Key, Value, Weigher>::Size() const {
+    std::scoped_lock lock(mutex_);
+    return size_;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::size_t LRUCache<Key, Value, Weigher>::WeightedSize() const {
+    std::scoped_lock lock(mutex_);
+    return weight_;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Clear() {
+    std::scoped_lock lock(mutex_);
+    DestroyAll();
+    for (std::size_t group = 0; groups_ && group < slot_count_ / kGroupWidth; ++group) {
+        groups_[group].ctrl.fill(kEmpty);
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::uint64_t LRUCache<Key, Value, Weigher>::HashOf(const Key& key) noexcept {
+    // std::hash is the identity for integers on common standard libraries;
+    // both the group index and the tag need well-mixed bits.
+    std::uint64_t hash = static_cast<std::uint64_t>(KeyHash<Key>{}(key));
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33U;
+    return hash;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::int8_t LRUCache<Key, Value, Weigher>::TagOf(const std::uint64_t hash) noexcept {
+    return static_cast<std::int8_t>(hash & 0x7FU);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::uint32_t LRUCache<Key, Value, Weigher>::Match(const Group& group, const std::int8_t ctrl) noexcept {
+#if defined(__SSE2__)
+    const __m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group.ctrl.data()));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(ctrl))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<std::uint32_t>(group.ctrl[i] == ctrl) << i;
+    }
+    return mask;
+#endif
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::uint32_t LRUCache<Key, Value, Weigher>::MatchEmptyOrDeleted(const Group& group) noexcept {
+    // kEmpty and kDeleted are the only control bytes with the sign bit set.
+#if defined(__SSE2__)
+    const __m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group.ctrl.data()));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<std::uint32_t>(group.ctrl[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::int8_t& LRUCache<Key, Value, Weigher>::CtrlOf(const SlotIndex slot) const noexcept {
+    return groups_[slot / kGroupWidth].ctrl[slot % kGroupWidth];
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+typename LRUCache<Key, Value, Weigher>::SlotIndex
+LRUCache<Key, Value, Weigher>::Find(const Key& key, const std::uint64_t hash) const noexcept {
+    if (size_ == 0U) {
+        return kNoSlot;
+    }
+
+    const std::size_t group_mask = slot_count_ / kGroupWidth - 1U;
+    const std::int8_t tag = TagOf(hash);
+    std::size_t group = (hash >> 7U) & group_mask;
+    for (std::size_t step = 1;; ++step) {
+        for (std::uint32_t matches = Match(groups_[group], tag); matches != 0U; matches &= matches - 1U) {
+            const auto slot = static_cast<SlotIndex>(group * kGroupWidth + std::countr_zero(matches));
+            if (slots_[slot].key == key) {
+                return slot;
+            }
+        }
+        // An insert only passes over full groups, so a group with an empty
+        // slot ends every probe sequence that reaches it.
+        if (Match(groups_[group], kEmpty) != 0U) {
+            return kNoSlot;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+typename LRUCache<Key, Value, Weigher>::SlotIndex
+LRUCache<Key, Value, Weigher>::FindFreeSlot(const std::uint64_t hash) const noexcept {
+    const std::size_t group_mask = slot_count_ / kGroupWidth - 1U;
+    std::size_t group = (hash >> 7U) & group_mask;
+    for (std::size_t step = 1;; ++step) {
+        const std::uint32_t free = MatchEmptyOrDeleted(groups_[group]);
+        if (free != 0U) {
+            return static_cast<SlotIndex>(group * kGroupWidth + std::countr_zero(free));
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+std::size_t LRUCache<Key, Value, Weigher>::WeightOf(const Slot& slot) const noexcept {
+    if constexpr (kUnitWeights) {
+        return 1U;
+    } else {
+        return slot.weight;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::SetWeight(Slot& slot, const std::size_t weight) noexcept {
+    if constexpr (!kUnitWeights) {
+        slot.weight = weight;
+    } else {
+        (void)slot;
+        (void)weight;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Allocate() {
+    auto groups = std::make_unique<Group[]>(slot_count_ / kGroupWidth);
+    for (std::size_t group = 0; group < slot_count_ / kGroupWidth; ++group) {
+        groups[group].ctrl.fill(kEmpty);
+    }
+    slots_ = std::unique_ptr<Slot[], SlotDeleter>(std::allocator<Slot>{}.allocate(slot_count_),
+                                                  SlotDeleter{slot_count_});
+    groups_ = std::move(groups);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Rehash() noexcept {
+    // Tombstones become empty and live slots are marked kDeleted, meaning
+    // "not placed yet". A marked entry stays if its group is the first on its
+    // probe sequence with a free slot; otherwise it moves to that free slot,
+    // or swaps with the marked entry there and is placed again. No entry
+    // lands past a group that still has a marked slot, so turning a marked
+    // slot empty never cuts a probe sequence short.
+    for (std::size_t group = 0; group < slot_count_ / kGroupWidth; ++group) {
+        for (std::int8_t& ctrl : groups_[group].ctrl) {
+            ctrl = ctrl < 0 ? kEmpty : kDeleted;
+        }
+    }
+    for (SlotIndex slot = 0; slot < slot_count_; ++slot) {
+        while (CtrlOf(slot) == kDeleted) {
+            const std::uint64_t hash = HashOf(slots_[slot].key);
+            const SlotIndex target = FindFreeSlot(hash);
+            if (target / kGroupWidth == slot / kGroupWidth) {
+                CtrlOf(slot) = TagOf(hash);
+            } else if (CtrlOf(target) == kEmpty) {
+                MoveSlot(slot, target);
+                CtrlOf(target) = TagOf(hash);
+                CtrlOf(slot) = kEmpty;
+            } else {
+                SwapSlots(slot, target);
+                CtrlOf(target) = TagOf(hash);
+            }
+        }
+    }
+    deleted_ = 0;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::MoveSlot(const SlotIndex from, const SlotIndex to) noexcept {
+    std::construct_at(&slots_[to], std::move(slots_[from]));
+    std::destroy_at(&slots_[from]);
+    Relink(to);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::SwapSlots(const SlotIndex a, const SlotIndex b) noexcept {
+    Slot held(std::move(slots_[a]));
+    std::destroy_at(&slots_[a]);
+    std::construct_at(&slots_[a], std::move(slots_[b]));
+    std::destroy_at(&slots_[b]);
+    std::construct_at(&slots_[b], std::move(held));
+
+    // Links between the two entries now point at each other's old slot.
+    const auto swapped = [a, b](const SlotIndex slot) { return slot == a ? b : slot == b ? a : slot; };
+    for (const SlotIndex slot : {a, b}) {
+        slots_[slot].prev = swapped(slots_[slot].prev);
+        slots_[slot].next = swapped(slots_[slot].next);
+    }
+    Relink(a);
+    Relink(b);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Relink(const SlotIndex slot) noexcept {
+    const Slot& entry = slots_[slot];
+    if (entry.prev != kNoSlot) {
+        slots_[entry.prev].next = slot;
+    } else {
+        head_ = slot;
+    }
+    if (entry.next != kNoSlot) {
+        slots_[entry.next].prev = slot;
+    } else {
+        tail_ = slot;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Unlink(const SlotIndex slot) noexcept {
+    Slot& entry = slots_[slot];
+    if (entry.prev != kNoSlot) {
+        slots_[entry.prev].next = entry.next;
+    } else {
+        head_ = entry.next;
+    }
+    if (entry.next != kNoSlot) {
+        slots_[entry.next].prev = entry.prev;
+    } else {
+        tail_ = entry.prev;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::LinkFront(const SlotIndex slot) noexcept {
+    Slot& entry = slots_[slot];
+    entry.prev = kNoSlot;
+    entry.next = head_;
+    if (head_ != kNoSlot) {
+        slots_[head_].prev = slot;
+    } else {
+        tail_ = slot;
+    }
+    head_ = slot;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::LinkBack(const SlotIndex slot) noexcept {
+    Slot& entry = slots_[slot];
+    entry.prev = tail_;
+    entry.next = kNoSlot;
+    if (tail_ != kNoSlot) {
+        slots_[tail_].next = slot;
+    } else {
+        head_ = slot;
+    }
+    tail_ = slot;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::MoveToFront(const SlotIndex slot) noexcept {
+    if (slot == head_) {
+        return;
+    }
+
+    Unlink(slot);
+    LinkFront(slot);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::EvictLeastRecent() noexcept {
+    Erase(tail_);
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::Erase(const SlotIndex slot) noexcept {
+    Unlink(slot);
+    weight_ -= WeightOf(slots_[slot]);
+    std::destroy_at(&slots_[slot]);
+    --size_;
+
+    // A group that already has an empty slot ends every probe reaching it, so
+    // no probe passes through it and the slot can become empty too; otherwise
+    // it must stay a tombstone so later probes keep going.
+    const SlotIndex group = slot / kGroupWidth;
+    if (Match(groups_[group], kEmpty) != 0U) {
+        CtrlOf(slot) = kEmpty;
+    } else {
+        CtrlOf(slot) = kDeleted;
+        ++deleted_;
+    }
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::DestroyAll() noexcept {
+    for (SlotIndex slot = head_; slot != kNoSlot;) {
+        const SlotIndex next = slots_[slot].next;
+        std::destroy_at(&slots_[slot]);
+        slot = next;
+    }
+    head_ = kNoSlot;
+    tail_ = kNoSlot;
+    size_ = 0;
+    deleted_ = 0;
+    weight_ = 0;
+}
+
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+void LRUCache<Key, Value, Weigher>::TakeFrom(LRUCache& other) noexcept {
+    // The moved-from cache keeps its limits and allocates a new table on its
+    // next insert.
+    capacity_ = other.capacity_;
+    max_weight_ = other.max_weight_;
+    slot_count_ = other.slot_count_;
+    growth_limit_ = other.growth_limit_;
+    weight_ = std::exchange(other.weight_, 0U);
+    groups_ = std::move(other.groups_);
+    slots_ = std::move(other.slots_);
+    size_ = std::exchange(other.size_, 0U);
+    deleted_ = std::exchange(other.deleted_, 0U);
+    head_ = std::exchange(other.head_, kNoSlot);
+    tail_ = std::exchange(other.tail_, kNoSlot);
+}
+
+#endif  // LRU_CACHE_SWISSLRUCACHE_CPP
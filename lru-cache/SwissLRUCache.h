@@ -0,0 +1,154 @@
+#ifndef LRU_CACHE_SWISSLRUCACHE_H
+#define LRU_CACHE_SWISSLRUCACHE_H
+
+#include "CacheTraits.h"
+#include "LRUCache.h"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// LRUCache for small trivially copyable keys, stored in a Swiss table:
+// - one control byte per slot, kept in 16-byte groups: kEmpty, kDeleted, or
+//   the low 7 bits of the key's hash (the tag)
+// - a lookup compares a whole group's tags with the probe tag in one SSE2
+//   compare and checks keys only where the tags match; groups are visited in
+//   triangular order until one with an empty slot
+// - key, value, weight and the 32-bit prev/next recency links share the slot,
+//   so a hit touches one control group and one slot and nothing is allocated
+//   per entry
+// - the table is allocated on the first insert, with at least 1.25 slots per
+//   entry of capacity; tombstones are dropped by an in-place rebuild once
+//   they fill the spare slots
+// Values must be nothrow move constructible, since the rebuild moves them.
+template <typename Key, typename Value, EntryWeigher<Key, Value> Weigher>
+    requires InlineKey<Key> && std::is_nothrow_move_constructible_v<Value>
+class LRUCache<Key, Value, Weigher> final {
+public:
+    explicit LRUCache(std::size_t capacity);
+    LRUCache(std::size_t capacity, std::size_t max_weight, Weigher weigher = {});
+    ~LRUCache();
+
+    LRUCache(const LRUCache&) = delete;
+    LRUCache& operator=(const LRUCache&) = delete;
+    LRUCache(LRUCache&& other) noexcept;
+    LRUCache& operator=(LRUCache&& other) noexcept;
+
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor);
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
+    [[nodiscard]] std::size_t Size() const;
+    [[nodiscard]] std::size_t WeightedSize() const;
+    void Clear();
+
+private:
+    using SlotIndex = std::uint32_t;
+
+    static constexpr SlotIndex kNoSlot = std::numeric_limits<SlotIndex>::max();
+    static constexpr std::size_t kGroupWidth = 16;
+    static constexpr std::int8_t kEmpty = -128;
+    static constexpr std::int8_t kDeleted = -2;
+    static constexpr bool kUnitWeights = std::same_as<Weigher, UnitWeigher>;
+
+    struct alignas(kGroupWidth) Group {
+        std::array<std::int8_t, kGroupWidth> ctrl;
+    };
+
+    struct NoWeight {};
+
+    struct Slot {
+        template <typename... Args>
+        explicit Slot(const Key& slot_key, Args&&... args)
+            : key(slot_key), value(std::forward<Args>(args)...) {}
+
+        Key key;
+        SlotIndex prev = kNoSlot;
+        SlotIndex next = kNoSlot;
+        // Unit-weighted caches derive every weight, so the slot has no field.
+        [[no_unique_address]] std::conditional_t<kUnitWeights, NoWeight, std::size_t> weight{};
+        Value value;
+    };
+
+    // Slots are raw storage; live ones are constructed and destroyed by hand.
+    struct SlotDeleter {
+        std::size_t count = 0;
+
+        void operator()(Slot* slots) const noexcept { std::allocator<Slot>{}.deallocate(slots, count); }
+    };
+
+    [[nodiscard]] static std::uint64_t HashOf(const Key& key) noexcept;
+    [[nodiscard]] static std::int8_t TagOf(std::uint64_t hash) noexcept;
+    // Bit i is set when control byte i of `group` equals `ctrl`.
+    [[nodiscard]] static std::uint32_t Match(const Group& group, std::int8_t ctrl) noexcept;
+    [[nodiscard]] static std::uint32_t MatchEmptyOrDeleted(const Group& group) noexcept;
+    [[nodiscard]] std::int8_t& CtrlOf(SlotIndex slot) const noexcept;
+    [[nodiscard]] SlotIndex Find(const Key& key, std::uint64_t hash) const noexcept;
+    // First empty or deleted slot on `hash`'s probe sequence.
+    [[nodiscard]] SlotIndex FindFreeSlot(std::uint64_t hash) const noexcept;
+    [[nodiscard]] std::size_t WeightOf(const Slot& slot) const noexcept;
+    void SetWeight(Slot& slot, std::size_t weight) noexcept;
+    void Allocate();
+    // Drops every tombstone without allocating: each entry moves, within the
+    // existing arrays, to the first free slot on its probe sequence.
+    void Rehash() noexcept;
+    // Moves the entry in `from` to the unused slot `to`, or swaps the entries
+    // in `a` and `b`, keeping the recency links. Control bytes are left to
+    // the caller.
+    void MoveSlot(SlotIndex from, SlotIndex to) noexcept;
+    void SwapSlots(SlotIndex a, SlotIndex b) noexcept;
+    // Points `slot`'s list neighbours (or head_/tail_) back at it.
+    void Relink(SlotIndex slot) noexcept;
+    void Unlink(SlotIndex slot) noexcept;
+    void LinkFront(SlotIndex slot) noexcept;
+    void LinkBack(SlotIndex slot) noexcept;
+    void MoveToFront(SlotIndex slot) noexcept;
+    void EvictLeastRecent() noexcept;
+    void Erase(SlotIndex slot) noexcept;
+    void DestroyAll() noexcept;
+    void TakeFrom(LRUCache& other) noexcept;
+
+    std::size_t capacity_;
+    std::size_t max_weight_;
+    std::size_t weight_ = 0;
+    Weigher weigher_;
+    std::size_t slot_count_;
+    // Most entries plus tombstones the table holds before a rebuild; always
+    // leaves one empty slot, so every probe ends.
+    std::size_t growth_limit_;
+    std::unique_ptr<Group[]> groups_;
+    std::unique_ptr<Slot[], SlotDeleter> slots_;
+    std::size_t size_ = 0;
+    std::size_t deleted_ = 0;
+    SlotIndex head_ = kNoSlot;
+    SlotIndex tail_ = kNoSlot;
+    mutable std::mutex mutex_;
+};
+
+#include "SwissLRUCache.cpp"
+
+#endif  // LRU_CACHE_SWISSLRUCACHE_H
@@ -1,12 +1,25 @@
+#include "FlatLRUCache.h"
 #include "LRUCache.h"
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstddef>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 namespace {
 
 void PrintResult(const std::string& name, const bool passed) {
@@ -96,6 +109,398 @@ bool TestConcurrentAccess() {
     return !failed.load() && cache.Size() <= static_cast<std::size_t>(kThreads * kKeysPerThread);
 }
 
+bool TestFlatCapacityValidation() {
+    try {
+        FlatLRUCache<int, int> cache(0);
+        (void)cache;
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+
+    return false;
+}
+
+bool TestFlatBasicPutGetAndEviction() {
+    FlatLRUCache<int, std::string> cache(2);
+    cache.Put(1, "one");
+    cache.Put(2, "two");
+
+    const auto one = cache.Get(1);
+    if (!one.has_value() || one.value() != "one") {
+        return false;
+    }
+
+    cache.Put(3, "three");
+    cache.Put(3, "three-updated");
+
+    const auto two = cache.Get(2);
+    const auto three = cache.Get(3);
+    return !two.has_value() && three.has_value() && three.value() == "three-updated" &&
+           cache.Size() == 2 && cache.Get(1).has_value();
+}
+
+bool TestFlatMatchesListCache() {
+    // Random churn over a key space larger than capacity exercises slot
+    // recycling and backward-shift deletion. The oracle is the node-based
+    // cache: int keys would select the Swiss-table specialization, so the
+    // reference spells them as strings.
+    constexpr std::size_t kCapacity = 64;
+    constexpr int kKeySpace = 200;
+    constexpr int kOperations = 50000;
+
+    FlatLRUCache<int, int> flat(kCapacity);
+    LRUCache<std::string, int> reference(kCapacity);
+    std::mt19937 generator(7U);
+    std::uniform_int_distribution<int> key_distribution(0, kKeySpace - 1);
+
+    for (int i = 0; i < kOperations; ++i) {
+        const int key = key_distribution(generator);
+        if ((generator() & 1U) == 0U) {
+            flat.Put(key, i);
+            reference.Put(std::to_string(key), i);
+        } else if (flat.Get(key) != reference.Get(std::to_string(key))) {
+            return false;
+        }
+    }
+
+    if (flat.Size() != reference.Size()) {
+        return false;
+    }
+
+    flat.Clear();
+    return flat.Size() == 0 && !flat.Get(0).has_value();
+}
+
+bool TestFlatConcurrentAccess() {
+    constexpr int kThreads = 8;
+    constexpr int kOpsPerThread = 5000;
+    constexpr int kKeysPerThread = 16;
+    constexpr std::size_t kCapacity = 256;
+
+    FlatLRUCache<int, int> cache(kCapacity);
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    workers.reserve(kThreads);
+
+    for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
+        workers.emplace_back([thread_id, &cache, &failed]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = (thread_id * kKeysPerThread) + (i % kKeysPerThread);
+                cache.Put(key, i);
+                if (!cache.Get(key).has_value()) {
+                    failed.store(true);
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return !failed.load() && cache.Size() <= static_cast<std::size_t>(kThreads * kKeysPerThread);
+}
+
+struct ThrowingValue {
+    static inline bool fail = false;
+
+    ThrowingValue() = default;
+    explicit ThrowingValue(const int payload) : value(payload) {}
+    ThrowingValue(const ThrowingValue& other) = default;
+    ThrowingValue& operator=(const ThrowingValue& other) {
+        if (fail) {
+            throw std::runtime_error("assignment failed");
+        }
+        value = other.value;
+        return *this;
+    }
+
+    int value = 0;
+};
+
+bool TestFlatEmplaceThrowKeepsSlots() {
+    // A failed Put into a full cache evicts its victim and frees the slot,
+    // which later Puts, failed or not, must be able to claim.
+    FlatLRUCache<int, ThrowingValue> cache(3);
+    const ThrowingValue payload(1);
+    cache.Put(1, payload);
+    cache.Put(2, payload);
+    cache.Put(3, payload);
+
+    int thrown = 0;
+    ThrowingValue::fail = true;
+    for (int key = 10; key < 20; ++key) {
+        try {
+            cache.Put(key, payload);
+        } catch (const std::runtime_error&) {
+            ++thrown;
+        }
+    }
+    ThrowingValue::fail = false;
+    if (thrown != 10 || cache.Size() != 2U || cache.Get(1).has_value() || !cache.Get(2).has_value() ||
+        cache.Get(10).has_value()) {
+        return false;
+    }
+
+    for (int key = 20; key < 25; ++key) {
+        cache.Put(key, ThrowingValue(key));
+    }
+    const auto newest = cache.Get(24);
+    return cache.Size() == 3U && !cache.Get(21).has_value() && cache.Get(22).has_value() &&
+           newest.has_value() && newest->value == 24;
+}
+
+struct CopyCountingValue {
+    static inline int copies = 0;
+
+    CopyCountingValue() = default;
+    explicit CopyCountingValue(const int payload) : value(payload) {}
+    CopyCountingValue(const CopyCountingValue& other) : value(other.value) { ++copies; }
+    CopyCountingValue& operator=(const CopyCountingValue& other) {
+        value = other.value;
+        ++copies;
+        return *this;
+    }
+
+    int value = 0;
+};
+
+template <typename Cache>
+bool TestGetWithVisitsInPlace() {
+    Cache cache(2);
+    cache.Put(1, CopyCountingValue(10));
+    cache.Put(2, CopyCountingValue(20));
+
+    CopyCountingValue::copies = 0;
+    int seen = 0;
+    const bool hit =
+        cache.GetWith(1, [&seen](const CopyCountingValue& value) { seen = value.value; });
+    const bool miss = cache.GetWith(3, [&seen](const CopyCountingValue&) { seen = -1; });
+    if (!hit || miss || seen != 10 || CopyCountingValue::copies != 0) {
+        return false;
+    }
+
+    // GetWith counts as a use, so key 2 is now the eviction victim.
+    cache.Put(3, CopyCountingValue(30));
+    return cache.GetWith(1, [](const CopyCountingValue&) {}) &&
+           !cache.GetWith(2, [](const CopyCountingValue&) {});
+}
+
+template <typename Cache>
+bool TestSharedValuesOutliveEviction() {
+    Cache cache(1);
+    cache.Put(1, std::make_shared<const std::string>(4096, 'a'));
+
+    const auto held = cache.Get(1);
+    cache.Put(2, std::make_shared<const std::string>(4096, 'b'));
+
+    // Key 1 was evicted, but the handle returned by Get still owns the value.
+    return held.has_value() && held.value()->size() == 4096U && held.value()->front() == 'a' &&
+           held.value().use_count() == 1 && !cache.Get(1).has_value();
+}
+
+template <template <typename, typename> typename Cache>
+bool TestMoveAndHeterogeneousLookup() {
+    // Move-only values can only get in through the rvalue Put or Emplace.
+    Cache<std::string, std::unique_ptr<int>> owners(2);
+    std::string key = "https://example.com/a";
+    owners.Put(std::move(key), std::make_unique<int>(7));
+    owners.Emplace(std::string_view("https://example.com/b"), new int(8));
+
+    int seen = 0;
+    const bool found = owners.GetWith(std::string_view("https://example.com/a"),
+                                      [&seen](const std::unique_ptr<int>& value) { seen = *value; });
+    if (!found || seen != 7 || !owners.Contains("https://example.com/b")) {
+        return false;
+    }
+
+    Cache<std::string, std::string> strings(2);
+    strings.Emplace("a", 3U, 'x');
+    strings.Put("b", "bee");
+    const auto a = strings.Get(std::string_view("a"));
+    if (!a.has_value() || a.value() != "xxx") {
+        return false;
+    }
+
+    // Contains is not a use: "a" was just read, so "b" is evicted even
+    // though it was checked more recently.
+    (void)strings.Contains("b");
+    strings.Put("c", "sea");
+    return !strings.Contains("b") && strings.Contains("a") && strings.Size() == 2U;
+}
+
+struct StringBytes {
+    std::size_t operator()(const int&, const std::string& value) const noexcept {
+        return value.size();
+    }
+};
+
+bool TestWeightedEviction() {
+    try {
+        LRUCache<int, std::string, StringBytes> invalid(4, 0);
+        (void)invalid;
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    // Up to 100 entries, but only 10 bytes.
+    LRUCache<int, std::string, StringBytes> cache(100, 10);
+    cache.Put(1, "aaaa");
+    cache.Put(2, "bbbb");
+    (void)cache.Get(1);
+    // 6 more bytes: evicting key 2 alone is enough.
+    cache.Put(3, "cccccc");
+    if (cache.Contains(2) || !cache.Contains(1) || cache.WeightedSize() != 10U) {
+        return false;
+    }
+
+    // Growing an entry evicts others until it fits; shrinking frees bytes.
+    cache.Put(3, "ccccccccc");
+    if (cache.Contains(1) || cache.WeightedSize() != 9U || cache.Size() != 1U) {
+        return false;
+    }
+    cache.Put(3, "c");
+    cache.Put(4, "dd");
+
+    // An entry over the whole budget is dropped along with its older value,
+    // and nothing else is evicted for it.
+    cache.Put(4, std::string(11, 'x'));
+    cache.Put(5, std::string(11, 'x'));
+    return !cache.Contains(4) && !cache.Contains(5) && cache.Get(3) == "c" &&
+           cache.WeightedSize() == 1U && cache.Size() == 1U;
+}
+
+struct ValueBytes {
+    template <typename Key>
+    std::size_t operator()(const Key&, const std::string& value) const noexcept {
+        return value.size();
+    }
+};
+
+bool TestInlineKeysMatchNodeCache() {
+    // int keys select the Swiss-table specialization; the same keys spelled as
+    // strings go through the node-based cache, which serves as the oracle.
+    // The key space is much larger than the capacity, so tombstones pile up
+    // and force several in-place rebuilds.
+    constexpr std::size_t kCapacity = 400;
+    constexpr int kKeySpace = 4000;
+    constexpr int kOperations = 200000;
+
+    LRUCache<int, std::string, ValueBytes> swiss(kCapacity, 6000);
+    LRUCache<std::string, std::string, ValueBytes> reference(kCapacity, 6000);
+    std::mt19937 generator(11U);
+    std::uniform_int_distribution<int> key_distribution(0, kKeySpace - 1);
+    std::uniform_int_distribution<std::size_t> length_distribution(0, 24);
+
+    for (int i = 0; i < kOperations; ++i) {
+        const int key = key_distribution(generator);
+        const std::uint32_t action = generator() % 8U;
+        if (action < 3U) {
+            const std::string value(length_distribution(generator), static_cast<char>('a' + i % 26));
+            swiss.Put(key, value);
+            reference.Put(std::to_string(key), value);
+        } else if (action < 7U) {
+            if (swiss.Get(key) != reference.Get(std::to_string(key))) {
+                return false;
+            }
+        } else if (swiss.Contains(key) != reference.Contains(std::to_string(key))) {
+            return false;
+        }
+        if (i % 50000 == 49999) {
+            swiss.Clear();
+            reference.Clear();
+        }
+    }
+
+    if (swiss.Size() != reference.Size() || swiss.WeightedSize() != reference.WeightedSize()) {
+        return false;
+    }
+
+    // A moved-from cache is empty but still usable.
+    LRUCache<int, std::string, ValueBytes> moved(std::move(swiss));
+    swiss.Put(1, "one");
+    return moved.Size() == reference.Size() && swiss.Get(1) == "one" && swiss.Size() == 1U;
+}
+
+// Boxes a 64-bit key behind a transparent hash, which keeps it out of the
+// Swiss-table specialization, so both layouts can run the same workload.
+struct NodeKey {
+    std::uint64_t value = 0;
+
+    bool operator==(const NodeKey&) const = default;
+};
+
+}  // namespace
+
+template <>
+struct KeyHash<NodeKey> {
+    using is_transparent = void;
+
+    [[nodiscard]] std::size_t operator()(const NodeKey& key) const noexcept {
+        return std::hash<std::uint64_t>{}(key.value);
+    }
+};
+
+namespace {
+
+// Bytes the allocator has handed out and not yet taken back; zero where
+// glibc's mallinfo2 is unavailable.
+std::size_t HeapBytesInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    // Large blocks are mapped separately and counted apart.
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0U;
+#endif
+}
+
+template <typename Cache, typename MakeKey>
+std::pair<double, double> MeasureInlineKeyCache(MakeKey make_key) {
+    // Fills the cache, then runs 90% Gets and 10% Puts over twice as many
+    // keys as it holds. Returns M ops/s and heap bytes per entry.
+    constexpr std::size_t kCapacity = 1U << 16U;
+    constexpr std::size_t kOperations = 4'000'000;
+
+    const std::size_t heap_before = HeapBytesInUse();
+    auto cache = std::make_unique<Cache>(kCapacity);
+    for (std::uint64_t key = 0; key < kCapacity; ++key) {
+        cache->Put(make_key(key), key);
+    }
+    const std::size_t heap_after = HeapBytesInUse();
+
+    std::mt19937_64 generator(5U);
+    std::uint64_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kOperations; ++i) {
+        const std::uint64_t random = generator();
+        const std::uint64_t key = random % (2U * kCapacity);
+        if (random % 10U == 0U) {
+            cache->Put(make_key(key), key);
+        } else {
+            hits += cache->Get(make_key(key)).has_value() ? 1U : 0U;
+        }
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (hits == 0U) {
+        std::cout << "[WARN] Benchmark: no hits\n";
+    }
+    return {static_cast<double>(kOperations) / elapsed_s / 1e6,
+            static_cast<double>(heap_after - heap_before) / static_cast<double>(kCapacity)};
+}
+
+void RunInlineKeyBenchmark() {
+    const auto swiss = MeasureInlineKeyCache<LRUCache<std::uint64_t, std::uint64_t>>(
+        [](const std::uint64_t key) { return key; });
+    const auto node = MeasureInlineKeyCache<LRUCache<NodeKey, std::uint64_t>>(
+        [](const std::uint64_t key) { return NodeKey{key}; });
+    std::cout << "[INFO] Benchmark: 65536 uint64_t entries, 90% Get, Swiss table " << std::fixed
+              << std::setprecision(2) << swiss.first << " M ops/s (" << std::setprecision(0) << swiss.second
+              << " heap bytes/entry), node-based " << std::setprecision(2) << node.first << " M ops/s ("
+              << std::setprecision(0) << node.second << " heap bytes/entry)\n";
+}
+
 }  // namespace
 
 int main() {
@@ -104,5 +509,24 @@ int main() {
     PrintResult("Duplicate put updates existing entry", TestDuplicatePutUpdatesValue());
     PrintResult("Clear resets cache state", TestClearAndSize());
     PrintResult("Concurrent access stress", TestConcurrentAccess());
+    PrintResult("Flat: capacity=0 throws", TestFlatCapacityValidation());
+    PrintResult("Flat: basic put/get/eviction", TestFlatBasicPutGetAndEviction());
+    PrintResult("Flat: matches list-based cache under churn", TestFlatMatchesListCache());
+    PrintResult("Flat: concurrent access stress", TestFlatConcurrentAccess());
+    PrintResult("Flat: failed Put keeps every slot usable", TestFlatEmplaceThrowKeepsSlots());
+    PrintResult("GetWith visits value in place",
+                TestGetWithVisitsInPlace<LRUCache<int, CopyCountingValue>>());
+    PrintResult("Flat: GetWith visits value in place",
+                TestGetWithVisitsInPlace<FlatLRUCache<int, CopyCountingValue>>());
+    PrintResult("Shared values outlive eviction",
+                TestSharedValuesOutliveEviction<SharedValueLRUCache<int, std::string>>());
+    PrintResult("Flat: shared values outlive eviction",
+                TestSharedValuesOutliveEviction<SharedValueFlatLRUCache<int, std::string>>());
+    PrintResult("Move-only values and string_view lookups", TestMoveAndHeterogeneousLookup<LRUCache>());
+    PrintResult("Flat: move-only values and string_view lookups",
+                TestMoveAndHeterogeneousLookup<FlatLRUCache>());
+    PrintResult("Weighted capacity evicts to the byte budget", TestWeightedEviction());
+    PrintResult("Inline keys match node-based cache under churn", TestInlineKeysMatchNodeCache());
+    RunInlineKeyBenchmark();
     return 0;
 }
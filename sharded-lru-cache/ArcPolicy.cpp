@@ -0,0 +1,104 @@
+#ifndef SHARDED_LRU_CACHE_ARCPOLICY_CPP
+#define SHARDED_LRU_CACHE_ARCPOLICY_CPP
+
+#include "ArcPolicy.h"
+
+#include <algorithm>
+
+template <typename Key>
+ArcPolicy<Key>::ArcPolicy(const std::size_t capacity)
+    : capacity_(capacity), recent_ghosts_(capacity), frequent_ghosts_(capacity) {}
+
+template <typename Key>
+typename ArcPolicy<Key>::Handle ArcPolicy<Key>::OnInsert(const Key& key) {
+    if (recent_ghosts_.Contains(key)) {
+        const std::size_t step =
+            std::max<std::size_t>(1U, frequent_ghosts_.Size() / recent_ghosts_.Size());
+        target_recent_ = std::min(capacity_, target_recent_ + step);
+        recent_ghosts_.Erase(key);
+        frequent_.push_front(Node{&key, true});
+        TrimGhosts();
+        return frequent_.begin();
+    }
+
+    if (frequent_ghosts_.Contains(key)) {
+        const std::size_t step =
+            std::max<std::size_t>(1U, recent_ghosts_.Size() / frequent_ghosts_.Size());
+        target_recent_ -= std::min(target_recent_, step);
+        frequent_ghosts_.Erase(key);
+        frequent_.push_front(Node{&key, true});
+        TrimGhosts();
+        return frequent_.begin();
+    }
+
+    recent_.push_front(Node{&key, false});
+    TrimGhosts();
+    return recent_.begin();
+}
+
+template <typename Key>
+void ArcPolicy<Key>::OnAccess(const Handle handle) noexcept {
+    if (handle->frequent) {
+        frequent_.splice(frequent_.begin(), frequent_, handle);
+        return;
+    }
+
+    handle->frequent = true;
+    frequent_.splice(frequent_.begin(), recent_, handle);
+}
+
+template <typename Key>
+const Key& ArcPolicy<Key>::Victim() const noexcept {
+    if (!recent_.empty() && (recent_.size() > target_recent_ || frequent_.empty())) {
+        return *recent_.back().key;
+    }
+
+    return *frequent_.back().key;
+}
+
+template <typename Key>
+void ArcPolicy<Key>::OnEvict(const Handle handle) {
+    if (handle->frequent) {
+        frequent_ghosts_.Push(*handle->key);
+        frequent_.erase(handle);
+    } else {
+        recent_ghosts_.Push(*handle->key);
+        recent_.erase(handle);
+    }
+}
+
+template <typename Key>
+void ArcPolicy<Key>::OnRemove(const Handle handle) noexcept {
+    if (handle->frequent) {
+        frequent_.erase(handle);
+    } else {
+        recent_.erase(handle);
+    }
+}
+
+template <typename Key>
+void ArcPolicy<Key>::Clear() noexcept {
+    target_recent_ = 0;
+    recent_.clear();
+    frequent_.clear();
+    recent_ghosts_.Clear();
+    frequent_ghosts_.Clear();
+}
+
+template <typename Key>
+void ArcPolicy<Key>::TrimGhosts() noexcept {
+    // ARC's directory invariants: |T1| + |B1| <= c and the whole directory
+    // (T1 + T2 + B1 + B2) tracks at most 2c keys. Ghosts are trimmed after the
+    // incoming key has been checked against them (see GhostList.h).
+    while (recent_ghosts_.Size() > 0U && recent_.size() + recent_ghosts_.Size() > capacity_) {
+        recent_ghosts_.PopOldest();
+    }
+
+    const std::size_t resident = recent_.size() + frequent_.size();
+    while (frequent_ghosts_.Size() > 0U &&
+           resident + recent_ghosts_.Size() + frequent_ghosts_.Size() > 2U * capacity_) {
+        frequent_ghosts_.PopOldest();
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_ARCPOLICY_CPP
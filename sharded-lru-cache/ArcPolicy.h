@@ -0,0 +1,47 @@
+#ifndef SHARDED_LRU_CACHE_ARCPOLICY_H
+#define SHARDED_LRU_CACHE_ARCPOLICY_H
+
+#include "GhostList.h"
+
+#include <cstddef>
+#include <list>
+
+// Adaptive Replacement Cache (Megiddo & Modha):
+// - T1 holds keys seen once recently, T2 keys seen at least twice.
+// - B1/B2 are ghosts of keys evicted from T1/T2.
+// - target_recent_ (p) is the adaptive T1 size: a B1 hit grows it and a B2
+//   hit shrinks it, so the split follows whichever list is missing hits.
+template <typename Key>
+class ArcPolicy final {
+private:
+    struct Node {
+        const Key* key;
+        bool frequent;
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    explicit ArcPolicy(std::size_t capacity);
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) noexcept;
+    [[nodiscard]] const Key& Victim() const noexcept;
+    void OnEvict(Handle handle);
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+
+private:
+    void TrimGhosts() noexcept;
+
+    std::size_t capacity_;
+    std::size_t target_recent_ = 0;
+    std::list<Node> recent_;
+    std::list<Node> frequent_;
+    GhostList<Key> recent_ghosts_;
+    GhostList<Key> frequent_ghosts_;
+};
+
+#include "ArcPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_ARCPOLICY_H
@@ -0,0 +1,131 @@
+#ifndef SHARDED_LRU_CACHE_BENCHMARKHARNESS_CPP
+#define SHARDED_LRU_CACHE_BENCHMARKHARNESS_CPP
+
+#include "BenchmarkHarness.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <latch>
+#include <memory>
+#include <thread>
+
+template <BenchmarkCache Cache>
+WorkloadResult RunWorkload(Cache& cache, const std::string& cache_name, const Workload& workload,
+                           const WorkloadRunOptions& options) {
+    const std::size_t threads = std::max<std::size_t>(1U, options.threads);
+    const auto apply = [&cache](const Operation& operation) {
+        if (operation.write) {
+            cache.Put(operation.key, operation.key);
+            return false;
+        }
+        if (cache.Get(operation.key).has_value()) {
+            return true;
+        }
+        cache.Put(operation.key, operation.key);
+        return false;
+    };
+
+    WorkloadGenerator warmup(workload, 0U, 1U, options.seed + 1U);
+    for (std::size_t i = 0; i < options.warmup_operations; ++i) {
+        (void)apply(warmup.Next());
+    }
+
+    // Heap-allocated: the histogram is several kilobytes of atomics.
+    const auto latency = std::make_unique<LatencyHistogram>();
+    std::atomic<std::uint64_t> reads{0};
+    std::atomic<std::uint64_t> hits{0};
+    std::latch ready(static_cast<std::ptrdiff_t>(threads + 1U));
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t thread_index = 0; thread_index < threads; ++thread_index) {
+        workers.emplace_back([&, thread_index]() {
+            WorkloadGenerator generator(workload, thread_index, threads, options.seed);
+            std::uint64_t local_reads = 0;
+            std::uint64_t local_hits = 0;
+            std::size_t until_sample = options.latency_sample_interval;
+            ready.arrive_and_wait();
+
+            for (std::size_t i = 0; i < options.operations_per_thread; ++i) {
+                const Operation operation = generator.Next();
+                local_reads += operation.write ? 0U : 1U;
+                if (until_sample == 0U || --until_sample != 0U) {
+                    local_hits += apply(operation) ? 1U : 0U;
+                    continue;
+                }
+
+                until_sample = options.latency_sample_interval;
+                const auto started = std::chrono::steady_clock::now();
+                local_hits += apply(operation) ? 1U : 0U;
+                latency->Record(std::chrono::steady_clock::now() - started);
+            }
+            reads.fetch_add(local_reads, std::memory_order_relaxed);
+            hits.fetch_add(local_hits, std::memory_order_relaxed);
+        });
+    }
+
+    ready.arrive_and_wait();
+    const auto started = std::chrono::steady_clock::now();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    WorkloadResult result;
+    result.cache = cache_name;
+    result.workload = workload.Name();
+    result.threads = threads;
+    result.read_ratio = workload.Spec().read_ratio;
+    result.operations = static_cast<std::uint64_t>(threads * options.operations_per_thread);
+    result.seconds = elapsed.count();
+    result.ops_per_second =
+        result.seconds > 0.0 ? static_cast<double>(result.operations) / result.seconds : 0.0;
+    const std::uint64_t total_reads = reads.load(std::memory_order_relaxed);
+    result.hit_ratio = total_reads == 0U ? 0.0
+                                         : static_cast<double>(hits.load(std::memory_order_relaxed)) /
+                                               static_cast<double>(total_reads);
+    const LatencySnapshot snapshot = latency->Snapshot();
+    result.p50 = snapshot.Percentile(50.0);
+    result.p99 = snapshot.Percentile(99.0);
+    result.p999 = snapshot.Percentile(99.9);
+    return result;
+}
+
+inline void WriteJsonString(std::ostream& output, const std::string& text) {
+    output << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            output << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20U) {
+            output << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                   << static_cast<int>(static_cast<unsigned char>(c)) << std::dec << std::setfill(' ');
+        } else {
+            output << c;
+        }
+    }
+    output << '"';
+}
+
+inline void WriteJson(std::ostream& output, const std::vector<WorkloadResult>& results) {
+    const std::ios_base::fmtflags flags = output.flags();
+    const std::streamsize precision = output.precision();
+    output << std::setprecision(6) << "{\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const WorkloadResult& result = results[i];
+        output << (i == 0U ? "\n" : ",\n") << "    {\"cache\": ";
+        WriteJsonString(output, result.cache);
+        output << ", \"workload\": ";
+        WriteJsonString(output, result.workload);
+        output << ", \"threads\": " << result.threads << ", \"read_ratio\": " << result.read_ratio
+               << ", \"operations\": " << result.operations << ", \"seconds\": " << result.seconds
+               << ", \"ops_per_second\": " << std::fixed << std::setprecision(0) << result.ops_per_second
+               << std::defaultfloat << std::setprecision(6) << ", \"hit_ratio\": " << result.hit_ratio
+               << ", \"latency_ns\": {\"p50\": " << result.p50.count() << ", \"p99\": " << result.p99.count()
+               << ", \"p999\": " << result.p999.count() << "}}";
+    }
+    output << (results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    output.flags(flags);
+    output.precision(precision);
+}
+
+#endif  // SHARDED_LRU_CACHE_BENCHMARKHARNESS_CPP
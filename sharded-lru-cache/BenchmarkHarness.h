@@ -0,0 +1,64 @@
+#ifndef SHARDED_LRU_CACHE_BENCHMARKHARNESS_H
+#define SHARDED_LRU_CACHE_BENCHMARKHARNESS_H
+
+#include "CacheMetrics.h"
+#include "Workload.h"
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Any cache the harness can drive: uint64 keys and values, Get and Put.
+template <typename Cache>
+concept BenchmarkCache = requires(Cache& cache, const std::uint64_t key) {
+    { cache.Get(key) } -> std::convertible_to<std::optional<std::uint64_t>>;
+    cache.Put(key, key);
+};
+
+struct WorkloadRunOptions {
+    std::size_t threads = 1;
+    std::size_t operations_per_thread = 100'000;
+    // Single-threaded operations run before timing starts, so the measured
+    // run does not begin on an empty cache.
+    std::size_t warmup_operations = 100'000;
+    // One operation in this many per thread is timed individually; zero
+    // turns latency sampling off.
+    std::size_t latency_sample_interval = 16;
+    std::uint64_t seed = 1;
+};
+
+struct WorkloadResult {
+    std::string cache;
+    std::string workload;
+    std::size_t threads = 0;
+    double read_ratio = 0.0;
+    std::uint64_t operations = 0;
+    double seconds = 0.0;
+    double ops_per_second = 0.0;
+    // Read hits over reads.
+    double hit_ratio = 0.0;
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds p999{0};
+};
+
+// Runs `workload` against `cache` from `options.threads` threads that start
+// together. Reads that miss are filled with a Put (read-through), so the
+// hit ratio reflects the cache's policy and not just the write mix. Writes
+// are plain Puts. Latency covers the whole operation, including the fill.
+template <BenchmarkCache Cache>
+[[nodiscard]] WorkloadResult RunWorkload(Cache& cache, const std::string& cache_name,
+                                         const Workload& workload, const WorkloadRunOptions& options);
+
+// Writes `results` as a JSON object {"results": [...]}, one object per run
+// with latencies in nanoseconds.
+void WriteJson(std::ostream& output, const std::vector<WorkloadResult>& results);
+
+#include "BenchmarkHarness.cpp"
+
+#endif  // SHARDED_LRU_CACHE_BENCHMARKHARNESS_H
@@ -0,0 +1,81 @@
+#ifndef SHARDED_LRU_CACHE_BUFFEREDPOLICY_CPP
+#define SHARDED_LRU_CACHE_BUFFEREDPOLICY_CPP
+
+#include "BufferedPolicy.h"
+
+#include <utility>
+
+template <typename Key, EvictionPolicy<Key> Inner>
+BufferedPolicy<Key, Inner>::BufferedPolicy(const std::size_t capacity) : inner_(capacity) {}
+
+// Pending hits are replayed before the inner policy changes hands; the ring
+// itself is not movable.
+template <typename Key, EvictionPolicy<Key> Inner>
+BufferedPolicy<Key, Inner>::BufferedPolicy(BufferedPolicy&& other) noexcept
+    : inner_((other.Drain(), std::move(other.inner_))) {}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+BufferedPolicy<Key, Inner>& BufferedPolicy<Key, Inner>::operator=(BufferedPolicy&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    other.Drain();
+    reads_.Discard();
+    inner_ = std::move(other.inner_);
+    return *this;
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+typename BufferedPolicy<Key, Inner>::Handle BufferedPolicy<Key, Inner>::OnInsert(const Key& key) {
+    return inner_.OnInsert(key);
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+void BufferedPolicy<Key, Inner>::OnAccess(const Handle handle) const noexcept {
+    (void)reads_.TryPush(handle);
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+const Key& BufferedPolicy<Key, Inner>::Victim() {
+    Drain();
+    return inner_.Victim();
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+void BufferedPolicy<Key, Inner>::OnEvict(const Handle handle) {
+    Drain();
+    inner_.OnEvict(handle);
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+void BufferedPolicy<Key, Inner>::OnRemove(const Handle handle) {
+    Drain();
+    inner_.OnRemove(handle);
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+void BufferedPolicy<Key, Inner>::Clear() noexcept {
+    reads_.Discard();
+    inner_.Clear();
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+bool BufferedPolicy<Key, Inner>::NeedsDrain() const noexcept {
+    return reads_.Pending() >= kDrainThreshold;
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+void BufferedPolicy<Key, Inner>::Drain() {
+    reads_.Drain([this](const Handle handle) { inner_.OnAccess(handle); });
+}
+
+template <typename Key, EvictionPolicy<Key> Inner>
+template <typename Visitor>
+void BufferedPolicy<Key, Inner>::ForEachColdestFirst(Visitor&& visitor) const
+    requires OrderedPolicy<Inner, Key>
+{
+    inner_.ForEachColdestFirst(visitor);
+}
+
+#endif  // SHARDED_LRU_CACHE_BUFFEREDPOLICY_CPP
@@ -0,0 +1,53 @@
+#ifndef SHARDED_LRU_CACHE_BUFFEREDPOLICY_H
+#define SHARDED_LRU_CACHE_BUFFEREDPOLICY_H
+
+#include "EvictionPolicy.h"
+#include "LruPolicy.h"
+#include "ReadBuffer.h"
+
+#include <cstddef>
+
+// Adapter that defers an inner policy's hit bookkeeping (BP-Wrapper style).
+// - OnAccess only records the handle in a lossy ring buffer, so it is safe to
+//   call concurrently and ShardedLRUCache serves Get under a shared lock.
+// - Recorded hits are replayed into the inner policy in one batch, either by a
+//   reader that wins a try_lock once NeedsDrain() reports a full batch, or
+//   before any operation that could evict or reorder (so buffered handles are
+//   never stale when replayed).
+// Hits dropped when the ring is full only cost recency precision.
+template <typename Key, EvictionPolicy<Key> Inner = LruPolicy<Key>>
+class BufferedPolicy final {
+public:
+    using Handle = typename Inner::Handle;
+
+    static constexpr bool kConcurrentAccess = true;
+
+    explicit BufferedPolicy(std::size_t capacity);
+    BufferedPolicy(BufferedPolicy&& other) noexcept;
+    BufferedPolicy& operator=(BufferedPolicy&& other) noexcept;
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) const noexcept;
+    [[nodiscard]] const Key& Victim();
+    void OnEvict(Handle handle);
+    void OnRemove(Handle handle);
+    void Clear() noexcept;
+
+    [[nodiscard]] bool NeedsDrain() const noexcept;
+    void Drain();
+    // The inner policy's order; hits still in the ring are not reflected.
+    template <typename Visitor>
+    void ForEachColdestFirst(Visitor&& visitor) const
+        requires OrderedPolicy<Inner, Key>;
+
+private:
+    static constexpr std::size_t kBufferSize = 128;
+    static constexpr std::size_t kDrainThreshold = kBufferSize / 2U;
+
+    Inner inner_;
+    mutable ReadBuffer<Handle, kBufferSize> reads_;
+};
+
+#include "BufferedPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_BUFFEREDPOLICY_H
@@ -0,0 +1,125 @@
+#ifndef SHARDED_LRU_CACHE_CACHEMETRICS_CPP
+#define SHARDED_LRU_CACHE_CACHEMETRICS_CPP
+
+#include "CacheMetrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+inline double ShardStats::HitRatio() const noexcept {
+    const std::uint64_t lookups = hits + misses;
+    return lookups == 0U ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+inline ShardStats& ShardStats::operator+=(const ShardStats& other) noexcept {
+    hits += other.hits;
+    misses += other.misses;
+    puts += other.puts;
+    evictions += other.evictions;
+    contended_locks += other.contended_locks;
+    lock_wait += other.lock_wait;
+    return *this;
+}
+
+inline ShardStats ShardCounters::Read() const noexcept {
+    ShardStats stats;
+    stats.hits = hits.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.puts = puts.load(std::memory_order_relaxed);
+    stats.evictions = evictions.load(std::memory_order_relaxed);
+    stats.contended_locks = contended_locks.load(std::memory_order_relaxed);
+    stats.lock_wait = std::chrono::nanoseconds(lock_wait_ns.load(std::memory_order_relaxed));
+    return stats;
+}
+
+inline std::chrono::nanoseconds LatencySnapshot::Percentile(const double percentile) const {
+    if (count == 0U) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const auto rank = std::max<std::uint64_t>(
+        1U, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(count))));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            return std::chrono::nanoseconds(LatencyHistogram::UpperBound(bucket));
+        }
+    }
+    return std::chrono::nanoseconds(LatencyHistogram::UpperBound(buckets.size() - 1U));
+}
+
+inline void LatencyHistogram::Record(const std::chrono::nanoseconds latency) noexcept {
+    const auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(0, latency.count()));
+    counts_[BucketOf(nanoseconds)].fetch_add(1U, std::memory_order_relaxed);
+}
+
+inline LatencySnapshot LatencyHistogram::Snapshot() const {
+    LatencySnapshot snapshot;
+    snapshot.buckets.resize(kBucketCount);
+    for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+        snapshot.buckets[bucket] = counts_[bucket].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.buckets[bucket];
+    }
+    return snapshot;
+}
+
+inline std::size_t LatencyHistogram::BucketOf(const std::uint64_t nanoseconds) noexcept {
+    if (nanoseconds < kSubBuckets) {
+        return static_cast<std::size_t>(nanoseconds);
+    }
+
+    // The top kSubBucketBits + 1 bits select the bucket: the leading one
+    // picks the magnitude, the bits after it the sub-bucket.
+    const auto shift = static_cast<std::size_t>(std::bit_width(nanoseconds)) - kSubBucketBits - 1U;
+    if (shift >= kMagnitudes) {
+        return kBucketCount - 1U;
+    }
+    const auto sub_bucket = static_cast<std::size_t>(nanoseconds >> shift) - kSubBuckets;
+    return kSubBuckets * (shift + 1U) + sub_bucket;
+}
+
+inline std::uint64_t LatencyHistogram::UpperBound(const std::size_t bucket) noexcept {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+
+    const std::size_t shift = bucket / kSubBuckets - 1U;
+    const std::uint64_t mantissa = kSubBuckets + bucket % kSubBuckets;
+    return ((mantissa + 1U) << shift) - 1U;
+}
+
+inline void LatencyMetrics::SetSampleInterval(const std::uint32_t one_in) noexcept {
+    sample_interval_.store(one_in, std::memory_order_relaxed);
+}
+
+inline LatencyHistogram* LatencyMetrics::Sample(LatencyHistogram LatencyMetrics::*const histogram) noexcept {
+    const std::uint32_t interval = sample_interval_.load(std::memory_order_relaxed);
+    if (interval == 0U) {
+        return nullptr;
+    }
+
+    thread_local std::uint32_t calls = 0;
+    if (++calls < interval) {
+        return nullptr;
+    }
+    calls = 0;
+    return &(this->*histogram);
+}
+
+inline void LatencyMetrics::CopyTo(CacheStats& stats) const {
+    stats.get_latency = get.Snapshot();
+    stats.put_latency = put.Snapshot();
+}
+
+inline void NoLatencyMetrics::SetSampleInterval(std::uint32_t) noexcept {}
+
+inline LatencyHistogram* NoLatencyMetrics::Sample(LatencyHistogram LatencyMetrics::*) noexcept {
+    return nullptr;
+}
+
+inline void NoLatencyMetrics::CopyTo(CacheStats&) const {}
+
+#endif  // SHARDED_LRU_CACHE_CACHEMETRICS_CPP
@@ -0,0 +1,131 @@
+#ifndef SHARDED_LRU_CACHE_CACHEMETRICS_H
+#define SHARDED_LRU_CACHE_CACHEMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Instrumentation for ShardedLRUCache. Building with
+// -DSHARDED_LRU_CACHE_NO_METRICS removes it: the counters and histograms
+// become empty members, every update compiles to nothing, and Stats()
+// returns zeros.
+#if defined(SHARDED_LRU_CACHE_NO_METRICS)
+inline constexpr bool kCacheMetricsEnabled = false;
+#else
+inline constexpr bool kCacheMetricsEnabled = true;
+#endif
+
+// Point-in-time counter values for one shard (or summed over all shards).
+struct ShardStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t puts = 0;
+    // Entries removed to make room; expirations and Erase are not counted.
+    std::uint64_t evictions = 0;
+    // Lock acquisitions that found the shard lock held, and how long they
+    // waited in total.
+    std::uint64_t contended_locks = 0;
+    std::chrono::nanoseconds lock_wait{0};
+
+    // Hits over lookups; zero before the first lookup.
+    [[nodiscard]] double HitRatio() const noexcept;
+    ShardStats& operator+=(const ShardStats& other) noexcept;
+};
+
+// Counters one shard updates in place. Each update is a single relaxed
+// fetch_add, so a reader sees every counter exactly, though not a consistent
+// cut across counters. Padded to whole cache lines so neighbouring shards'
+// counters never share one.
+struct alignas(64) ShardCounters {
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> puts{0};
+    std::atomic<std::uint64_t> evictions{0};
+    std::atomic<std::uint64_t> contended_locks{0};
+    std::atomic<std::uint64_t> lock_wait_ns{0};
+
+    [[nodiscard]] ShardStats Read() const noexcept;
+};
+
+struct NoShardCounters {};
+
+using ShardMetrics = std::conditional_t<kCacheMetricsEnabled, ShardCounters, NoShardCounters>;
+
+// Latency distribution read from a LatencyHistogram.
+struct LatencySnapshot {
+    std::uint64_t count = 0;
+    // Per-bucket counts, indexed like LatencyHistogram's buckets.
+    std::vector<std::uint64_t> buckets;
+
+    // Smallest bucket bound at or above `percentile` (0-100) of the samples;
+    // zero when nothing was recorded.
+    [[nodiscard]] std::chrono::nanoseconds Percentile(double percentile) const;
+};
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below
+// 16 ns get a bucket each; above that every power of two is split into 16
+// buckets, so a reported latency is within 1/16 of the recorded one. Values
+// past about 18 minutes land in the last bucket. Recording is one relaxed
+// fetch_add and never allocates.
+class LatencyHistogram final {
+public:
+    static constexpr std::size_t kSubBucketBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    // Powers of two above the exact range, up to 2^40 ns.
+    static constexpr std::size_t kMagnitudes = 36;
+    static constexpr std::size_t kBucketCount = kSubBuckets * (kMagnitudes + 1U);
+
+    void Record(std::chrono::nanoseconds latency) noexcept;
+    [[nodiscard]] LatencySnapshot Snapshot() const;
+
+    [[nodiscard]] static std::size_t BucketOf(std::uint64_t nanoseconds) noexcept;
+    // Largest value that falls into `bucket`.
+    [[nodiscard]] static std::uint64_t UpperBound(std::size_t bucket) noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> counts_{};
+};
+
+// Snapshot returned by ShardedLRUCache::Stats().
+struct CacheStats {
+    // One entry per shard of the current layout, in shard order.
+    std::vector<ShardStats> shards;
+    ShardStats total;
+    LatencySnapshot get_latency;
+    LatencySnapshot put_latency;
+};
+
+// Sampled Get and Put latencies of one cache.
+class LatencyMetrics final {
+public:
+    // One call in `one_in` per thread is timed; zero turns sampling off.
+    void SetSampleInterval(std::uint32_t one_in) noexcept;
+    // The histogram to time the calling thread's current call into, or
+    // nullptr when the call is not sampled. The countdown is per thread and
+    // shared by every cache.
+    [[nodiscard]] LatencyHistogram* Sample(LatencyHistogram LatencyMetrics::*histogram) noexcept;
+    void CopyTo(CacheStats& stats) const;
+
+    LatencyHistogram get;
+    LatencyHistogram put;
+
+private:
+    std::atomic<std::uint32_t> sample_interval_{0};
+};
+
+// Stand-in when metrics are compiled out; samples nothing.
+struct NoLatencyMetrics {
+    void SetSampleInterval(std::uint32_t one_in) noexcept;
+    [[nodiscard]] LatencyHistogram* Sample(LatencyHistogram LatencyMetrics::*histogram) noexcept;
+    void CopyTo(CacheStats& stats) const;
+};
+
+using CacheLatencyMetrics = std::conditional_t<kCacheMetricsEnabled, LatencyMetrics, NoLatencyMetrics>;
+
+#include "CacheMetrics.cpp"
+
+#endif  // SHARDED_LRU_CACHE_CACHEMETRICS_H
@@ -0,0 +1,117 @@
+#ifndef SHARDED_LRU_CACHE_CACHETRAITS_H
+#define SHARDED_LRU_CACHE_CACHETRAITS_H
+
+#include "HashMix.h"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Hash used by the cache indexes. It is std::hash<Key>, except for
+// std::string, where a transparent hash lets lookups by std::string_view or
+// const char* probe the index without building a temporary std::string.
+template <typename Key>
+struct KeyHash : std::hash<Key> {};
+
+template <>
+struct KeyHash<std::string> {
+    using is_transparent = void;
+
+    // std::hash<std::string_view> agrees with std::hash<std::string> for equal
+    // character sequences, so both key forms land in the same bucket.
+    [[nodiscard]] std::size_t operator()(const std::string_view key) const noexcept {
+        return std::hash<std::string_view>{}(key);
+    }
+};
+
+template <typename Key>
+concept TransparentKeyHash = requires { typename KeyHash<Key>::is_transparent; };
+
+// Types a lookup (Get, GetWith, Contains) accepts: with a transparent
+// KeyHash<Key>, anything it hashes and compares against Key directly;
+// otherwise anything convertible to Key.
+template <typename K, typename Key>
+concept LookupKey =
+    (TransparentKeyHash<Key> && std::invocable<const KeyHash<Key>&, const K&> &&
+     requires(const Key& stored, const K& key) {
+         { stored == key } -> std::convertible_to<bool>;
+     }) ||
+    (!TransparentKeyHash<Key> && std::convertible_to<const K&, Key>);
+
+// Weight of one entry in the unit of the cache's weight budget (bytes, for
+// example). Called once per insert or update, under the cache lock.
+template <typename Weigher, typename Key, typename Value>
+concept EntryWeigher = std::copy_constructible<Weigher> &&
+                       std::invocable<const Weigher&, const Key&, const Value&> &&
+                       std::convertible_to<std::invoke_result_t<const Weigher&, const Key&, const Value&>,
+                                           std::size_t>;
+
+// Default weigher: every entry weighs 1, so the weight budget is an entry
+// count and WeightedSize() equals Size().
+struct UnitWeigher {
+    template <typename Key, typename Value>
+    [[nodiscard]] constexpr std::size_t operator()(const Key&, const Value&) const noexcept {
+        return 1U;
+    }
+};
+
+// Picks a ShardedLRUCache shard. Hash turns the key's KeyHash into the hash
+// the cache keeps for the entry (front cache, disk tier, shard choice); Index
+// maps that hash onto [0, shard_count).
+template <typename Selector>
+concept ShardSelector = requires(const std::uint64_t hash, const std::size_t shard_count) {
+    { Selector::Hash(hash) } noexcept -> std::same_as<std::uint64_t>;
+    { Selector::Index(hash, shard_count) } noexcept -> std::same_as<std::size_t>;
+};
+
+// Default selector: mixes the hash so keys with patterned low bits (integers
+// under libstdc++'s identity std::hash) still spread, then masks for a
+// power-of-two shard count or range-reduces otherwise.
+struct MixedShardSelector {
+    [[nodiscard]] static constexpr std::uint64_t Hash(const std::uint64_t hash) noexcept {
+        return MixHash(hash);
+    }
+
+    [[nodiscard]] static constexpr std::size_t Index(const std::uint64_t hash,
+                                                     const std::size_t shard_count) noexcept {
+        if (std::has_single_bit(shard_count)) {
+            return static_cast<std::size_t>(hash) & (shard_count - 1U);
+        }
+        // Multiply-shift range reduction (Lemire) maps the high 32 bits onto
+        // [0, shard_count) without an integer division.
+        return static_cast<std::size_t>(((hash >> 32U) * shard_count) >> 32U);
+    }
+};
+
+// Why an entry left the cache, as reported to removal handlers/listeners.
+enum class RemovalCause : std::uint8_t {
+    // Evicted to make room, or too heavy to be kept at all.
+    kCapacity,
+    // Its TTL ran out.
+    kExpired,
+    // Erased by the caller.
+    kExplicit,
+    // Its value was overwritten by a Put/Emplace of the same key.
+    kReplaced,
+    // Dropped by Clear.
+    kCleared,
+};
+
+// Overwrites `target` with a value built from `args`. A single assignable
+// argument is assigned directly so the existing value can reuse its buffers.
+template <typename Value, typename... Args>
+void AssignValue(Value& target, Args&&... args) {
+    if constexpr (sizeof...(Args) == 1 && (std::is_assignable_v<Value&, Args&&> && ...)) {
+        ((target = std::forward<Args>(args)), ...);
+    } else {
+        target = Value(std::forward<Args>(args)...);
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_CACHETRAITS_H
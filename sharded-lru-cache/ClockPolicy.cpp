@@ -0,0 +1,78 @@
+#ifndef SHARDED_LRU_CACHE_CLOCKPOLICY_CPP
+#define SHARDED_LRU_CACHE_CLOCKPOLICY_CPP
+
+#include "ClockPolicy.h"
+
+#include <utility>
+
+template <typename Key>
+ClockPolicy<Key>::ClockPolicy([[maybe_unused]] const std::size_t capacity) : hand_(ring_.end()) {}
+
+// std::list may invalidate end() when moved, so a hand parked there is
+// re-pointed at the destination's end().
+template <typename Key>
+ClockPolicy<Key>::ClockPolicy(ClockPolicy&& other) noexcept : hand_(ring_.end()) {
+    *this = std::move(other);
+}
+
+template <typename Key>
+ClockPolicy<Key>& ClockPolicy<Key>::operator=(ClockPolicy&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+
+    const bool hand_at_end = other.hand_ == other.ring_.end();
+    ring_ = std::move(other.ring_);
+    hand_ = hand_at_end ? ring_.end() : other.hand_;
+    other.ring_.clear();
+    other.hand_ = other.ring_.end();
+    return *this;
+}
+
+template <typename Key>
+typename ClockPolicy<Key>::Handle ClockPolicy<Key>::OnInsert(const Key& key) {
+    return ring_.emplace(hand_, &key);
+}
+
+template <typename Key>
+void ClockPolicy<Key>::OnAccess(const Handle handle) const noexcept {
+    // Skip the store when the bit is already set so hot entries do not keep
+    // bouncing their cache line between readers.
+    if (!handle->referenced.load(std::memory_order_relaxed)) {
+        handle->referenced.store(true, std::memory_order_relaxed);
+    }
+}
+
+template <typename Key>
+const Key& ClockPolicy<Key>::Victim() noexcept {
+    while (true) {
+        if (hand_ == ring_.end()) {
+            hand_ = ring_.begin();
+        }
+        if (!hand_->referenced.exchange(false, std::memory_order_relaxed)) {
+            return *hand_->key;
+        }
+        ++hand_;
+    }
+}
+
+template <typename Key>
+void ClockPolicy<Key>::OnEvict(const Handle handle) noexcept {
+    OnRemove(handle);
+}
+
+template <typename Key>
+void ClockPolicy<Key>::OnRemove(const Handle handle) noexcept {
+    if (handle == hand_) {
+        ++hand_;
+    }
+    ring_.erase(handle);
+}
+
+template <typename Key>
+void ClockPolicy<Key>::Clear() noexcept {
+    ring_.clear();
+    hand_ = ring_.end();
+}
+
+#endif  // SHARDED_LRU_CACHE_CLOCKPOLICY_CPP
@@ -0,0 +1,50 @@
+#ifndef SHARDED_LRU_CACHE_CLOCKPOLICY_H
+#define SHARDED_LRU_CACHE_CLOCKPOLICY_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+
+// CLOCK (second chance) approximation of LRU built for read-heavy shards.
+// - A hit only sets the entry's atomic reference bit; it never relinks nodes,
+//   so OnAccess is safe to call concurrently under a shared lock.
+// - Recency is resolved lazily: at eviction time the hand sweeps the ring,
+//   clearing set bits, and evicts the first entry whose bit is clear.
+template <typename Key>
+class ClockPolicy final {
+private:
+    struct Node {
+        explicit Node(const Key* node_key) : key(node_key) {}
+
+        const Key* key;
+        // Set on insert, as when CLOCK faults a page in: otherwise a sweep over
+        // an all-referenced ring would stop at the newest entry first.
+        std::atomic<bool> referenced{true};
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    static constexpr bool kConcurrentAccess = true;
+
+    explicit ClockPolicy(std::size_t capacity);
+    ClockPolicy(ClockPolicy&& other) noexcept;
+    ClockPolicy& operator=(ClockPolicy&& other) noexcept;
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) const noexcept;
+    [[nodiscard]] const Key& Victim() noexcept;
+    void OnEvict(Handle handle) noexcept;
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+
+private:
+    // The ring is the list read cyclically from the hand; new nodes are linked
+    // just behind the hand so they are the last ones it reaches.
+    std::list<Node> ring_;
+    Handle hand_;
+};
+
+#include "ClockPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_CLOCKPOLICY_H
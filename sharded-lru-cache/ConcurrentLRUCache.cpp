@@ -0,0 +1,220 @@
+#ifndef SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_CPP
+#define SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_CPP
+
+#include "ConcurrentLRUCache.h"
+
+#include <algorithm>
+#include <bit>
+
+template <typename Key, typename Value>
+ConcurrentLRUCache<Key, Value>::ConcurrentLRUCache(const std::size_t capacity) : capacity_(capacity) {
+    if (capacity_ == 0U) {
+        throw std::invalid_argument("ConcurrentLRUCache capacity must be greater than zero");
+    }
+
+    // About one node per bucket when full keeps chains short without a resize.
+    const std::size_t bucket_count = std::bit_ceil(capacity_);
+    const std::size_t stripe_count = std::min(bucket_count, kStripes);
+    bucket_mask_ = bucket_count - 1U;
+    buckets_ = std::make_unique<std::atomic<Node*>[]>(bucket_count);
+    stripes_ = std::make_unique<Stripe[]>(stripe_count);
+    stripe_mask_ = stripe_count - 1U;
+}
+
+template <typename Key, typename Value>
+ConcurrentLRUCache<Key, Value>::~ConcurrentLRUCache() {
+    for (std::size_t bucket = 0; bucket <= bucket_mask_; ++bucket) {
+        Node* node = buckets_[bucket].load(std::memory_order_relaxed);
+        while (node != nullptr) {
+            Node* const next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+}
+
+template <typename Key, typename Value>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> ConcurrentLRUCache<Key, Value>::Get(const K& key) {
+    std::optional<Value> value;
+    GetWith(key, [&value](const Value& cached) { value.emplace(cached); });
+    return value;
+}
+
+template <typename Key, typename Value>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool ConcurrentLRUCache<Key, Value>::GetWith(const K& key, Visitor&& visitor) {
+    const std::uint64_t hash = HashOf(key);
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    Node* const node = Find(hash, key);
+    if (node == nullptr) {
+        return false;
+    }
+
+    // Checked first so repeat hits on a hot node do not keep writing its
+    // cache line.
+    if (!node->referenced.load(std::memory_order_relaxed)) {
+        node->referenced.store(true, std::memory_order_relaxed);
+    }
+    std::invoke(visitor, node->value);
+    return true;
+}
+
+template <typename Key, typename Value>
+template <typename K>
+    requires LookupKey<K, Key>
+bool ConcurrentLRUCache<Key, Value>::Contains(const K& key) const {
+    const std::uint64_t hash = HashOf(key);
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    return Find(hash, key) != nullptr;
+}
+
+template <typename Key, typename Value>
+void ConcurrentLRUCache<Key, Value>::Put(const Key& key, const Value& value) {
+    Emplace(key, value);
+}
+
+template <typename Key, typename Value>
+void ConcurrentLRUCache<Key, Value>::Put(Key&& key, Value&& value) {
+    Emplace(std::move(key), std::move(value));
+}
+
+template <typename Key, typename Value>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void ConcurrentLRUCache<Key, Value>::Emplace(K&& key, Args&&... args) {
+    const std::uint64_t hash = HashOf(key);
+    Insert(std::make_unique<Node>(hash, std::forward<K>(key), std::forward<Args>(args)...));
+}
+
+template <typename Key, typename Value>
+std::size_t ConcurrentLRUCache<Key, Value>::Size() const noexcept {
+    return size_.load(std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value>
+void ConcurrentLRUCache<Key, Value>::Clear() {
+    for (std::size_t bucket = 0; bucket <= bucket_mask_; ++bucket) {
+        Node* chain = nullptr;
+        {
+            std::scoped_lock lock(StripeFor(bucket));
+            chain = buckets_[bucket].load(std::memory_order_relaxed);
+            buckets_[bucket].store(nullptr, std::memory_order_release);
+        }
+
+        while (chain != nullptr) {
+            // Read before retiring: the node may be freed right away.
+            Node* const next = chain->next.load(std::memory_order_relaxed);
+            reclaimer_.Retire(chain);
+            size_.fetch_sub(1U, std::memory_order_relaxed);
+            chain = next;
+        }
+    }
+}
+
+template <typename Key, typename Value>
+template <typename K>
+std::uint64_t ConcurrentLRUCache<Key, Value>::HashOf(const K& key) const {
+    return MixHash(static_cast<std::uint64_t>(hasher_(key)));
+}
+
+template <typename Key, typename Value>
+std::atomic<typename ConcurrentLRUCache<Key, Value>::Node*>& ConcurrentLRUCache<Key, Value>::BucketFor(
+    const std::uint64_t hash) const noexcept {
+    return buckets_[static_cast<std::size_t>(hash) & bucket_mask_];
+}
+
+template <typename Key, typename Value>
+std::mutex& ConcurrentLRUCache<Key, Value>::StripeFor(const std::size_t bucket) const noexcept {
+    return stripes_[bucket & stripe_mask_].mutex;
+}
+
+template <typename Key, typename Value>
+template <typename K>
+typename ConcurrentLRUCache<Key, Value>::Node* ConcurrentLRUCache<Key, Value>::Find(const std::uint64_t hash,
+                                                                                    const K& key) const {
+    // Acquire pairs with the release store that linked each node, so its
+    // key and value are fully built before they are compared or read.
+    for (Node* node = BucketFor(hash).load(std::memory_order_acquire); node != nullptr;
+         node = node->next.load(std::memory_order_acquire)) {
+        if (node->hash == hash && node->key == key) {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename Key, typename Value>
+void ConcurrentLRUCache<Key, Value>::Insert(std::unique_ptr<Node> node) {
+    const std::uint64_t hash = node->hash;
+    const std::size_t bucket = static_cast<std::size_t>(hash) & bucket_mask_;
+    std::atomic<Node*>& head = buckets_[bucket];
+    Node* replaced = nullptr;
+    {
+        std::scoped_lock lock(StripeFor(bucket));
+        std::atomic<Node*>* link = &head;
+        Node* current = link->load(std::memory_order_relaxed);
+        while (current != nullptr && !(current->hash == hash && current->key == node->key)) {
+            link = &current->next;
+            current = link->load(std::memory_order_relaxed);
+        }
+
+        if (current != nullptr) {
+            // The new node takes the old one's place; readers already on the
+            // old node still reach the rest of the chain through it.
+            node->next.store(current->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            replaced = current;
+        } else {
+            link = &head;
+            node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        link->store(node.release(), std::memory_order_release);
+    }
+
+    if (replaced != nullptr) {
+        reclaimer_.Retire(replaced);
+    } else if (size_.fetch_add(1U, std::memory_order_relaxed) >= capacity_) {
+        EvictOne();
+    }
+}
+
+template <typename Key, typename Value>
+void ConcurrentLRUCache<Key, Value>::EvictOne() {
+    // Rechecked every step: a concurrent evictor or Clear may already have
+    // made room.
+    while (size_.load(std::memory_order_relaxed) > capacity_) {
+        const std::size_t bucket = hand_.fetch_add(1U, std::memory_order_relaxed) & bucket_mask_;
+        std::atomic<Node*>& head = buckets_[bucket];
+        if (head.load(std::memory_order_relaxed) == nullptr) {
+            continue;
+        }
+
+        Node* victim = nullptr;
+        {
+            std::scoped_lock lock(StripeFor(bucket));
+            std::atomic<Node*>* link = &head;
+            for (Node* node = link->load(std::memory_order_relaxed); node != nullptr;
+                 node = link->load(std::memory_order_relaxed)) {
+                if (node->referenced.exchange(false, std::memory_order_relaxed)) {
+                    link = &node->next;
+                    continue;
+                }
+                link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+                victim = node;
+                break;
+            }
+        }
+
+        if (victim != nullptr) {
+            size_.fetch_sub(1U, std::memory_order_relaxed);
+            reclaimer_.Retire(victim);
+            return;
+        }
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_CPP
@@ -0,0 +1,117 @@
+#ifndef SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_H
+#define SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_H
+
+#include "CacheTraits.h"
+#include "EpochReclaimer.h"
+#include "HashMix.h"
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Thread-safe cache built on one concurrent hash index instead of shards.
+// - The index is a fixed array of bucket chains sized to the capacity. Nodes
+//   are immutable once linked: an update links a new node in place of the old
+//   one, so readers never see a value being written.
+// - Get/GetWith/Contains take no lock and never retry. They pin the thread in
+//   an EpochReclaimer, walk one chain with acquire loads, and set the node's
+//   reference bit. Each call is wait-free once the thread has its epoch
+//   record.
+// - Writers lock one of kStripes mutexes chosen by bucket, so writes to
+//   different stripes run in parallel regardless of thread count.
+// - Recency is approximated by CLOCK over the buckets: an insert that takes
+//   the cache past its capacity advances a shared hand, clearing reference
+//   bits, until it finds an unreferenced node to evict.
+// - Unlinked nodes are retired to the reclaimer and freed once no pinned
+//   reader can still reach them.
+// While writers race, the cache may hold up to one extra entry per writer.
+template <typename Key, typename Value>
+class ConcurrentLRUCache final {
+public:
+    explicit ConcurrentLRUCache(std::size_t capacity);
+    ~ConcurrentLRUCache();
+
+    ConcurrentLRUCache(const ConcurrentLRUCache&) = delete;
+    ConcurrentLRUCache& operator=(const ConcurrentLRUCache&) = delete;
+    ConcurrentLRUCache(ConcurrentLRUCache&&) = delete;
+    ConcurrentLRUCache& operator=(ConcurrentLRUCache&&) = delete;
+
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    // Runs `visitor(const Value&)` on the cached value in place. The value
+    // stays alive for the call even if a writer replaces it meanwhile. The
+    // visitor must not call back into the cache.
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor);
+    // Presence check that does not set the reference bit.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    // Builds the new node, key and value included, before taking the stripe
+    // lock.
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
+    [[nodiscard]] std::size_t Size() const noexcept;
+    void Clear();
+
+private:
+    static constexpr std::size_t kStripes = 1024;
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    struct Node {
+        template <typename K, typename... Args>
+        Node(const std::uint64_t node_hash, K&& node_key, Args&&... args)
+            : hash(node_hash), key(std::forward<K>(node_key)), value(std::forward<Args>(args)...) {}
+
+        const std::uint64_t hash;
+        const Key key;
+        const Value value;
+        std::atomic<Node*> next{nullptr};
+        // Set on insert and on every hit; cleared by the CLOCK hand.
+        std::atomic<bool> referenced{true};
+    };
+
+    struct alignas(kCacheLineSize) Stripe {
+        std::mutex mutex;
+    };
+
+    template <typename K>
+    [[nodiscard]] std::uint64_t HashOf(const K& key) const;
+    [[nodiscard]] std::atomic<Node*>& BucketFor(std::uint64_t hash) const noexcept;
+    [[nodiscard]] std::mutex& StripeFor(std::size_t bucket) const noexcept;
+    // Finds `key` in its chain; requires a pinned guard or the stripe lock.
+    template <typename K>
+    [[nodiscard]] Node* Find(std::uint64_t hash, const K& key) const;
+    // Links `node`, replacing any node with an equal key.
+    void Insert(std::unique_ptr<Node> node);
+    // Sweeps the CLOCK hand until one node is unlinked and retired.
+    void EvictOne();
+
+    std::size_t capacity_;
+    std::size_t bucket_mask_;
+    std::unique_ptr<std::atomic<Node*>[]> buckets_;
+    std::unique_ptr<Stripe[]> stripes_;
+    std::size_t stripe_mask_;
+    KeyHash<Key> hasher_;
+    alignas(kCacheLineSize) std::atomic<std::size_t> size_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> hand_{0};
+    mutable EpochReclaimer reclaimer_;
+};
+
+#include "ConcurrentLRUCache.cpp"
+
+#endif  // SHARDED_LRU_CACHE_CONCURRENTLRUCACHE_H
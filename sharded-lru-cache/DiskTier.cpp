@@ -0,0 +1,462 @@
+#ifndef SHARDED_LRU_CACHE_DISKTIER_CPP
+#define SHARDED_LRU_CACHE_DISKTIER_CPP
+
+#include "DiskTier.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace disk_tier_detail {
+
+inline bool ReadFully(const int fd, char* out, std::size_t count, std::uint64_t offset) noexcept {
+    while (count > 0U) {
+        const ssize_t read = ::pread(fd, out, count, static_cast<off_t>(offset));
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read <= 0) {
+            return false;
+        }
+        out += read;
+        count -= static_cast<std::size_t>(read);
+        offset += static_cast<std::uint64_t>(read);
+    }
+    return true;
+}
+
+inline void WriteFully(const int fd, const char* data, std::size_t count, std::uint64_t offset) {
+    while (count > 0U) {
+        const ssize_t written = ::pwrite(fd, data, count, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw std::system_error(errno, std::generic_category(), "disk tier write failed");
+        }
+        data += written;
+        count -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+}
+
+inline constexpr std::string_view kSegmentPrefix = "segment-";
+inline constexpr std::string_view kSegmentSuffix = ".log";
+
+}  // namespace disk_tier_detail
+
+template <typename Key, typename Value>
+template <typename KeyCodec, typename ValueCodec>
+    requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+std::unique_ptr<DiskTier<Key, Value>> DiskTier<Key, Value>::Create(DiskTierOptions options) {
+    return std::unique_ptr<DiskTier>(new DiskTier(
+        std::move(options), [](const Key& key, std::string& out) { KeyCodec::Encode(key, out); },
+        [](const Value& value, std::string& out) { ValueCodec::Encode(value, out); },
+        [](SnapshotReader& in) -> Key { return KeyCodec::Decode(in); },
+        [](SnapshotReader& in) -> Value { return ValueCodec::Decode(in); }));
+}
+
+template <typename Key, typename Value>
+DiskTier<Key, Value>::DiskTier(DiskTierOptions options, const EncodeKey encode_key,
+                               const EncodeValue encode_value, const DecodeKey decode_key,
+                               const DecodeValue decode_value)
+    : options_(std::move(options)),
+      encode_key_(encode_key),
+      encode_value_(encode_value),
+      decode_key_(decode_key),
+      decode_value_(decode_value),
+      epoch_(std::chrono::steady_clock::now()) {
+    if (options_.directory.empty()) {
+        throw std::invalid_argument("disk tier directory must not be empty");
+    }
+    if (options_.segment_bytes == 0U || options_.max_bytes == 0U) {
+        throw std::invalid_argument("disk tier segment_bytes and max_bytes must be greater than zero");
+    }
+    if (!(options_.compact_dead_ratio > 0.0 && options_.compact_dead_ratio <= 1.0)) {
+        throw std::invalid_argument("disk tier compact_dead_ratio must be in (0, 1]");
+    }
+
+    std::filesystem::create_directories(options_.directory);
+    using disk_tier_detail::kSegmentPrefix;
+    using disk_tier_detail::kSegmentSuffix;
+    for (const auto& file : std::filesystem::directory_iterator(options_.directory)) {
+        const std::string name = file.path().filename().string();
+        if (name.starts_with(kSegmentPrefix) && name.ends_with(kSegmentSuffix)) {
+            std::filesystem::remove(file.path());
+        }
+    }
+}
+
+template <typename Key, typename Value>
+DiskTier<Key, Value>::~DiskTier() = default;
+
+template <typename Key, typename Value>
+DiskTier<Key, Value>::Segment::Segment(const std::uint32_t segment_id, std::string file_path)
+    : id(segment_id), path(std::move(file_path)) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot create disk tier segment " + path);
+    }
+}
+
+template <typename Key, typename Value>
+DiskTier<Key, Value>::Segment::~Segment() {
+    ::close(fd);
+    ::unlink(path.c_str());
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Append(const std::span<const Record> records) {
+    struct Placed {
+        std::uint64_t hash;
+        std::uint64_t offset;
+        std::uint32_t length;
+    };
+
+    std::string bytes;
+    std::vector<Placed> placed;
+    placed.reserve(records.size());
+    const auto now = std::chrono::steady_clock::now();
+    for (const Record& record : records) {
+        std::int64_t deadline = kNoDeadline;
+        if (record.deadline != std::chrono::steady_clock::time_point{}) {
+            if (record.deadline <= now) {
+                continue;
+            }
+            const auto since_epoch = std::chrono::ceil<std::chrono::milliseconds>(record.deadline - epoch_);
+            deadline = since_epoch.count();
+        }
+
+        const std::size_t start = bytes.size();
+        bytes.resize(start + sizeof(RecordHeader));
+        encode_key_(record.key, bytes);
+        encode_value_(record.value, bytes);
+        const std::size_t length = bytes.size() - start;
+        if (length > std::numeric_limits<std::uint32_t>::max()) {
+            // Too large for a Location; not spilled.
+            bytes.resize(start);
+            continue;
+        }
+
+        const RecordHeader header{record.hash, deadline,
+                                  static_cast<std::uint32_t>(length - sizeof(RecordHeader)), 0U};
+        std::memcpy(bytes.data() + start, &header, sizeof(header));
+        placed.push_back(Placed{record.hash, start, static_cast<std::uint32_t>(length)});
+    }
+    if (placed.empty()) {
+        return;
+    }
+
+    std::scoped_lock lock(write_mutex_);
+    const auto [segment, base] = WriteBytes(bytes);
+    for (const Placed& record : placed) {
+        const Location location{segment->id, record.length, base + record.offset};
+        segment->live_bytes.fetch_add(record.length, std::memory_order_relaxed);
+        Stripe& stripe = StripeFor(record.hash);
+        std::scoped_lock stripe_lock(stripe.mutex);
+        const auto [entry, inserted] = stripe.index.try_emplace(record.hash, location);
+        if (!inserted) {
+            MarkDead(entry->second);
+            entry->second = location;
+        }
+    }
+    appended_.fetch_add(placed.size(), std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value>
+template <typename K>
+std::optional<typename DiskTier<Key, Value>::Found> DiskTier<Key, Value>::Read(
+    const K& key, const std::uint64_t hash) const {
+    Location location;
+    {
+        Stripe& stripe = StripeFor(hash);
+        std::scoped_lock lock(stripe.mutex);
+        const auto found = stripe.index.find(hash);
+        if (found == stripe.index.end()) {
+            return std::nullopt;
+        }
+        location = found->second;
+    }
+    // Holding the segment keeps its file open even if it is collected now.
+    const std::shared_ptr<Segment> segment = FindSegment(location.segment);
+    std::string buffer(location.length, '\0');
+    if (segment == nullptr || location.length < sizeof(RecordHeader) ||
+        !disk_tier_detail::ReadFully(segment->fd, buffer.data(), buffer.size(), location.offset)) {
+        return std::nullopt;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.hash != hash || header.payload_bytes != location.length - sizeof(RecordHeader)) {
+        return std::nullopt;
+    }
+    std::chrono::milliseconds ttl = std::chrono::milliseconds::zero();
+    if (header.deadline != kNoDeadline) {
+        const std::int64_t left = header.deadline - NowMs();
+        if (left <= 0) {
+            return std::nullopt;
+        }
+        ttl = std::chrono::milliseconds(left);
+    }
+
+    try {
+        SnapshotReader reader(std::as_bytes(std::span(buffer)).subspan(sizeof(RecordHeader)));
+        Key stored = decode_key_(reader);
+        if (!(stored == key)) {
+            // Another key with the same hash.
+            return std::nullopt;
+        }
+        Value value = decode_value_(reader);
+        return Found{std::move(stored), std::move(value), ttl, location};
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+}
+
+template <typename Key, typename Value>
+bool DiskTier<Key, Value>::Remove(const std::uint64_t hash, const Location& expected) {
+    Stripe& stripe = StripeFor(hash);
+    std::scoped_lock lock(stripe.mutex);
+    const auto found = stripe.index.find(hash);
+    if (found == stripe.index.end() || found->second != expected) {
+        return false;
+    }
+    MarkDead(found->second);
+    stripe.index.erase(found);
+    promoted_.fetch_add(1U, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Erase(const std::uint64_t hash) {
+    Stripe& stripe = StripeFor(hash);
+    std::scoped_lock lock(stripe.mutex);
+    if (const auto found = stripe.index.find(hash); found != stripe.index.end()) {
+        MarkDead(found->second);
+        stripe.index.erase(found);
+    }
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Clear() {
+    std::scoped_lock lock(write_mutex_);
+    for (Stripe& stripe : stripes_) {
+        std::scoped_lock stripe_lock(stripe.mutex);
+        stripe.index.clear();
+    }
+    {
+        std::scoped_lock segments_lock(segments_mutex_);
+        segments_.clear();
+    }
+    active_.reset();
+    file_bytes_.store(0U, std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Maintain() {
+    std::unique_lock lock(write_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    // Each step deletes one sealed segment and, since compaction needs a dead
+    // ratio above zero, writes back less than it deletes, so this ends.
+    for (;;) {
+        std::vector<std::shared_ptr<Segment>> sealed;
+        {
+            std::scoped_lock segments_lock(segments_mutex_);
+            for (const auto& [id, segment] : segments_) {
+                if (segment != active_) {
+                    sealed.push_back(segment);
+                }
+            }
+        }
+        std::sort(sealed.begin(), sealed.end(),
+                  [](const auto& left, const auto& right) { return left->id < right->id; });
+
+        const auto mostly_dead = std::find_if(sealed.begin(), sealed.end(), [this](const auto& segment) {
+            const auto size = static_cast<double>(segment->size.load(std::memory_order_relaxed));
+            const auto live = static_cast<double>(segment->live_bytes.load(std::memory_order_relaxed));
+            return size > 0.0 && live <= size * (1.0 - options_.compact_dead_ratio);
+        });
+        if (mostly_dead != sealed.end()) {
+            Compact(*mostly_dead);
+        } else if (file_bytes_.load(std::memory_order_relaxed) > options_.max_bytes && !sealed.empty()) {
+            Drop(sealed.front());
+        } else {
+            return;
+        }
+    }
+}
+
+template <typename Key, typename Value>
+DiskTierStats DiskTier<Key, Value>::Stats() const {
+    DiskTierStats stats;
+    for (const Stripe& stripe : stripes_) {
+        std::scoped_lock lock(stripe.mutex);
+        stats.entries += stripe.index.size();
+    }
+    {
+        std::scoped_lock lock(segments_mutex_);
+        stats.segments = segments_.size();
+        for (const auto& [id, segment] : segments_) {
+            stats.live_bytes += segment->live_bytes.load(std::memory_order_relaxed);
+        }
+    }
+    stats.file_bytes = file_bytes_.load(std::memory_order_relaxed);
+    stats.appended = appended_.load(std::memory_order_relaxed);
+    stats.promoted = promoted_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.compactions = compactions_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template <typename Key, typename Value>
+typename DiskTier<Key, Value>::Stripe& DiskTier<Key, Value>::StripeFor(
+    const std::uint64_t hash) const noexcept {
+    // The cache picks shards with the low bits; use the high ones here.
+    return stripes_[static_cast<std::size_t>(hash >> 58U) % kStripes];
+}
+
+template <typename Key, typename Value>
+std::shared_ptr<typename DiskTier<Key, Value>::Segment> DiskTier<Key, Value>::FindSegment(
+    const std::uint32_t id) const {
+    std::scoped_lock lock(segments_mutex_);
+    const auto found = segments_.find(id);
+    return found == segments_.end() ? nullptr : found->second;
+}
+
+template <typename Key, typename Value>
+std::int64_t DiskTier<Key, Value>::NowMs() const noexcept {
+    const auto elapsed = std::chrono::steady_clock::now() - epoch_;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::MarkDead(const Location& location) const {
+    if (const std::shared_ptr<Segment> segment = FindSegment(location.segment); segment != nullptr) {
+        segment->live_bytes.fetch_sub(location.length, std::memory_order_relaxed);
+    }
+}
+
+template <typename Key, typename Value>
+std::pair<std::shared_ptr<typename DiskTier<Key, Value>::Segment>, std::uint64_t>
+DiskTier<Key, Value>::WriteBytes(const std::string& bytes) {
+    if (active_ == nullptr || (active_->size.load(std::memory_order_relaxed) > 0U &&
+                               active_->size.load(std::memory_order_relaxed) + bytes.size() >
+                                   options_.segment_bytes)) {
+        const std::uint32_t id = next_segment_id_++;
+        const std::string name = std::string(disk_tier_detail::kSegmentPrefix) + std::to_string(id) +
+                                 std::string(disk_tier_detail::kSegmentSuffix);
+        const std::filesystem::path path = std::filesystem::path(options_.directory) / name;
+        auto segment = std::make_shared<Segment>(id, path.string());
+        std::scoped_lock lock(segments_mutex_);
+        segments_.emplace(id, segment);
+        active_ = std::move(segment);
+    }
+
+    const std::uint64_t offset = active_->size.load(std::memory_order_relaxed);
+    disk_tier_detail::WriteFully(active_->fd, bytes.data(), bytes.size(), offset);
+    active_->size.store(offset + bytes.size(), std::memory_order_relaxed);
+    file_bytes_.fetch_add(bytes.size(), std::memory_order_relaxed);
+    return {active_, offset};
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Compact(const std::shared_ptr<Segment>& segment) {
+    struct Moved {
+        std::uint64_t hash;
+        Location from;
+        std::uint64_t offset;
+    };
+
+    const std::uint64_t size = segment->size.load(std::memory_order_relaxed);
+    std::string contents(static_cast<std::size_t>(size), '\0');
+    if (!disk_tier_detail::ReadFully(segment->fd, contents.data(), contents.size(), 0U)) {
+        Drop(segment);
+        return;
+    }
+
+    // Copies the records the index still points at; superseded, removed and
+    // expired ones are left behind.
+    std::string live;
+    std::vector<Moved> moved;
+    const std::int64_t now = NowMs();
+    for (std::uint64_t offset = 0; offset + sizeof(RecordHeader) <= size;) {
+        RecordHeader header;
+        std::memcpy(&header, contents.data() + offset, sizeof(header));
+        const std::uint64_t length = sizeof(RecordHeader) + header.payload_bytes;
+        if (offset + length > size) {
+            break;
+        }
+
+        const Location location{segment->id, static_cast<std::uint32_t>(length), offset};
+        Stripe& stripe = StripeFor(header.hash);
+        std::scoped_lock lock(stripe.mutex);
+        if (const auto found = stripe.index.find(header.hash);
+            found != stripe.index.end() && found->second == location) {
+            if (header.deadline != kNoDeadline && header.deadline <= now) {
+                stripe.index.erase(found);
+            } else {
+                moved.push_back(Moved{header.hash, location, live.size()});
+                live.append(contents, static_cast<std::size_t>(offset), static_cast<std::size_t>(length));
+            }
+        }
+        offset += length;
+    }
+
+    if (!live.empty()) {
+        const auto [target, base] = WriteBytes(live);
+        for (const Moved& record : moved) {
+            Stripe& stripe = StripeFor(record.hash);
+            std::scoped_lock lock(stripe.mutex);
+            // Records removed since the scan stay dead in their new place.
+            if (const auto found = stripe.index.find(record.hash);
+                found != stripe.index.end() && found->second == record.from) {
+                found->second = Location{target->id, record.from.length, base + record.offset};
+                target->live_bytes.fetch_add(record.from.length, std::memory_order_relaxed);
+            }
+        }
+    }
+    RemoveSegment(segment->id);
+    compactions_.fetch_add(1U, std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::Drop(const std::shared_ptr<Segment>& segment) {
+    std::uint64_t dropped = 0;
+    for (Stripe& stripe : stripes_) {
+        std::scoped_lock lock(stripe.mutex);
+        dropped += std::erase_if(
+            stripe.index, [&segment](const auto& entry) { return entry.second.segment == segment->id; });
+    }
+    dropped_.fetch_add(dropped, std::memory_order_relaxed);
+    RemoveSegment(segment->id);
+}
+
+template <typename Key, typename Value>
+void DiskTier<Key, Value>::RemoveSegment(const std::uint32_t id) {
+    std::shared_ptr<Segment> removed;
+    {
+        std::scoped_lock lock(segments_mutex_);
+        const auto found = segments_.find(id);
+        if (found == segments_.end()) {
+            return;
+        }
+        removed = std::move(found->second);
+        segments_.erase(found);
+    }
+    file_bytes_.fetch_sub(removed->size.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // The file is closed and unlinked once the last reader lets go of it.
+}
+
+#endif  // SHARDED_LRU_CACHE_DISKTIER_CPP
@@ -0,0 +1,183 @@
+#ifndef SHARDED_LRU_CACHE_DISKTIER_H
+#define SHARDED_LRU_CACHE_DISKTIER_H
+
+#include "Snapshot.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+struct DiskTierOptions {
+    // Dedicated to the tier: segment files left there by an earlier process
+    // are deleted when the tier opens.
+    std::string directory;
+    // A segment is sealed once an append would take it past this size.
+    std::uint64_t segment_bytes = std::uint64_t{64} << 20U;
+    // Past this many bytes on disk, the oldest sealed segment is dropped
+    // together with whatever is still live in it.
+    std::uint64_t max_bytes = std::uint64_t{1} << 30U;
+    // Sealed segments at least this dead are compacted: their live records
+    // are copied forward and the file is deleted.
+    double compact_dead_ratio = 0.5;
+};
+
+struct DiskTierStats {
+    std::uint64_t entries = 0;
+    std::uint64_t segments = 0;
+    std::uint64_t file_bytes = 0;
+    std::uint64_t live_bytes = 0;
+    // Entries spilled to disk, and entries read back and removed.
+    std::uint64_t appended = 0;
+    std::uint64_t promoted = 0;
+    // Live entries lost when a segment was dropped to stay within max_bytes.
+    std::uint64_t dropped = 0;
+    std::uint64_t compactions = 0;
+};
+
+// Log-structured second tier for entries evicted from memory. Records are
+// appended in batches to segment files; an in-memory index maps each key's
+// 64-bit hash to the record's segment, offset and length, and reads use
+// pread with no lock held. Two keys whose hashes collide cannot both be on
+// disk: the later append wins, and reads compare the stored key. Values
+// survive only as long as the tier: the files are deleted on destruction.
+// Keys and values are written with snapshot codecs (see Snapshot.h).
+// Thread-safe. The index is split into mutex-guarded stripes; appends and
+// garbage collection are serialized with each other but not with reads.
+template <typename Key, typename Value>
+class DiskTier final {
+public:
+    struct Record {
+        std::uint64_t hash;
+        Key key;
+        Value value;
+        // When the entry expires; the default (epoch) value means never.
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    struct Location {
+        std::uint32_t segment = 0;
+        std::uint32_t length = 0;
+        std::uint64_t offset = 0;
+
+        bool operator==(const Location&) const = default;
+    };
+
+    struct Found {
+        Key key;
+        Value value;
+        // Time left to live; zero: none.
+        std::chrono::milliseconds ttl;
+        Location location;
+    };
+
+    // Throws std::invalid_argument for an empty directory or zero sizes, and
+    // std::system_error if the directory cannot be prepared.
+    template <typename KeyCodec = SnapshotCodec<Key>, typename ValueCodec = SnapshotCodec<Value>>
+        requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+    [[nodiscard]] static std::unique_ptr<DiskTier> Create(DiskTierOptions options);
+    ~DiskTier();
+
+    DiskTier(const DiskTier&) = delete;
+    DiskTier& operator=(const DiskTier&) = delete;
+
+    // Writes `records` with one write call, superseding older copies of the
+    // same hashes; records already expired are skipped. Throws
+    // std::system_error if the write fails.
+    void Append(std::span<const Record> records);
+    // Reads the live record for `key` without removing it. I/O errors and
+    // damaged records read as misses.
+    template <typename K>
+    [[nodiscard]] std::optional<Found> Read(const K& key, std::uint64_t hash) const;
+    // Removes the record for `hash` if it is still the one at `expected`,
+    // i.e. it was neither superseded, erased nor moved since it was read.
+    bool Remove(std::uint64_t hash, const Location& expected);
+    void Erase(std::uint64_t hash);
+    void Clear();
+    // Compacts mostly-dead segments and enforces max_bytes. Returns at once
+    // if another thread is appending or collecting.
+    void Maintain();
+    [[nodiscard]] DiskTierStats Stats() const;
+
+private:
+    using EncodeKey = void (*)(const Key&, std::string&);
+    using EncodeValue = void (*)(const Value&, std::string&);
+    using DecodeKey = Key (*)(SnapshotReader&);
+    using DecodeValue = Value (*)(SnapshotReader&);
+
+    static constexpr std::size_t kStripes = 64;
+    static constexpr std::int64_t kNoDeadline = -1;
+
+    // On-disk record header; the encoded key and value follow.
+    struct RecordHeader {
+        std::uint64_t hash;
+        // Milliseconds since the tier's epoch, or kNoDeadline.
+        std::int64_t deadline;
+        std::uint32_t payload_bytes;
+        std::uint32_t reserved;
+    };
+
+    struct Segment {
+        Segment(std::uint32_t segment_id, std::string file_path);
+        ~Segment();
+
+        std::uint32_t id;
+        std::string path;
+        int fd = -1;
+        // Written under write_mutex_.
+        std::atomic<std::uint64_t> size{0};
+        std::atomic<std::uint64_t> live_bytes{0};
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::uint64_t, Location> index;
+    };
+
+    DiskTier(DiskTierOptions options, EncodeKey encode_key, EncodeValue encode_value, DecodeKey decode_key,
+             DecodeValue decode_value);
+
+    [[nodiscard]] Stripe& StripeFor(std::uint64_t hash) const noexcept;
+    [[nodiscard]] std::shared_ptr<Segment> FindSegment(std::uint32_t id) const;
+    [[nodiscard]] std::int64_t NowMs() const noexcept;
+    // Subtracts a superseded or removed record from its segment's live bytes.
+    void MarkDead(const Location& location) const;
+    // Appends `bytes` to the active segment, rolling to a new one first if it
+    // would overflow, and returns where they start. Requires write_mutex_.
+    [[nodiscard]] std::pair<std::shared_ptr<Segment>, std::uint64_t> WriteBytes(const std::string& bytes);
+    // Requires write_mutex_.
+    void Compact(const std::shared_ptr<Segment>& segment);
+    void Drop(const std::shared_ptr<Segment>& segment);
+    void RemoveSegment(std::uint32_t id);
+
+    DiskTierOptions options_;
+    EncodeKey encode_key_;
+    EncodeValue encode_value_;
+    DecodeKey decode_key_;
+    DecodeValue decode_value_;
+    std::chrono::steady_clock::time_point epoch_;
+    mutable std::array<Stripe, kStripes> stripes_;
+    // Guards segments_ (not the files), held only for lookups and updates.
+    mutable std::mutex segments_mutex_;
+    std::unordered_map<std::uint32_t, std::shared_ptr<Segment>> segments_;
+    // Serializes appends, Clear and garbage collection.
+    std::mutex write_mutex_;
+    std::shared_ptr<Segment> active_;
+    std::uint32_t next_segment_id_ = 1;
+    std::atomic<std::uint64_t> file_bytes_{0};
+    std::atomic<std::uint64_t> appended_{0};
+    std::atomic<std::uint64_t> promoted_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> compactions_{0};
+};
+
+#include "DiskTier.cpp"
+
+#endif  // SHARDED_LRU_CACHE_DISKTIER_H
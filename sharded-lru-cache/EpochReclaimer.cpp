@@ -0,0 +1,174 @@
+#ifndef SHARDED_LRU_CACHE_EPOCHRECLAIMER_CPP
+#define SHARDED_LRU_CACHE_EPOCHRECLAIMER_CPP
+
+#include "EpochReclaimer.h"
+
+#include <algorithm>
+
+inline EpochReclaimer::Registry::~Registry() {
+    Record* record = head.load(std::memory_order_acquire);
+    while (record != nullptr) {
+        Record* const next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+inline EpochReclaimer::Guard::Guard(Record& record) noexcept : record_(record) {}
+
+inline EpochReclaimer::Guard::~Guard() {
+    if (--record_.depth == 0U) {
+        record_.epoch.store(kIdle, std::memory_order_release);
+    }
+}
+
+inline EpochReclaimer::EpochReclaimer() : registry_(std::make_shared<Registry>()) {
+    // Ids are never reused, so a thread's claim on a destroyed reclaimer
+    // cannot match a new one allocated at the same address.
+    static std::atomic<std::uint64_t> next_id{1};
+    id_ = next_id.fetch_add(1U, std::memory_order_relaxed);
+}
+
+inline EpochReclaimer::~EpochReclaimer() {
+    for (Record* record = registry_->head.load(std::memory_order_acquire); record != nullptr;
+         record = record->next) {
+        Destroy(record->retired);
+    }
+    Destroy(shared_retired_);
+}
+
+inline EpochReclaimer::Guard EpochReclaimer::Pin() {
+    Record& record = LocalRecord();
+    if (record.depth++ == 0U) {
+        // The acquire load pairs with Retire's increment: a thread that pins
+        // at a newer epoch than an object's stamp also sees its unlink. The
+        // fence orders the announcement before every load of the traversal;
+        // ReclaimRecord has the matching fence.
+        record.epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    return Guard(record);
+}
+
+template <typename T>
+void EpochReclaimer::Retire(T* const object) {
+    Record& record = LocalRecord();
+    const std::uint64_t epoch = epoch_.fetch_add(1U, std::memory_order_acq_rel);
+    record.retired.push_back(Retired{object, [](void* retired) { delete static_cast<T*>(retired); }, epoch});
+    if (record.retired.size() % kReclaimInterval == 0U) {
+        ReclaimRecord(record);
+    }
+}
+
+inline void EpochReclaimer::Reclaim() {
+    ReclaimRecord(LocalRecord());
+}
+
+template <typename T>
+void EpochReclaimer::RetireShared(T* const object) {
+    std::scoped_lock lock(shared_mutex_);
+    const std::uint64_t epoch = epoch_.fetch_add(1U, std::memory_order_acq_rel);
+    shared_retired_.push_back(Retired{object, [](void* retired) { delete static_cast<T*>(retired); }, epoch});
+    shared_pending_.store(true, std::memory_order_release);
+}
+
+inline void EpochReclaimer::ReclaimShared() {
+    if (!shared_pending_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<Retired> reclaimable;
+    {
+        std::unique_lock lock(shared_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        reclaimable = TakeUnreachable(shared_retired_);
+        shared_pending_.store(!shared_retired_.empty(), std::memory_order_release);
+    }
+    // Outside the lock: a destructor may retire or reclaim in turn.
+    Destroy(reclaimable);
+}
+
+inline EpochReclaimer::Record& EpochReclaimer::LocalRecord() {
+    struct Claim {
+        std::uint64_t owner;
+        std::weak_ptr<Registry> registry;
+        Record* record;
+    };
+    // Hands every claimed record back when the thread exits, unless its
+    // reclaimer is already gone.
+    struct ThreadClaims {
+        ~ThreadClaims() {
+            for (const Claim& claim : claims) {
+                if (const std::shared_ptr<Registry> registry = claim.registry.lock()) {
+                    claim.record->in_use.store(false, std::memory_order_release);
+                }
+            }
+        }
+
+        std::vector<Claim> claims;
+    };
+
+    thread_local ThreadClaims local;
+    for (const Claim& claim : local.claims) {
+        if (claim.owner == id_) {
+            return *claim.record;
+        }
+    }
+
+    std::erase_if(local.claims, [](const Claim& claim) { return claim.registry.expired(); });
+    Record& record = ClaimRecord();
+    local.claims.push_back(Claim{id_, registry_, &record});
+    return record;
+}
+
+inline EpochReclaimer::Record& EpochReclaimer::ClaimRecord() {
+    for (Record* record = registry_->head.load(std::memory_order_acquire); record != nullptr;
+         record = record->next) {
+        bool expected = false;
+        if (!record->in_use.load(std::memory_order_relaxed) &&
+            record->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return *record;
+        }
+    }
+
+    auto record = std::make_unique<Record>();
+    record->in_use.store(true, std::memory_order_relaxed);
+    Record* head = registry_->head.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!registry_->head.compare_exchange_weak(head, record.get(), std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    return *record.release();
+}
+
+inline void EpochReclaimer::ReclaimRecord(Record& record) {
+    std::vector<Retired> reclaimable = TakeUnreachable(record.retired);
+    Destroy(reclaimable);
+}
+
+inline std::vector<EpochReclaimer::Retired> EpochReclaimer::TakeUnreachable(std::vector<Retired>& retired) {
+    // Pairs with the fence in Pin: either this pass sees a thread's pinned
+    // epoch, or that thread's traversal sees every unlink made before it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::uint64_t oldest = kIdle;
+    for (const Record* record = registry_->head.load(std::memory_order_acquire); record != nullptr;
+         record = record->next) {
+        oldest = std::min(oldest, record->epoch.load(std::memory_order_acquire));
+    }
+
+    const auto reachable = std::partition(retired.begin(), retired.end(),
+                                          [oldest](const Retired& object) { return object.epoch >= oldest; });
+    std::vector<Retired> reclaimable(reachable, retired.end());
+    retired.erase(reachable, retired.end());
+    return reclaimable;
+}
+
+inline void EpochReclaimer::Destroy(std::vector<Retired>& retired) noexcept {
+    for (const Retired& object : retired) {
+        object.destroy(object.object);
+    }
+    retired.clear();
+}
+
+#endif  // SHARDED_LRU_CACHE_EPOCHRECLAIMER_CPP
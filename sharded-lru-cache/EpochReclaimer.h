@@ -0,0 +1,124 @@
+#ifndef SHARDED_LRU_CACHE_EPOCHRECLAIMER_H
+#define SHARDED_LRU_CACHE_EPOCHRECLAIMER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation for structures whose readers take no locks.
+// - A reader pins the calling thread for the duration of a traversal. Pinning
+//   publishes the global epoch in the thread's record; it never waits.
+// - A writer unlinks an object first and then retires it. Retiring stamps the
+//   object with the current epoch and advances the epoch.
+// - A retired object is freed once every pinned thread's epoch is newer than
+//   its stamp: such a thread pinned after the unlink and cannot reach it.
+// Each thread claims one record per reclaimer on first use and hands it back
+// when it exits, so records are reused across short-lived threads. Retired
+// objects queue in the retiring thread's record, so retiring takes no lock;
+// objects left behind by an exited thread are freed by the next thread to
+// claim its record, or by the destructor. RetireShared queues an object in a
+// list under a mutex instead, where any thread's ReclaimShared can free it.
+class EpochReclaimer final {
+private:
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        std::uint64_t epoch;
+    };
+
+    struct alignas(64) Record {
+        // Epoch the owning thread pinned at, or kIdle.
+        std::atomic<std::uint64_t> epoch{kIdle};
+        std::atomic<bool> in_use{false};
+        // Nesting depth of Pin; only touched by the owning thread.
+        std::uint32_t depth = 0;
+        // Objects this record's threads retired; only touched by the owner.
+        std::vector<Retired> retired;
+        Record* next = nullptr;
+    };
+
+    // Outlives the reclaimer while a thread-exit handler may still release a
+    // record into it.
+    struct Registry {
+        Registry() = default;
+        ~Registry();
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        std::atomic<Record*> head{nullptr};
+    };
+
+public:
+    // Keeps the calling thread pinned until destroyed. Guards may nest.
+    class Guard final {
+    public:
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        friend class EpochReclaimer;
+
+        explicit Guard(Record& record) noexcept;
+
+        Record& record_;
+    };
+
+    EpochReclaimer();
+    // Frees everything still retired; no thread may be pinned.
+    ~EpochReclaimer();
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    EpochReclaimer(EpochReclaimer&&) = delete;
+    EpochReclaimer& operator=(EpochReclaimer&&) = delete;
+
+    [[nodiscard]] Guard Pin();
+    // Schedules `delete object` for when no pinned thread can reach it. The
+    // caller must already have unlinked `object` from the shared structure.
+    template <typename T>
+    void Retire(T* object);
+    // Frees the calling thread's retired objects that no pinned thread can
+    // still reach.
+    void Reclaim();
+    // Retire, for rare objects that should not wait for the retiring thread
+    // to come back: `object` is freed by whichever thread next calls
+    // ReclaimShared once it is unreachable.
+    template <typename T>
+    void RetireShared(T* object);
+    // Frees the shared retired objects that no pinned thread can still reach.
+    // Costs one load when there are none; returns at once if another thread
+    // is already reclaiming them.
+    void ReclaimShared();
+
+private:
+    static constexpr std::uint64_t kIdle = std::numeric_limits<std::uint64_t>::max();
+    // Retires per thread between reclaim passes.
+    static constexpr std::size_t kReclaimInterval = 64;
+
+    [[nodiscard]] Record& LocalRecord();
+    [[nodiscard]] Record& ClaimRecord();
+    // Frees the objects in `record` older than every pinned epoch.
+    void ReclaimRecord(Record& record);
+    // Moves the objects in `retired` older than every pinned epoch out.
+    [[nodiscard]] std::vector<Retired> TakeUnreachable(std::vector<Retired>& retired);
+    static void Destroy(std::vector<Retired>& retired) noexcept;
+
+    std::uint64_t id_;
+    std::shared_ptr<Registry> registry_;
+    std::atomic<std::uint64_t> epoch_{0};
+    // Objects from RetireShared; `shared_pending_` is set while any remain.
+    std::mutex shared_mutex_;
+    std::vector<Retired> shared_retired_;
+    std::atomic<bool> shared_pending_{false};
+};
+
+#include "EpochReclaimer.cpp"
+
+#endif  // SHARDED_LRU_CACHE_EPOCHRECLAIMER_H
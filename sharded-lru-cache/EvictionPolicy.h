@@ -0,0 +1,61 @@
+#ifndef SHARDED_LRU_CACHE_EVICTIONPOLICY_H
+#define SHARDED_LRU_CACHE_EVICTIONPOLICY_H
+
+#include <concepts>
+#include <cstddef>
+
+// Interface every eviction policy plugged into LRUCache must satisfy.
+// The cache owns keys and values; a policy only orders entries:
+// - OnInsert(key) starts tracking a new resident key and returns a handle the
+//   cache stores beside the value. `key` refers to the cache's own index node
+//   and stays valid until OnEvict/OnRemove is called for that handle.
+// - OnAccess(handle) records a hit.
+// - Victim() names the resident key to evict next. The cache calls it only
+//   while at least one key is resident and immediately follows with OnEvict.
+// - OnEvict(handle) stops tracking a key removed for capacity (policies may
+//   keep a ghost copy of the key); OnRemove(handle) stops tracking a key
+//   removed for any other reason.
+template <typename Policy, typename Key>
+concept EvictionPolicy =
+    std::constructible_from<Policy, std::size_t> &&
+    requires(Policy policy, const Key& key, typename Policy::Handle handle) {
+        { policy.OnInsert(key) } -> std::same_as<typename Policy::Handle>;
+        policy.OnAccess(handle);
+        { policy.Victim() } -> std::same_as<const Key&>;
+        policy.OnEvict(handle);
+        policy.OnRemove(handle);
+        policy.Clear();
+    };
+
+// Policies whose OnAccess only touches atomics may be driven from many readers
+// at once. They opt in with `static constexpr bool kConcurrentAccess = true`,
+// which lets ShardedLRUCache serve Get under a shared lock.
+template <typename Policy, typename Key>
+concept ConcurrentAccessPolicy =
+    EvictionPolicy<Policy, Key> &&
+    requires(const Policy& policy, typename Policy::Handle handle) {
+        requires Policy::kConcurrentAccess;
+        policy.OnAccess(handle);
+    };
+
+// Concurrent-access policies that only record hits and apply them later in a
+// batch. NeedsDrain() is safe to poll without a lock; Drain() needs the
+// shard's exclusive lock.
+template <typename Policy, typename Key>
+concept BufferedAccessPolicy =
+    ConcurrentAccessPolicy<Policy, Key> &&
+    requires(Policy policy, const Policy& const_policy) {
+        { const_policy.NeedsDrain() } -> std::same_as<bool>;
+        policy.Drain();
+    };
+
+// Policies that can list their resident keys in eviction order, next victim
+// first, opt in with ForEachColdestFirst(visitor(const Key&)). Snapshots use
+// it to save entries in recency order.
+template <typename Policy, typename Key>
+concept OrderedPolicy =
+    EvictionPolicy<Policy, Key> && requires(const Policy& policy, void (*visitor)(const Key&)) {
+        policy.ForEachColdestFirst(visitor);
+    };
+
+#endif  // SHARDED_LRU_CACHE_EVICTIONPOLICY_H
@@ -0,0 +1,100 @@
+#ifndef SHARDED_LRU_CACHE_EXECUTOR_CPP
+#define SHARDED_LRU_CACHE_EXECUTOR_CPP
+
+#include "Executor.h"
+
+#include <type_traits>
+#include <utility>
+
+inline void RunLoop::Post(const std::coroutine_handle<> handle) {
+    // Notified under the lock: once it is released, the posted coroutine
+    // may run and finish the last task, and Run's caller may destroy the
+    // loop.
+    std::scoped_lock lock(mutex_);
+    ready_.push_back(handle);
+    posted_.notify_one();
+}
+
+inline void RunLoop::Spawn(Task<void> task) {
+    {
+        std::scoped_lock lock(mutex_);
+        ++live_;
+    }
+    Launch(*this, std::move(task));
+}
+
+template <typename T>
+T RunLoop::Run(Task<T> task) {
+    std::exception_ptr error;
+    if constexpr (std::is_void_v<T>) {
+        Spawn(Capture(std::move(task), error));
+        Run();
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    } else {
+        std::optional<T> result;
+        Spawn(Capture(std::move(task), result, error));
+        Run();
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+}
+
+inline RunLoop::Detached RunLoop::Launch(RunLoop& loop, Task<void> task) {
+    // Queued rather than run inline, so Spawn never runs user code.
+    co_await Reschedule(loop);
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        // Spawned tasks have nobody to report to.
+    }
+    loop.Finish();
+}
+
+template <typename T>
+Task<void> RunLoop::Capture(Task<T> task, std::optional<T>& result, std::exception_ptr& error) {
+    try {
+        result.emplace(co_await std::move(task));
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+inline Task<void> RunLoop::Capture(Task<void> task, std::exception_ptr& error) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+inline void RunLoop::Finish() {
+    // A task may finish on another thread, e.g. one that resumed it with a
+    // loaded value. Run may return, and the loop be destroyed, as soon as
+    // the lock is released, so nothing touches the loop after that.
+    std::scoped_lock lock(mutex_);
+    if (--live_ == 0U) {
+        posted_.notify_all();
+    }
+}
+
+inline void RunLoop::Run() {
+    for (;;) {
+        std::coroutine_handle<> next;
+        {
+            std::unique_lock lock(mutex_);
+            posted_.wait(lock, [this] { return !ready_.empty() || live_ == 0U; });
+            if (ready_.empty()) {
+                return;
+            }
+            next = ready_.front();
+            ready_.pop_front();
+        }
+        next.resume();
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_EXECUTOR_CPP
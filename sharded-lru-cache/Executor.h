@@ -0,0 +1,90 @@
+#ifndef SHARDED_LRU_CACHE_EXECUTOR_H
+#define SHARDED_LRU_CACHE_EXECUTOR_H
+
+#include "Task.h"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+// Where suspended coroutines are resumed. Post may be called from any
+// thread; the executor decides which thread resumes `handle`, and when.
+// Services plug their own scheduler in by implementing Post.
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    virtual void Post(std::coroutine_handle<> handle) = 0;
+};
+
+// `co_await Reschedule(executor)` suspends the caller and posts it to
+// `executor`: a yield if the caller already runs there, a hop otherwise.
+class Reschedule final {
+public:
+    explicit Reschedule(Executor& executor) noexcept : executor_(executor) {}
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const { executor_.Post(handle); }
+    void await_resume() const noexcept {}
+
+private:
+    Executor& executor_;
+};
+
+// Minimal executor: one FIFO of ready coroutines, run by whichever thread
+// calls Run. Handles posted from other threads (say, by a loader finishing
+// there) wake the loop. Meant for tests and examples; a loop must not be
+// destroyed while coroutines are queued on it or suspended waiting for it.
+class RunLoop final : public Executor {
+public:
+    RunLoop() = default;
+
+    RunLoop(const RunLoop&) = delete;
+    RunLoop& operator=(const RunLoop&) = delete;
+
+    void Post(std::coroutine_handle<> handle) override;
+    // Starts `task` on the loop; it runs during the next Run. Its result
+    // and any exception it throws are dropped.
+    void Spawn(Task<void> task);
+    // Resumes coroutines on the calling thread, sleeping while none is
+    // ready, until every spawned task has finished.
+    void Run();
+    // Spawns `task`, runs the loop, and returns the result of `task` or
+    // rethrows its exception.
+    template <typename T>
+    T Run(Task<T> task);
+
+private:
+    // Coroutine that starts at once and frees itself when it finishes.
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            // Only Post can throw here (out of memory); the loop could not
+            // account for the task any more.
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    static Detached Launch(RunLoop& loop, Task<void> task);
+    template <typename T>
+    static Task<void> Capture(Task<T> task, std::optional<T>& result, std::exception_ptr& error);
+    static Task<void> Capture(Task<void> task, std::exception_ptr& error);
+    void Finish();
+
+    std::mutex mutex_;
+    std::condition_variable posted_;
+    std::deque<std::coroutine_handle<>> ready_;
+    // Spawned tasks that have not finished yet.
+    std::size_t live_ = 0;
+};
+
+#include "Executor.cpp"
+
+#endif  // SHARDED_LRU_CACHE_EXECUTOR_H
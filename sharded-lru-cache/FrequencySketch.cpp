@@ -0,0 +1,85 @@
+#ifndef SHARDED_LRU_CACHE_FREQUENCYSKETCH_CPP
+#define SHARDED_LRU_CACHE_FREQUENCYSKETCH_CPP
+
+#include "FrequencySketch.h"
+
+#include <algorithm>
+#include <bit>
+
+// One 64-bit word holds sixteen counters; one word per cached entry gives each
+// row about four counters per entry, which keeps collisions rare (8 bytes/entry).
+template <typename Key>
+FrequencySketch<Key>::FrequencySketch(const std::size_t capacity)
+    : sample_size_(std::max<std::size_t>(capacity, 1U) * 10U) {
+    const std::size_t words = std::bit_ceil(std::max(capacity, kWordsPerBlock));
+    table_.assign(words, 0U);
+    block_mask_ = (words / kWordsPerBlock) - 1U;
+}
+
+template <typename Key>
+void FrequencySketch<Key>::Increment(const Key& key) {
+    const std::uint64_t hash = HashOf(key);
+    bool added = false;
+    for (std::size_t row = 0; row < kDepth; ++row) {
+        std::uint64_t& word = table_[WordIndex(hash, row)];
+        const std::size_t shift = CounterShift(hash, row);
+        if (((word >> shift) & 0xFU) != 0xFU) {
+            word += std::uint64_t{1} << shift;
+            added = true;
+        }
+    }
+
+    if (added && ++additions_ >= sample_size_) {
+        Age();
+    }
+}
+
+template <typename Key>
+std::uint8_t FrequencySketch<Key>::Estimate(const Key& key) const {
+    const std::uint64_t hash = HashOf(key);
+    std::uint64_t estimate = 0xFU;
+    for (std::size_t row = 0; row < kDepth; ++row) {
+        const std::uint64_t word = table_[WordIndex(hash, row)];
+        estimate = std::min(estimate, (word >> CounterShift(hash, row)) & 0xFU);
+    }
+
+    return static_cast<std::uint8_t>(estimate);
+}
+
+template <typename Key>
+void FrequencySketch<Key>::Clear() noexcept {
+    std::fill(table_.begin(), table_.end(), 0U);
+    additions_ = 0;
+}
+
+template <typename Key>
+std::uint64_t FrequencySketch<Key>::HashOf(const Key& key) {
+    // Offset before mixing so the sketch's bits are independent of the mixed
+    // hash ShardedLRUCache already consumed to pick this shard.
+    return MixHash(static_cast<std::uint64_t>(std::hash<Key>{}(key)) + 0x9e3779b97f4a7c15ULL);
+}
+
+template <typename Key>
+std::size_t FrequencySketch<Key>::WordIndex(const std::uint64_t hash,
+                                            const std::size_t row) const noexcept {
+    // Low bits pick the block; rows use disjoint word pairs inside it.
+    const std::size_t block = static_cast<std::size_t>(hash) & block_mask_;
+    const std::size_t word = (row << 1U) | static_cast<std::size_t>((hash >> (32U + row)) & 1U);
+    return (block * kWordsPerBlock) + word;
+}
+
+template <typename Key>
+std::size_t FrequencySketch<Key>::CounterShift(const std::uint64_t hash,
+                                               const std::size_t row) noexcept {
+    return static_cast<std::size_t>((hash >> (40U + (row * 4U))) & 0xFU) * 4U;
+}
+
+template <typename Key>
+void FrequencySketch<Key>::Age() noexcept {
+    for (std::uint64_t& word : table_) {
+        word = (word >> 1U) & 0x7777777777777777ULL;
+    }
+    additions_ /= 2U;
+}
+
+#endif  // SHARDED_LRU_CACHE_FREQUENCYSKETCH_CPP
@@ -0,0 +1,42 @@
+#ifndef SHARDED_LRU_CACHE_FREQUENCYSKETCH_H
+#define SHARDED_LRU_CACHE_FREQUENCYSKETCH_H
+
+#include "HashMix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Count-min sketch of 4-bit counters used to estimate key popularity.
+// - Four rows; all four counters of a key live in one 64-byte block, so an
+//   update or estimate touches a single cache line.
+// - Counters saturate at 15. After 10 * capacity increments every counter is
+//   halved, so the estimate tracks recent rather than all-time frequency.
+template <typename Key>
+class FrequencySketch final {
+public:
+    explicit FrequencySketch(std::size_t capacity);
+
+    void Increment(const Key& key);
+    [[nodiscard]] std::uint8_t Estimate(const Key& key) const;
+    void Clear() noexcept;
+
+private:
+    static constexpr std::size_t kWordsPerBlock = 8;
+    static constexpr std::size_t kDepth = 4;
+
+    [[nodiscard]] static std::uint64_t HashOf(const Key& key);
+    [[nodiscard]] std::size_t WordIndex(std::uint64_t hash, std::size_t row) const noexcept;
+    [[nodiscard]] static std::size_t CounterShift(std::uint64_t hash, std::size_t row) noexcept;
+    void Age() noexcept;
+
+    std::vector<std::uint64_t> table_;
+    std::size_t block_mask_;
+    std::size_t sample_size_;
+    std::size_t additions_ = 0;
+};
+
+#include "FrequencySketch.cpp"
+
+#endif  // SHARDED_LRU_CACHE_FREQUENCYSKETCH_H
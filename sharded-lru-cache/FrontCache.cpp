@@ -0,0 +1,63 @@
+#ifndef SHARDED_LRU_CACHE_FRONTCACHE_CPP
+#define SHARDED_LRU_CACHE_FRONTCACHE_CPP
+
+#include "FrontCache.h"
+
+template <typename Key, typename Value, std::size_t Slots>
+template <typename K>
+typename FrontCache<Key, Value, Slots>::Slot* FrontCache<Key, Value, Slots>::Find(const std::uint64_t owner,
+                                                                                  const std::uint64_t hash,
+                                                                                  const K& key) {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+
+    const std::size_t set = SetIndex(hash);
+    for (std::size_t way = 0; way < 2U; ++way) {
+        Slot& slot = slots_[set * 2U + way];
+        // The full hash is compared first so most mismatches skip the key.
+        if (slot.owner == owner && slot.hash == hash && slot.entry->first == key) {
+            recent_way_[set] = static_cast<std::uint8_t>(way);
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Key, typename Value, std::size_t Slots>
+void FrontCache<Key, Value, Slots>::Store(const std::uint64_t owner, const std::uint64_t hash,
+                                          const std::uint64_t version, Key key, Value value) {
+    if (slots_.empty()) {
+        slots_.resize(Slots);
+        recent_way_.resize(kSets, 0U);
+    }
+
+    const std::size_t set = SetIndex(hash);
+    std::size_t way = recent_way_[set] == 0U ? 1U : 0U;
+    for (std::size_t candidate = 0; candidate < 2U; ++candidate) {
+        const Slot& slot = slots_[set * 2U + candidate];
+        if (slot.owner == 0U || (slot.owner == owner && slot.hash == hash && slot.entry->first == key)) {
+            way = candidate;
+            break;
+        }
+    }
+
+    Slot& slot = slots_[set * 2U + way];
+    // Emptied first, so a throwing copy leaves a free slot behind.
+    slot.owner = 0U;
+    slot.entry.emplace(std::move(key), std::move(value));
+    slot.owner = owner;
+    slot.hash = hash;
+    slot.version = version;
+    slot.hits = 0U;
+    recent_way_[set] = static_cast<std::uint8_t>(way);
+}
+
+template <typename Key, typename Value, std::size_t Slots>
+std::size_t FrontCache<Key, Value, Slots>::SetIndex(const std::uint64_t hash) noexcept {
+    // Shard selection consumes the low bits (mask) or the top bits
+    // (multiply-shift), so sets are picked from the middle of the hash.
+    return static_cast<std::size_t>(hash >> 24U) & (kSets - 1U);
+}
+
+#endif  // SHARDED_LRU_CACHE_FRONTCACHE_CPP
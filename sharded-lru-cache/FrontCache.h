@@ -0,0 +1,60 @@
+#ifndef SHARDED_LRU_CACHE_FRONTCACHE_H
+#define SHARDED_LRU_CACHE_FRONTCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Small 2-way set-associative table of entry copies, owned by one thread and
+// used by ShardedLRUCache as an L1 in front of its shards.
+// - Not thread-safe: each thread keeps its own table per cache type, so a
+//   lookup touches no shared memory except the version it validates against.
+// - Every copy is tagged with the owning cache's id and with the version of
+//   the shard it came from; the owner decides whether that is still current.
+// - Slots are allocated on the first Store, so threads that only write pay
+//   nothing.
+template <typename Key, typename Value, std::size_t Slots = 256>
+class FrontCache final {
+    static_assert(Slots >= 2U && (Slots & (Slots - 1U)) == 0U,
+                  "FrontCache slot count must be a power of two");
+
+public:
+    struct Slot {
+        // Zero marks an empty slot; owner ids start at one.
+        std::uint64_t owner = 0;
+        std::uint64_t hash = 0;
+        std::uint64_t version = 0;
+        // Hits served from this copy since it was stored.
+        std::uint32_t hits = 0;
+        std::optional<std::pair<Key, Value>> entry;
+    };
+
+    // The slot holding `key` for cache `owner`, or nullptr.
+    template <typename K>
+    [[nodiscard]] Slot* Find(std::uint64_t owner, std::uint64_t hash, const K& key);
+    // Stores a copy, replacing the same key or else the less recently used way.
+    void Store(std::uint64_t owner, std::uint64_t hash, std::uint64_t version, Key key, Value value);
+
+private:
+    static constexpr std::size_t kSets = Slots / 2U;
+
+    [[nodiscard]] static std::size_t SetIndex(std::uint64_t hash) noexcept;
+
+    std::vector<Slot> slots_;
+    // Per set, the way that was used last.
+    std::vector<std::uint8_t> recent_way_;
+};
+
+// Id tagging one cache's front-cache copies; ids are never reused, so a new
+// cache at a dead one's address cannot match its leftover copies.
+[[nodiscard]] inline std::uint64_t NextFrontCacheOwner() noexcept {
+    static std::atomic<std::uint64_t> next{1};
+    return next.fetch_add(1U, std::memory_order_relaxed);
+}
+
+#include "FrontCache.cpp"
+
+#endif  // SHARDED_LRU_CACHE_FRONTCACHE_H
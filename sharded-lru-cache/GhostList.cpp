@@ -0,0 +1,77 @@
+#ifndef SHARDED_LRU_CACHE_GHOSTLIST_CPP
+#define SHARDED_LRU_CACHE_GHOSTLIST_CPP
+
+#include "GhostList.h"
+
+template <typename Key>
+GhostList<Key>::GhostList(const std::size_t limit) : limit_(limit) {}
+
+template <typename Key>
+bool GhostList<Key>::Contains(const Key& key) const {
+    return index_.find(key) != index_.end();
+}
+
+template <typename Key>
+bool GhostList<Key>::Erase(const Key& key) {
+    const auto found = index_.find(key);
+    if (found == index_.end()) {
+        return false;
+    }
+
+    order_.erase(found->second);
+    index_.erase(found);
+    return true;
+}
+
+template <typename Key>
+void GhostList<Key>::Push(const Key& key) {
+    if (limit_ == 0U) {
+        return;
+    }
+
+    const auto [found, inserted] = index_.try_emplace(key);
+    if (!inserted) {
+        order_.splice(order_.begin(), order_, found->second);
+        return;
+    }
+
+    // The list points at the index node's key, so each ghost stores one copy.
+    try {
+        order_.push_front(&found->first);
+    } catch (...) {
+        index_.erase(found);
+        throw;
+    }
+    found->second = order_.begin();
+}
+
+template <typename Key>
+void GhostList<Key>::PopOldest() noexcept {
+    if (order_.empty()) {
+        return;
+    }
+
+    const auto oldest = index_.find(*order_.back());
+    order_.pop_back();
+    index_.erase(oldest);
+}
+
+template <typename Key>
+void GhostList<Key>::Trim() noexcept {
+    while (order_.size() > limit_) {
+        PopOldest();
+    }
+}
+
+template <typename Key>
+std::size_t GhostList<Key>::Size() const noexcept {
+    return order_.size();
+}
+
+template <typename Key>
+void GhostList<Key>::Clear() noexcept {
+    order_.clear();
+    index_.clear();
+}
+
+#endif  // SHARDED_LRU_CACHE_GHOSTLIST_CPP
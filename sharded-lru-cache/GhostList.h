@@ -0,0 +1,36 @@
+#ifndef SHARDED_LRU_CACHE_GHOSTLIST_H
+#define SHARDED_LRU_CACHE_GHOSTLIST_H
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+// Bounded FIFO of recently evicted keys with O(1) membership checks.
+// Policies use it to recognise keys that come back shortly after eviction.
+// Push does not trim: the cache evicts before it inserts, so policies check
+// the incoming key first and call Trim afterwards, mirroring the order in
+// which the original algorithms consult their ghost lists.
+template <typename Key>
+class GhostList final {
+public:
+    explicit GhostList(std::size_t limit);
+
+    [[nodiscard]] bool Contains(const Key& key) const;
+    bool Erase(const Key& key);
+    void Push(const Key& key);
+    void PopOldest() noexcept;
+    void Trim() noexcept;
+    [[nodiscard]] std::size_t Size() const noexcept;
+    void Clear() noexcept;
+
+private:
+    using Order = std::list<const Key*>;
+
+    std::size_t limit_;
+    Order order_;
+    std::unordered_map<Key, typename Order::iterator> index_;
+};
+
+#include "GhostList.cpp"
+
+#endif  // SHARDED_LRU_CACHE_GHOSTLIST_H
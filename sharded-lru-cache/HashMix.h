@@ -0,0 +1,17 @@
+#ifndef SHARDED_LRU_CACHE_HASHMIX_H
+#define SHARDED_LRU_CACHE_HASHMIX_H
+
+#include <cstdint>
+
+// 64-bit finalizer (MurmurHash3 fmix64). std::hash is the identity for
+// integers on libstdc++, so callers that mask or slice hash bits mix first.
+[[nodiscard]] constexpr std::uint64_t MixHash(std::uint64_t hash) noexcept {
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33U;
+    return hash;
+}
+
+#endif  // SHARDED_LRU_CACHE_HASHMIX_H
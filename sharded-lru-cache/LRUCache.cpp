@@ -3,77 +3,526 @@
 
 #include "LRUCache.h"
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>::LRUCache(const std::size_t capacity) : capacity_(capacity) {
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Policy, Weigher>::LRUCache(const std::size_t capacity,
+                                                const std::chrono::milliseconds default_ttl)
+    // Only the entry count binds; the weight budget is left open so
+    // SetCapacity can grow the cache past its initial size.
+    : LRUCache(capacity, std::numeric_limits<std::size_t>::max(), Weigher{}, default_ttl) {}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Policy, Weigher>::LRUCache(const std::size_t capacity, const std::size_t max_weight,
+                                                Weigher weigher,
+                                                const std::chrono::milliseconds default_ttl)
+    : capacity_(capacity),
+      max_weight_(max_weight),
+      weigher_(std::move(weigher)),
+      default_ttl_(default_ttl),
+      epoch_(std::chrono::steady_clock::now()),
+      policy_(capacity) {
     if (capacity_ == 0U) {
         throw std::invalid_argument("LRUCache capacity must be greater than zero");
     }
+    if (max_weight_ == 0U) {
+        throw std::invalid_argument("LRUCache max_weight must be greater than zero");
+    }
+    if (default_ttl_ < std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("LRUCache default_ttl must not be negative");
+    }
 }
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>::LRUCache(LRUCache&& other) noexcept
-    : capacity_(other.capacity_), entries_(std::move(other.entries_)), index_(std::move(other.index_)) {}
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Policy, Weigher>::LRUCache(LRUCache&& other) noexcept
+    : capacity_(other.capacity_),
+      max_weight_(other.max_weight_),
+      weight_(std::exchange(other.weight_, 0U)),
+      evictions_(other.evictions_),
+      weigher_(other.weigher_),
+      default_ttl_(other.default_ttl_),
+      epoch_(other.epoch_),
+      index_(std::move(other.index_)),
+      policy_(std::move(other.policy_)),
+      expiry_(std::move(other.expiry_)),
+      on_remove_(std::move(other.on_remove_)),
+      stamp_writes_(other.stamp_writes_),
+      last_stamp_(other.last_stamp_) {}
 
-template <typename Key, typename Value>
-LRUCache<Key, Value>& LRUCache<Key, Value>::operator=(LRUCache&& other) noexcept {
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+LRUCache<Key, Value, Policy, Weigher>& LRUCache<Key, Value, Policy, Weigher>::operator=(
+    LRUCache&& other) noexcept {
     if (this == &other) {
         return *this;
     }
 
     capacity_ = other.capacity_;
-    entries_ = std::move(other.entries_);
+    max_weight_ = other.max_weight_;
+    weight_ = std::exchange(other.weight_, 0U);
+    evictions_ = other.evictions_;
+    weigher_ = other.weigher_;
+    default_ttl_ = other.default_ttl_;
+    epoch_ = other.epoch_;
     index_ = std::move(other.index_);
+    policy_ = std::move(other.policy_);
+    expiry_ = std::move(other.expiry_);
+    on_remove_ = std::move(other.on_remove_);
+    stamp_writes_ = other.stamp_writes_;
+    last_stamp_ = other.last_stamp_;
     return *this;
 }
 
-template <typename Key, typename Value>
-std::optional<Value> LRUCache<Key, Value>::Get(const Key& key) {
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> LRUCache<Key, Value, Policy, Weigher>::Get(const K& key) {
     const auto found = index_.find(key);
     if (found == index_.end()) {
         return std::nullopt;
     }
+    if (IsExpired(found->second)) {
+        Remove(found, RemovalCause::kExpired);
+        return std::nullopt;
+    }
+
+    policy_.OnAccess(found->second.handle);
+    return found->second.value;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool LRUCache<Key, Value, Policy, Weigher>::GetWith(const K& key, Visitor&& visitor, Stamp* const written) {
+    const auto found = index_.find(key);
+    if (found == index_.end()) {
+        return false;
+    }
+    if (IsExpired(found->second)) {
+        Remove(found, RemovalCause::kExpired);
+        return false;
+    }
+
+    policy_.OnAccess(found->second.handle);
+    std::invoke(visitor, std::as_const(found->second.value));
+    if (written != nullptr) {
+        *written = found->second.written;
+    }
+    return true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename Visitor>
+    requires ConcurrentAccessPolicy<Policy, Key> && LookupKey<K, Key> &&
+             std::invocable<Visitor&, const Value&>
+bool LRUCache<Key, Value, Policy, Weigher>::GetWithShared(const K& key, Visitor&& visitor,
+                                                          Stamp* const written) const {
+    // Expired entries read as misses; removal waits for the next insert,
+    // which holds the exclusive lock.
+    const auto found = index_.find(key);
+    if (found == index_.end() || IsExpired(found->second)) {
+        return false;
+    }
+
+    policy_.OnAccess(found->second.handle);
+    std::invoke(visitor, found->second.value);
+    if (written != nullptr) {
+        *written = found->second.written;
+    }
+    return true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+bool LRUCache<Key, Value, Policy, Weigher>::Contains(const K& key) const {
+    const auto found = index_.find(key);
+    return found != index_.end() && !IsExpired(found->second);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+bool LRUCache<Key, Value, Policy, Weigher>::NeedsDrain() const noexcept
+    requires BufferedAccessPolicy<Policy, Key>
+{
+    return policy_.NeedsDrain();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Drain()
+    requires BufferedAccessPolicy<Policy, Key>
+{
+    policy_.Drain();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Put(const Key& key, const Value& value) {
+    Insert(default_ttl_, key, value);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Put(Key&& key, Value&& value) {
+    Insert(default_ttl_, std::move(key), std::move(value));
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Put(const Key& key, const Value& value,
+                                                const std::chrono::milliseconds ttl) {
+    Insert(ttl, key, value);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Put(Key&& key, Value&& value,
+                                                const std::chrono::milliseconds ttl) {
+    Insert(ttl, std::move(key), std::move(value));
+}
 
-    MoveToFront(found->second);
-    return found->second->second;
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void LRUCache<Key, Value, Policy, Weigher>::Emplace(K&& key, Args&&... args) {
+    Insert(default_ttl_, std::forward<K>(key), std::forward<Args>(args)...);
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::Put(const Key& key, const Value& value) {
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+bool LRUCache<Key, Value, Policy, Weigher>::Erase(const K& key, const RemovalCause cause) {
+    const auto found = index_.find(key);
+    if (found == index_.end()) {
+        return false;
+    }
+
+    Remove(found, cause);
+    return true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename Sink>
+    requires std::invocable<Sink&, Key&&, Value&&, std::chrono::milliseconds>
+std::size_t LRUCache<Key, Value, Policy, Weigher>::Extract(const std::size_t count, Sink&& sink) {
+    ReclaimExpired();
+
+    std::size_t moved = 0;
+    while (moved < count && !index_.empty()) {
+        const auto victim = index_.find(policy_.Victim());
+        std::chrono::milliseconds ttl = std::chrono::milliseconds::zero();
+        const Tick deadline = victim->second.expires_at;
+        if (deadline != kNever) {
+            expiry_.Cancel(victim->second.timer);
+        }
+        policy_.OnEvict(victim->second.handle);
+        weight_ -= victim->second.weight;
+        auto node = index_.extract(victim);
+
+        if (deadline != kNever) {
+            const Tick now = NowTick();
+            if (deadline <= now) {
+                // Expired after the reclaim above; dropped rather than moved.
+                continue;
+            }
+            ttl = std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(deadline - now));
+        }
+        std::invoke(sink, std::move(node.key()), std::move(node.mapped().value), ttl);
+        ++moved;
+    }
+
+    return moved;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename Visitor>
+    requires std::invocable<Visitor&, const Key&, const Value&, std::chrono::milliseconds>
+void LRUCache<Key, Value, Policy, Weigher>::ForEach(Visitor&& visitor) const {
+    const Tick now = NowTick();
+    const auto visit = [&](const Key& key, const Entry& entry) {
+        if (entry.expires_at == kNever) {
+            visitor(key, entry.value, std::chrono::milliseconds::zero());
+        } else if (entry.expires_at > now) {
+            const auto left = static_cast<std::chrono::milliseconds::rep>(entry.expires_at - now);
+            visitor(key, entry.value, std::chrono::milliseconds(left));
+        }
+    };
+
+    if constexpr (OrderedPolicy<Policy, Key>) {
+        policy_.ForEachColdestFirst([&](const Key& key) { visit(key, index_.find(key)->second); });
+    } else {
+        for (const auto& [key, entry] : index_) {
+            visit(key, entry);
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::SetCapacity(const std::size_t capacity) {
+    if (capacity == 0U) {
+        throw std::invalid_argument("LRUCache capacity must be greater than zero");
+    }
+
+    capacity_ = capacity;
+    // Expired entries go first, as on insert.
+    ReclaimExpired();
+    while (index_.size() > capacity_) {
+        EvictOne();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+std::size_t LRUCache<Key, Value, Policy, Weigher>::Capacity() const noexcept {
+    return capacity_;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+bool LRUCache<Key, Value, Policy, Weigher>::HasExpiringEntries() const noexcept {
+    return expiry_.Size() != 0U;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+std::size_t LRUCache<Key, Value, Policy, Weigher>::Size() const noexcept {
+    return index_.size();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+std::size_t LRUCache<Key, Value, Policy, Weigher>::WeightedSize() const noexcept {
+    return weight_;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+std::uint64_t LRUCache<Key, Value, Policy, Weigher>::Evictions() const noexcept {
+    return evictions_;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Clear() {
+    expiry_.Clear();
+    policy_.Clear();
+    weight_ = 0U;
+    if (!on_remove_) {
+        index_.clear();
+        return;
+    }
+
+    while (!index_.empty()) {
+        auto node = index_.extract(index_.begin());
+        Report(std::move(node.key()), std::move(node.mapped().value), node.mapped().expires_at,
+               RemovalCause::kCleared);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::SetRemovalHandler(
+    std::function<void(Key&&, Value&&, std::chrono::milliseconds, RemovalCause)> handler) {
+    on_remove_ = std::move(handler);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::EnableWriteStamps() noexcept {
+    stamp_writes_ = true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<typename LRUCache<Key, Value, Policy, Weigher>::Stamp>
+LRUCache<Key, Value, Policy, Weigher>::WriteStampOf(const K& key) const {
+    if (!stamp_writes_) {
+        return std::nullopt;
+    }
+    const auto found = index_.find(key);
+    if (found == index_.end() || IsExpired(found->second)) {
+        return std::nullopt;
+    }
+    return found->second.written;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+template <typename K, typename... Args>
+void LRUCache<Key, Value, Policy, Weigher>::Insert(const std::chrono::milliseconds ttl, K&& key,
+                                                   Args&&... args) {
+    // Reclaiming first lets expired entries make room before anything live
+    // is evicted for capacity.
+    ReclaimExpired();
+
     const auto found = index_.find(key);
     if (found != index_.end()) {
-        found->second->second = value;
-        MoveToFront(found->second);
+        Entry& entry = found->second;
+        // With a handler, the old value is kept aside to be reported once the
+        // update has succeeded.
+        std::optional<Value> replaced;
+        const Tick replaced_deadline = entry.expires_at;
+        if (on_remove_) {
+            replaced.emplace(std::move(entry.value));
+            try {
+                AssignValue(entry.value, std::forward<Args>(args)...);
+            } catch (...) {
+                entry.value = std::move(*replaced);
+                throw;
+            }
+            Report(Key(found->first), std::move(*replaced), replaced_deadline, RemovalCause::kReplaced);
+        } else {
+            AssignValue(entry.value, std::forward<Args>(args)...);
+        }
+        const std::size_t weight = weigher_(found->first, std::as_const(entry.value));
+        if (weight > max_weight_) {
+            Remove(found, RemovalCause::kCapacity);
+            return;
+        }
+
+        weight_ = weight_ - entry.weight + weight;
+        entry.weight = weight;
+        StampWrite(entry);
+        policy_.OnAccess(entry.handle);
+        SetExpiry(found, ttl);
+        // A policy that does not reorder on access (CLOCK, S3-FIFO) may pick
+        // the updated entry itself; it then leaves like any other victim.
+        while (weight_ > max_weight_) {
+            EvictOne();
+        }
         return;
     }
 
-    entries_.emplace_front(key, value);
-    index_[key] = entries_.begin();
+    // The key is built directly in the index node from whatever form the
+    // caller passed; try_emplace would need a ready-made Key. Eviction runs
+    // before the policy learns about the node, so it never picks the new key.
+    const auto emplaced =
+        index_.emplace(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                       std::forward_as_tuple(std::in_place, std::forward<Args>(args)...));
+    const auto inserted = emplaced.first;
+    std::size_t weight = 0;
+    try {
+        weight = weigher_(inserted->first, std::as_const(inserted->second.value));
+        if (weight > max_weight_) {
+            if (!on_remove_) {
+                index_.erase(inserted);
+                return;
+            }
+            auto node = index_.extract(inserted);
+            Report(std::move(node.key()), std::move(node.mapped().value), kNever, RemovalCause::kCapacity);
+            return;
+        }
 
-    if (index_.size() > capacity_) {
-        const Key lru_key = entries_.back().first;
-        entries_.pop_back();
-        index_.erase(lru_key);
+        while (index_.size() > capacity_ || weight > max_weight_ - weight_) {
+            EvictOne();
+        }
+        inserted->second.handle = policy_.OnInsert(inserted->first);
+    } catch (...) {
+        index_.erase(inserted);
+        throw;
+    }
+    inserted->second.weight = weight;
+    weight_ += weight;
+    StampWrite(inserted->second);
+    try {
+        SetExpiry(inserted, ttl);
+    } catch (...) {
+        weight_ -= weight;
+        policy_.OnRemove(inserted->second.handle);
+        index_.erase(inserted);
+        throw;
     }
 }
 
-template <typename Key, typename Value>
-std::size_t LRUCache<Key, Value>::Size() const noexcept {
-    return index_.size();
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+typename LRUCache<Key, Value, Policy, Weigher>::Tick LRUCache<Key, Value, Policy, Weigher>::NowTick()
+    const noexcept {
+    const auto elapsed = std::chrono::steady_clock::now() - epoch_;
+    return static_cast<Tick>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+bool LRUCache<Key, Value, Policy, Weigher>::IsExpired(const Entry& entry) const noexcept {
+    // Entries without a TTL never read the clock.
+    return entry.expires_at != kNever && entry.expires_at <= NowTick();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::SetExpiry(const typename Index::iterator entry,
+                                                      const std::chrono::milliseconds ttl) {
+    Entry& target = entry->second;
+    if (target.expires_at != kNever) {
+        expiry_.Cancel(target.timer);
+        target.expires_at = kNever;
+    }
+    if (ttl <= std::chrono::milliseconds::zero()) {
+        return;
+    }
+
+    const Tick deadline = NowTick() + static_cast<Tick>(ttl.count());
+    target.timer = expiry_.Schedule(entry->first, deadline);
+    target.expires_at = deadline;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::ReclaimExpired() {
+    if (expiry_.Size() == 0U) {
+        return;
+    }
+
+    expiry_.Advance(NowTick(), [this](const Key& key) {
+        const auto expired = index_.find(key);
+        // The wheel already dropped its node; only the entry is left.
+        expired->second.expires_at = kNever;
+        Remove(expired, RemovalCause::kExpired);
+    });
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::Clear() noexcept {
-    index_.clear();
-    entries_.clear();
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Remove(const typename Index::iterator entry,
+                                                   const RemovalCause cause) {
+    const Tick deadline = entry->second.expires_at;
+    if (deadline != kNever) {
+        expiry_.Cancel(entry->second.timer);
+    }
+    policy_.OnRemove(entry->second.handle);
+    weight_ -= entry->second.weight;
+    if (!on_remove_) {
+        index_.erase(entry);
+        return;
+    }
+
+    auto node = index_.extract(entry);
+    Report(std::move(node.key()), std::move(node.mapped().value), deadline, cause);
 }
 
-template <typename Key, typename Value>
-void LRUCache<Key, Value>::MoveToFront(const NodeIterator iterator) noexcept {
-    if (iterator == entries_.begin()) {
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::EvictOne() {
+    const auto victim = index_.find(policy_.Victim());
+    const Tick deadline = victim->second.expires_at;
+    if (deadline != kNever) {
+        expiry_.Cancel(victim->second.timer);
+    }
+    policy_.OnEvict(victim->second.handle);
+    weight_ -= victim->second.weight;
+    ++evictions_;
+    if (!on_remove_) {
+        index_.erase(victim);
         return;
     }
 
-    entries_.splice(entries_.begin(), entries_, iterator);
+    auto node = index_.extract(victim);
+    Report(std::move(node.key()), std::move(node.mapped().value), deadline, RemovalCause::kCapacity);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::Report(Key&& key, Value&& value, const Tick deadline,
+                                                   RemovalCause cause) {
+    std::chrono::milliseconds ttl = std::chrono::milliseconds::zero();
+    if (deadline != kNever) {
+        const Tick now = NowTick();
+        if (deadline <= now) {
+            cause = RemovalCause::kExpired;
+        } else {
+            ttl = std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(deadline - now));
+        }
+    }
+    on_remove_(std::move(key), std::move(value), ttl, cause);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher>
+void LRUCache<Key, Value, Policy, Weigher>::StampWrite(Entry& entry) noexcept {
+    if (!stamp_writes_) {
+        return;
+    }
+    // Two writes in one clock tick still get distinct stamps.
+    last_stamp_ = std::max(std::chrono::steady_clock::now(), last_stamp_ + Stamp::duration(1));
+    entry.written = last_stamp_;
 }
 
 #endif  // SHARDED_LRU_CACHE_LRUCACHE_CPP
@@ -1,18 +1,47 @@
 #ifndef SHARDED_LRU_CACHE_LRUCACHE_H
 #define SHARDED_LRU_CACHE_LRUCACHE_H
 
+#include "CacheTraits.h"
+#include "EvictionPolicy.h"
+#include "LruPolicy.h"
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
 #include <cstddef>
-#include <list>
+#include <cstdint>
+#include <limits>
+#include <functional>
 #include <optional>
+#include <tuple>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
 
-// Non-thread-safe LRU cache intended for composition inside a sharded wrapper.
-template <typename Key, typename Value>
+// Non-thread-safe cache intended for composition inside a sharded wrapper.
+// Keys and values live in the hash index; the eviction policy only orders
+// them (see EvictionPolicy.h). The default policy is strict LRU.
+// Entries may carry a TTL (millisecond resolution). Deadlines live in a
+// TimingWheel: expired entries read as misses, are removed when an exclusive
+// lookup touches them, and are reclaimed in bulk at the start of every insert.
+// Capacity bounds the entry count. A weighted cache also bounds the summed
+// Weigher(key, value) of its entries, evicting policy victims until both fit.
+template <typename Key, typename Value, EvictionPolicy<Key> Policy = LruPolicy<Key>,
+          EntryWeigher<Key, Value> Weigher = UnitWeigher>
 class LRUCache final {
 public:
-    explicit LRUCache(std::size_t capacity);
+    // When a write happened; see EnableWriteStamps.
+    using Stamp = std::chrono::steady_clock::time_point;
+
+    // `default_ttl` applies to Put/Emplace without an explicit TTL; zero
+    // means entries never expire.
+    explicit LRUCache(std::size_t capacity,
+                      std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
+    // Weighted cache: at most `capacity` entries (which also sizes the
+    // policy) whose weights sum to at most `max_weight`.
+    LRUCache(std::size_t capacity, std::size_t max_weight, Weigher weigher = {},
+             std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
     ~LRUCache() = default;
 
     LRUCache(const LRUCache&) = delete;
@@ -20,21 +49,143 @@ public:
     LRUCache(LRUCache&& other) noexcept;
     LRUCache& operator=(LRUCache&& other) noexcept;
 
-    [[nodiscard]] std::optional<Value> Get(const Key& key);
+    // Lookups take Key or, for std::string keys, std::string_view/const char*
+    // without allocating (see CacheTraits.h).
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    // Runs `visitor(const Value&)` on the stored value in place and records
+    // the hit. Returns false on a miss. On a hit, `written` (if given)
+    // receives the entry's write stamp.
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor, Stamp* written = nullptr);
+    // Lookup that only reads shared state; callers may run it concurrently
+    // with other GetWithShared calls (but not with mutations).
+    template <typename K = Key, typename Visitor>
+        requires ConcurrentAccessPolicy<Policy, Key> && LookupKey<K, Key> &&
+                 std::invocable<Visitor&, const Value&>
+    bool GetWithShared(const K& key, Visitor&& visitor, Stamp* written = nullptr) const;
+    // Presence check that does not record a hit; safe under a shared lock.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    // Replays hits a buffered policy recorded during GetWithShared.
+    [[nodiscard]] bool NeedsDrain() const noexcept
+        requires BufferedAccessPolicy<Policy, Key>;
+    void Drain()
+        requires BufferedAccessPolicy<Policy, Key>;
+    // Inserts evict until the entry fits both limits. An entry heavier than
+    // the whole weight budget is dropped instead, together with any older
+    // value under its key, and evicts nothing.
     void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    // As Put, but the entry expires `ttl` after this call (zero: never). An
+    // update replaces the previous deadline.
+    void Put(const Key& key, const Value& value, std::chrono::milliseconds ttl);
+    void Put(Key&& key, Value&& value, std::chrono::milliseconds ttl);
+    // Inserts or replaces the entry for `key` with a value constructed in
+    // place from `args`, using the default TTL. A new key is copied or moved
+    // into the index once.
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
+    // Removes the entry for `key`. Returns false if there was none. `cause`
+    // is what the removal handler is told.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    bool Erase(const K& key, RemovalCause cause = RemovalCause::kExplicit);
+    // Moves up to `count` live entries out, coldest first, handing each to
+    // `sink(Key&&, Value&&, ttl)` where `ttl` is the time it had left (zero:
+    // none). Returns the number of entries moved.
+    template <typename Sink>
+        requires std::invocable<Sink&, Key&&, Value&&, std::chrono::milliseconds>
+    std::size_t Extract(std::size_t count, Sink&& sink);
+    // Calls `visitor(const Key&, const Value&, ttl)` on every live entry,
+    // `ttl` being the time it has left (zero: none), without recording hits.
+    // Entries come coldest first when the policy is an OrderedPolicy, in
+    // index order otherwise. Safe under a shared lock.
+    template <typename Visitor>
+        requires std::invocable<Visitor&, const Key&, const Value&, std::chrono::milliseconds>
+    void ForEach(Visitor&& visitor) const;
+    // Changes the entry limit, evicting policy victims until the cache fits.
+    // The policy keeps the sizing it was constructed with, so a cache should
+    // be built with the largest capacity it will be given.
+    void SetCapacity(std::size_t capacity);
+    [[nodiscard]] std::size_t Capacity() const noexcept;
+    // True while any resident entry carries a TTL.
+    [[nodiscard]] bool HasExpiringEntries() const noexcept;
+    // Counts expired entries that have not been reclaimed yet.
     [[nodiscard]] std::size_t Size() const noexcept;
-    void Clear() noexcept;
+    // Summed weight of the resident entries, expired ones included.
+    [[nodiscard]] std::size_t WeightedSize() const noexcept;
+    // Entries evicted for capacity or weight since construction. Expired,
+    // erased and extracted entries are not counted; Clear keeps the count.
+    [[nodiscard]] std::uint64_t Evictions() const noexcept;
+    void Clear();
+    // Hands every entry that leaves the cache, and every value an update
+    // replaces, to `handler(Key&&, Value&&, ttl, cause)` instead of
+    // destroying it, `ttl` being the time it had left (zero: none). Entries
+    // past their deadline are reported as kExpired whatever removed them.
+    // Extract does not report. The handler runs inline and must not call
+    // back into the cache. An empty handler restores plain removal.
+    void SetRemovalHandler(
+        std::function<void(Key&&, Value&&, std::chrono::milliseconds, RemovalCause)> handler);
+    // From now on every insert or update stamps its entry with the time of
+    // the write, strictly increasing within the cache, so a stamp both dates
+    // a write and identifies it. Entries written earlier carry the epoch.
+    void EnableWriteStamps() noexcept;
+    // Stamp of the live entry for `key`; empty on a miss or with stamps off.
+    // Safe under a shared lock.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Stamp> WriteStampOf(const K& key) const;
 
 private:
-    using Node = std::pair<Key, Value>;
-    using NodeList = std::list<Node>;
-    using NodeIterator = typename NodeList::iterator;
+    using Tick = typename TimingWheel<Key>::Tick;
+
+    static constexpr Tick kNever = std::numeric_limits<Tick>::max();
+
+    struct Entry {
+        template <typename... Args>
+        explicit Entry(std::in_place_t, Args&&... args) : value(std::forward<Args>(args)...) {}
+
+        Value value;
+        typename Policy::Handle handle{};
+        Tick expires_at = kNever;
+        typename TimingWheel<Key>::Handle timer{};
+        std::size_t weight = 0;
+        Stamp written{};
+    };
+
+    using Index = std::unordered_map<Key, Entry, KeyHash<Key>, std::equal_to<>>;
 
-    void MoveToFront(NodeIterator iterator) noexcept;
+    template <typename K, typename... Args>
+    void Insert(std::chrono::milliseconds ttl, K&& key, Args&&... args);
+    [[nodiscard]] Tick NowTick() const noexcept;
+    [[nodiscard]] bool IsExpired(const Entry& entry) const noexcept;
+    void SetExpiry(typename Index::iterator entry, std::chrono::milliseconds ttl);
+    void ReclaimExpired();
+    void Remove(typename Index::iterator entry, RemovalCause cause);
+    void EvictOne();
+    // Hands a removed entry to on_remove_.
+    void Report(Key&& key, Value&& value, Tick deadline, RemovalCause cause);
+    void StampWrite(Entry& entry) noexcept;
 
     std::size_t capacity_;
-    NodeList entries_;
-    std::unordered_map<Key, NodeIterator> index_;
+    std::size_t max_weight_;
+    std::size_t weight_ = 0;
+    std::uint64_t evictions_ = 0;
+    Weigher weigher_;
+    std::chrono::milliseconds default_ttl_;
+    std::chrono::steady_clock::time_point epoch_;
+    Index index_;
+    Policy policy_;
+    TimingWheel<Key> expiry_;
+    std::function<void(Key&&, Value&&, std::chrono::milliseconds, RemovalCause)> on_remove_;
+    bool stamp_writes_ = false;
+    Stamp last_stamp_{};
 };
 
 #include "LRUCache.cpp"
@@ -0,0 +1,52 @@
+#ifndef SHARDED_LRU_CACHE_LRUPOLICY_CPP
+#define SHARDED_LRU_CACHE_LRUPOLICY_CPP
+
+#include "LruPolicy.h"
+
+template <typename Key>
+LruPolicy<Key>::LruPolicy([[maybe_unused]] const std::size_t capacity) {}
+
+template <typename Key>
+typename LruPolicy<Key>::Handle LruPolicy<Key>::OnInsert(const Key& key) {
+    order_.push_front(&key);
+    return order_.begin();
+}
+
+template <typename Key>
+void LruPolicy<Key>::OnAccess(const Handle handle) noexcept {
+    if (handle == order_.begin()) {
+        return;
+    }
+
+    order_.splice(order_.begin(), order_, handle);
+}
+
+template <typename Key>
+const Key& LruPolicy<Key>::Victim() const noexcept {
+    return *order_.back();
+}
+
+template <typename Key>
+void LruPolicy<Key>::OnEvict(const Handle handle) noexcept {
+    order_.erase(handle);
+}
+
+template <typename Key>
+void LruPolicy<Key>::OnRemove(const Handle handle) noexcept {
+    order_.erase(handle);
+}
+
+template <typename Key>
+void LruPolicy<Key>::Clear() noexcept {
+    order_.clear();
+}
+
+template <typename Key>
+template <typename Visitor>
+void LruPolicy<Key>::ForEachColdestFirst(Visitor&& visitor) const {
+    for (auto key = order_.rbegin(); key != order_.rend(); ++key) {
+        visitor(**key);
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_LRUPOLICY_CPP
@@ -0,0 +1,31 @@
+#ifndef SHARDED_LRU_CACHE_LRUPOLICY_H
+#define SHARDED_LRU_CACHE_LRUPOLICY_H
+
+#include <cstddef>
+#include <list>
+
+// Strict least-recently-used ordering: every hit moves the entry to the front
+// and the back of the list is always the victim.
+template <typename Key>
+class LruPolicy final {
+public:
+    using Handle = typename std::list<const Key*>::iterator;
+
+    explicit LruPolicy(std::size_t capacity);
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) noexcept;
+    [[nodiscard]] const Key& Victim() const noexcept;
+    void OnEvict(Handle handle) noexcept;
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+    template <typename Visitor>
+    void ForEachColdestFirst(Visitor&& visitor) const;
+
+private:
+    std::list<const Key*> order_;
+};
+
+#include "LruPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_LRUPOLICY_H
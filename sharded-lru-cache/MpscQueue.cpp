@@ -0,0 +1,48 @@
+#ifndef SHARDED_LRU_CACHE_MPSCQUEUE_CPP
+#define SHARDED_LRU_CACHE_MPSCQUEUE_CPP
+
+#include "MpscQueue.h"
+
+#include <memory>
+#include <utility>
+
+template <typename T>
+MpscQueue<T>::MpscQueue() : head_(new Node), tail_(head_.load(std::memory_order_relaxed)) {}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue() {
+    Node* node = tail_;
+    while (node != nullptr) {
+        Node* const next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+    }
+}
+
+template <typename T>
+void MpscQueue<T>::Push(T value) {
+    auto owned = std::make_unique<Node>();
+    owned->value.emplace(std::move(value));
+    Node* const node = owned.release();
+    // The exchange orders producers; the release store publishes the value
+    // to the consumer that loads `next`.
+    Node* const previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+template <typename T>
+std::optional<T> MpscQueue<T>::TryPop() {
+    Node* const next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+        return std::nullopt;
+    }
+
+    // `next` becomes the new stub once its value is moved out.
+    std::optional<T> value = std::move(next->value);
+    next->value.reset();
+    delete tail_;
+    tail_ = next;
+    return value;
+}
+
+#endif  // SHARDED_LRU_CACHE_MPSCQUEUE_CPP
@@ -0,0 +1,39 @@
+#ifndef SHARDED_LRU_CACHE_MPSCQUEUE_H
+#define SHARDED_LRU_CACHE_MPSCQUEUE_H
+
+#include <atomic>
+#include <optional>
+
+// Unbounded multi-producer, single-consumer FIFO (Vyukov's linked queue).
+// - Push allocates a node and links it with one atomic exchange; it never
+//   waits for other producers or for the consumer.
+// - TryPop must be called by one consumer at a time. A push whose exchange
+//   has happened but whose link has not yet been written reads as absent
+//   (and hides any pushes behind it) until the producer finishes.
+template <typename T>
+class MpscQueue final {
+public:
+    MpscQueue();
+    ~MpscQueue();
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(T value);
+    [[nodiscard]] std::optional<T> TryPop();
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    // Newest node; producers swap themselves in here.
+    std::atomic<Node*> head_;
+    // Consumer side: a node whose value was already taken (initially a stub).
+    Node* tail_;
+};
+
+#include "MpscQueue.cpp"
+
+#endif  // SHARDED_LRU_CACHE_MPSCQUEUE_H
@@ -0,0 +1,41 @@
+#ifndef SHARDED_LRU_CACHE_READBUFFER_CPP
+#define SHARDED_LRU_CACHE_READBUFFER_CPP
+
+#include "ReadBuffer.h"
+
+template <typename T, std::size_t Capacity>
+bool ReadBuffer<T, Capacity>::TryPush(const T& item) noexcept {
+    // Claiming a slot is the only contended step; ordering with the consumer
+    // comes from the shard lock, so relaxed atomics are enough here.
+    std::size_t write = write_.load(std::memory_order_relaxed);
+    do {
+        if (write - read_.load(std::memory_order_relaxed) >= Capacity) {
+            return false;
+        }
+    } while (!write_.compare_exchange_weak(write, write + 1U, std::memory_order_relaxed));
+
+    slots_[write & (Capacity - 1U)] = item;
+    return true;
+}
+
+template <typename T, std::size_t Capacity>
+std::size_t ReadBuffer<T, Capacity>::Pending() const noexcept {
+    return write_.load(std::memory_order_relaxed) - read_.load(std::memory_order_relaxed);
+}
+
+template <typename T, std::size_t Capacity>
+template <typename Consumer>
+void ReadBuffer<T, Capacity>::Drain(Consumer&& consumer) {
+    const std::size_t write = write_.load(std::memory_order_relaxed);
+    for (std::size_t read = read_.load(std::memory_order_relaxed); read != write; ++read) {
+        consumer(slots_[read & (Capacity - 1U)]);
+    }
+    read_.store(write, std::memory_order_relaxed);
+}
+
+template <typename T, std::size_t Capacity>
+void ReadBuffer<T, Capacity>::Discard() noexcept {
+    read_.store(write_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+#endif  // SHARDED_LRU_CACHE_READBUFFER_CPP
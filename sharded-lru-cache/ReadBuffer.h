@@ -0,0 +1,36 @@
+#ifndef SHARDED_LRU_CACHE_READBUFFER_H
+#define SHARDED_LRU_CACHE_READBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded, lossy, multi-producer ring of recorded reads.
+// - TryPush is lock-free and may run from many readers at once; when the ring
+//   is full the read is dropped rather than blocking the reader.
+// - Drain must be called by a single consumer that excludes all producers
+//   (in ShardedLRUCache: the holder of the shard's exclusive lock), which also
+//   publishes the producers' slot writes to it.
+template <typename T, std::size_t Capacity>
+class ReadBuffer final {
+    static_assert(Capacity > 0U && (Capacity & (Capacity - 1U)) == 0U,
+                  "ReadBuffer capacity must be a power of two");
+
+public:
+    bool TryPush(const T& item) noexcept;
+    [[nodiscard]] std::size_t Pending() const noexcept;
+
+    template <typename Consumer>
+    void Drain(Consumer&& consumer);
+
+    void Discard() noexcept;
+
+private:
+    std::array<T, Capacity> slots_{};
+    std::atomic<std::size_t> write_{0};
+    std::atomic<std::size_t> read_{0};
+};
+
+#include "ReadBuffer.cpp"
+
+#endif  // SHARDED_LRU_CACHE_READBUFFER_H
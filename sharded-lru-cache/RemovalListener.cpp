@@ -0,0 +1,156 @@
+#ifndef SHARDED_LRU_CACHE_REMOVALLISTENER_CPP
+#define SHARDED_LRU_CACHE_REMOVALLISTENER_CPP
+
+#include "RemovalListener.h"
+
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+template <typename Key, typename Value>
+RemovalDispatcher<Key, Value>::RemovalDispatcher(RemovalListener<Key, Value> listener,
+                                                 const RemovalDelivery delivery)
+    : listener_(std::move(listener)), delivery_(delivery) {
+    if (!listener_) {
+        throw std::invalid_argument("RemovalDispatcher listener must not be empty");
+    }
+    if (delivery_ == RemovalDelivery::kAsync) {
+        worker_ = std::thread([this] { Run(); });
+    }
+}
+
+template <typename Key, typename Value>
+RemovalDispatcher<Key, Value>::~RemovalDispatcher() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    stopping_.store(true);
+    Wake();
+    worker_.join();
+}
+
+template <typename Key, typename Value>
+RemovalDelivery RemovalDispatcher<Key, Value>::Delivery() const noexcept {
+    return delivery_;
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Enqueue(Event&& event) {
+    queue_.Push(std::move(event));
+    // Counted once linked, so whoever sees the count can also pop the event.
+    enqueued_.fetch_add(1U);
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Notify() noexcept {
+    // Sequentially consistent with the thread's idle_ store and backlog
+    // check in Run: either it sees the new event or this sees idle_ set.
+    if (idle_.load() && idle_.exchange(false)) {
+        Wake();
+        return;
+    }
+    const std::uint64_t backlog =
+        enqueued_.load(std::memory_order_relaxed) - popped_.load(std::memory_order_relaxed);
+    if (backlog >= kWakeBacklog && !batch_wake_.exchange(true)) {
+        Wake();
+    }
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Deliver(const std::span<Event> events) noexcept {
+    if (events.empty()) {
+        return;
+    }
+    try {
+        listener_(events);
+    } catch (...) {
+        // A failing listener must not take the cache, or its thread, down.
+    }
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Flush() {
+    if (delivery_ != RemovalDelivery::kAsync) {
+        return;
+    }
+
+    const std::uint64_t target = enqueued_.load();
+    flushing_.fetch_add(1U);
+    Wake();
+    for (std::uint64_t delivered = delivered_.load(std::memory_order_acquire); delivered < target;
+         delivered = delivered_.load(std::memory_order_acquire)) {
+        delivered_.wait(delivered, std::memory_order_acquire);
+    }
+    flushing_.fetch_sub(1U);
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Run() {
+    std::vector<Event> batch;
+    batch.reserve(kBatch);
+    for (;;) {
+        const bool stopping = stopping_.load();
+        Drain(batch);
+        batch_wake_.store(false);
+        if (stopping) {
+            return;
+        }
+
+        idle_.store(true);
+        if (enqueued_.load() == popped_.load(std::memory_order_relaxed)) {
+            Sleep(nullptr);
+        }
+        // A producer may have cleared it already, to wake this thread.
+        idle_.store(false);
+        batch_wake_.store(false);
+        // Let a batch build up, unless one already has or a Flush waits.
+        Sleep(&kMaxDelay);
+    }
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Drain(std::vector<Event>& batch) {
+    while (std::optional<Event> event = queue_.TryPop()) {
+        popped_.fetch_add(1U, std::memory_order_relaxed);
+        batch.push_back(std::move(*event));
+        if (batch.size() == kBatch) {
+            DeliverBatch(batch);
+        }
+    }
+    DeliverBatch(batch);
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::DeliverBatch(std::vector<Event>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    Deliver(batch);
+    const std::size_t count = batch.size();
+    batch.clear();
+    delivered_.fetch_add(count, std::memory_order_release);
+    delivered_.notify_all();
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Wake() {
+    {
+        std::scoped_lock lock(wake_mutex_);
+        woken_ = true;
+    }
+    wake_.notify_one();
+}
+
+template <typename Key, typename Value>
+void RemovalDispatcher<Key, Value>::Sleep(const std::chrono::milliseconds* const timeout) {
+    std::unique_lock lock(wake_mutex_);
+    const auto woken = [this] { return woken_ || flushing_.load() != 0U || stopping_.load(); };
+    if (timeout == nullptr) {
+        wake_.wait(lock, woken);
+    } else {
+        (void)wake_.wait_for(lock, *timeout, woken);
+    }
+    woken_ = false;
+}
+
+#endif  // SHARDED_LRU_CACHE_REMOVALLISTENER_CPP
@@ -0,0 +1,110 @@
+#ifndef SHARDED_LRU_CACHE_REMOVALLISTENER_H
+#define SHARDED_LRU_CACHE_REMOVALLISTENER_H
+
+#include "CacheTraits.h"
+#include "MpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Where a removal listener runs.
+enum class RemovalDelivery : std::uint8_t {
+    // On a background thread, in batches, shortly after the removals.
+    kAsync,
+    // On the thread that caused the removals, before its call returns.
+    kSync,
+};
+
+template <typename Key, typename Value>
+struct RemovalEvent {
+    Key key;
+    Value value;
+    RemovalCause cause;
+};
+
+// Receives removals in the order each shard made them; the listener may move
+// keys and values out of the span.
+template <typename Key, typename Value>
+using RemovalListener = std::function<void(std::span<RemovalEvent<Key, Value>>)>;
+
+// Hands removal events to a listener.
+// - kAsync: Enqueue pushes onto a lock-free MPSC queue (one allocation, no
+//   lock), so it is cheap enough to run inside a shard's critical section.
+//   Notify, called once the lock is released, wakes the delivery thread only
+//   if it is idle or kWakeBacklog events are pending; a woken thread waits up
+//   to kMaxDelay for more events, then drains the queue and calls the
+//   listener kBatch events at a time. Producers thus pay one wake-up per
+//   many events, not one per event.
+// - kSync: there is no thread; the cache collects events while it holds its
+//   locks and passes them to Deliver afterwards.
+// Exceptions thrown by the listener are caught and dropped.
+template <typename Key, typename Value>
+class RemovalDispatcher final {
+public:
+    using Event = RemovalEvent<Key, Value>;
+
+    // Starts the delivery thread in kAsync mode. Throws std::invalid_argument
+    // for an empty listener.
+    RemovalDispatcher(RemovalListener<Key, Value> listener, RemovalDelivery delivery);
+    // Delivers whatever is still queued, then stops the thread.
+    ~RemovalDispatcher();
+
+    RemovalDispatcher(const RemovalDispatcher&) = delete;
+    RemovalDispatcher& operator=(const RemovalDispatcher&) = delete;
+
+    [[nodiscard]] RemovalDelivery Delivery() const noexcept;
+    // kAsync only.
+    void Enqueue(Event&& event);
+    // Wakes the delivery thread if it is idle or has a batch to deliver.
+    void Notify() noexcept;
+    // Runs the listener on `events` on the calling thread.
+    void Deliver(std::span<Event> events) noexcept;
+    // Blocks until every event enqueued before the call has been delivered.
+    // Returns at once in kSync mode.
+    void Flush();
+
+private:
+    static constexpr std::size_t kBatch = 256;
+    // Backlog at which a producer wakes the thread before kMaxDelay is up.
+    static constexpr std::uint64_t kWakeBacklog = 16U * kBatch;
+    static constexpr std::chrono::milliseconds kMaxDelay{10};
+
+    void Run();
+    // Pops everything linked so far, delivering it kBatch at a time.
+    void Drain(std::vector<Event>& batch);
+    void DeliverBatch(std::vector<Event>& batch);
+    void Wake();
+    // Sleeps until Wake, Flush or destruction; at most `timeout` if given.
+    void Sleep(const std::chrono::milliseconds* timeout);
+
+    RemovalListener<Key, Value> listener_;
+    RemovalDelivery delivery_;
+    MpscQueue<Event> queue_;
+    std::atomic<std::uint64_t> enqueued_{0};
+    // Popped by the delivery thread; the difference is the backlog.
+    std::atomic<std::uint64_t> popped_{0};
+    std::atomic<std::uint64_t> delivered_{0};
+    // Set while the delivery thread waits for a first event; the producer
+    // that clears it does the wake-up.
+    std::atomic<bool> idle_{false};
+    // Set by the producer that wakes the thread for a full batch.
+    std::atomic<bool> batch_wake_{false};
+    std::atomic<std::uint32_t> flushing_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool woken_ = false;
+    std::thread worker_;
+};
+
+#include "RemovalListener.cpp"
+
+#endif  // SHARDED_LRU_CACHE_REMOVALLISTENER_H
@@ -0,0 +1,86 @@
+#ifndef SHARDED_LRU_CACHE_S3FIFOPOLICY_CPP
+#define SHARDED_LRU_CACHE_S3FIFOPOLICY_CPP
+
+#include "S3FifoPolicy.h"
+
+#include <algorithm>
+#include <iterator>
+
+template <typename Key>
+S3FifoPolicy<Key>::S3FifoPolicy(const std::size_t capacity)
+    : small_limit_(std::max<std::size_t>(1U, capacity / 10U)),
+      ghosts_(std::max<std::size_t>(1U, capacity - std::min(capacity, small_limit_))) {}
+
+template <typename Key>
+typename S3FifoPolicy<Key>::Handle S3FifoPolicy<Key>::OnInsert(const Key& key) {
+    const bool seen_recently = ghosts_.Erase(key);
+    ghosts_.Trim();
+    if (seen_recently) {
+        main_.push_front(Node{&key, 0U, true});
+        return main_.begin();
+    }
+
+    small_.push_front(Node{&key, 0U, false});
+    return small_.begin();
+}
+
+template <typename Key>
+void S3FifoPolicy<Key>::OnAccess(const Handle handle) noexcept {
+    if (handle->frequency < kMaxFrequency) {
+        ++handle->frequency;
+    }
+}
+
+template <typename Key>
+const Key& S3FifoPolicy<Key>::Victim() noexcept {
+    // Promotions and reinsertions only splice nodes, so handles held by the
+    // cache stay valid while the queues are rotated.
+    while (true) {
+        if (!small_.empty() && (small_.size() >= small_limit_ || main_.empty())) {
+            const auto tail = std::prev(small_.end());
+            if (tail->frequency == 0U) {
+                return *tail->key;
+            }
+            tail->frequency = 0U;
+            tail->in_main = true;
+            main_.splice(main_.begin(), small_, tail);
+            continue;
+        }
+
+        const auto tail = std::prev(main_.end());
+        if (tail->frequency == 0U) {
+            return *tail->key;
+        }
+        --tail->frequency;
+        main_.splice(main_.begin(), main_, tail);
+    }
+}
+
+template <typename Key>
+void S3FifoPolicy<Key>::OnEvict(const Handle handle) {
+    if (handle->in_main) {
+        main_.erase(handle);
+        return;
+    }
+
+    ghosts_.Push(*handle->key);
+    small_.erase(handle);
+}
+
+template <typename Key>
+void S3FifoPolicy<Key>::OnRemove(const Handle handle) noexcept {
+    if (handle->in_main) {
+        main_.erase(handle);
+    } else {
+        small_.erase(handle);
+    }
+}
+
+template <typename Key>
+void S3FifoPolicy<Key>::Clear() noexcept {
+    small_.clear();
+    main_.clear();
+    ghosts_.Clear();
+}
+
+#endif  // SHARDED_LRU_CACHE_S3FIFOPOLICY_CPP
@@ -0,0 +1,49 @@
+#ifndef SHARDED_LRU_CACHE_S3FIFOPOLICY_H
+#define SHARDED_LRU_CACHE_S3FIFOPOLICY_H
+
+#include "GhostList.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+
+// S3-FIFO (Yang et al., SOSP'23): three FIFO queues, no reordering on hits.
+// - small_: ~10% of capacity, admits new keys; keys hit while there move to
+//   main_ on eviction, the rest become ghosts.
+// - main_: keys with a 2-bit hit counter; the tail is reinserted while its
+//   counter is non-zero (decrementing it), so hot keys survive like CLOCK.
+// - ghosts_: keys evicted from small_; re-inserting one goes straight to main_.
+// A hit only bumps a counter, so OnAccess never touches list links.
+template <typename Key>
+class S3FifoPolicy final {
+private:
+    struct Node {
+        const Key* key;
+        std::uint8_t frequency;
+        bool in_main;
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    explicit S3FifoPolicy(std::size_t capacity);
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) noexcept;
+    [[nodiscard]] const Key& Victim() noexcept;
+    void OnEvict(Handle handle);
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+
+private:
+    static constexpr std::uint8_t kMaxFrequency = 3U;
+
+    std::size_t small_limit_;
+    std::list<Node> small_;
+    std::list<Node> main_;
+    GhostList<Key> ghosts_;
+};
+
+#include "S3FifoPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_S3FIFOPOLICY_H
@@ -3,63 +3,1931 @@
 
 #include "ShardedLRUCache.h"
 
-template <typename Key, typename Value>
-ShardedLRUCache<Key, Value>::ShardedLRUCache(const std::size_t capacity_per_shard,
-                                             const std::size_t shard_count)
-    : capacity_per_shard_(capacity_per_shard), shard_count_(shard_count) {
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardedLRUCache(
+    const std::size_t capacity_per_shard, const std::size_t shard_count,
+    const std::chrono::milliseconds default_ttl)
+    : ShardedLRUCache(capacity_per_shard, shard_count, std::numeric_limits<std::size_t>::max(), Weigher{},
+                      default_ttl) {}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardedLRUCache(
+    const std::size_t capacity_per_shard, const std::size_t shard_count,
+    const std::size_t max_weight_per_shard, Weigher weigher, const std::chrono::milliseconds default_ttl)
+    : capacity_per_shard_(capacity_per_shard),
+      max_weight_per_shard_(max_weight_per_shard),
+      weigher_(std::move(weigher)),
+      default_ttl_(default_ttl) {
     if (capacity_per_shard_ == 0U) {
         throw std::invalid_argument("capacity_per_shard must be greater than zero");
     }
-    if (shard_count_ == 0U) {
+    if (shard_count == 0U) {
         throw std::invalid_argument("shard_count must be greater than zero");
     }
+    if (max_weight_per_shard_ == 0U) {
+        throw std::invalid_argument("max_weight_per_shard must be greater than zero");
+    }
+    if (shard_count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("shard_count must fit in 32 bits");
+    }
+    if (default_ttl_ < std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("default_ttl must not be negative");
+    }
+
+    layouts_.push_back(MakeLayout(shard_count));
+    layout_.store(layouts_.back().get(), std::memory_order_release);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardedLRUCache(
+    const SharedCapacity capacity, const std::size_t shard_count, const std::chrono::milliseconds default_ttl)
+    // Shards are built (and their policies sized) for the largest quota.
+    : ShardedLRUCache(MaxQuota(capacity, shard_count), shard_count, default_ttl) {
+    adaptive_ = true;
+    total_capacity_ = capacity.total;
+    // No other thread can see the layout before the constructor returns.
+    AssignEqualQuotas(CurrentLayout());
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+    requires LookupKey<K, Key>
+std::optional<Value> ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Get(const K& key) {
+    std::optional<Value> value;
+    GetWith(key, [&value](const Value& cached) { value.emplace(cached); });
+    return value;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K, typename Visitor>
+    requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::GetWith(const K& key, Visitor&& visitor) {
+    const ScopedLatency timer(*this, &LatencyMetrics::get);
+    return Lookup<true>(key, visitor) == Probe::kHit;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename K, typename Visitor>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Probe
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Lookup(const K& key, Visitor& visitor) {
+    const std::uint64_t hash = HashOf(key);
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    for (;;) {
+        Layout& layout = CurrentLayout();
+        Shard& shard = layout.shards[ShardIndexForHash(layout, hash)];
+        Probe probe = Probe::kMiss;
+        if (Layout* const previous = layout.previous.load(std::memory_order_acquire); previous != nullptr) {
+            // Writes during a migration drop the old shard's copy before
+            // storing the new one, so a copy still in the old shard is current.
+            Shard& old_shard = previous->shards[ShardIndexForHash(*previous, hash)];
+            if (const Probe old_probe = ProbeShard<kWait>(old_shard, key, visitor);
+                old_probe == Probe::kHit || old_probe == Probe::kBusy) {
+                return old_probe;
+            }
+            probe = ProbeShard<kWait>(shard, key, visitor);
+        } else if constexpr (kWait && kFrontCacheable<K>) {
+            probe = front_cache_enabled_.load(std::memory_order_relaxed)
+                        ? GetWithFront(layout, shard, hash, key, visitor)
+                        : ProbeShard(shard, key, visitor);
+        } else {
+            probe = ProbeShard<kWait>(shard, key, visitor);
+        }
+
+        if (probe == Probe::kHit || probe == Probe::kBusy) {
+            return probe;
+        }
+        // A miss in a layout that has since been replaced may only mean the
+        // key has already moved on.
+        if (probe == Probe::kRetired || &layout != layout_.load(std::memory_order_acquire)) {
+            continue;
+        }
+        // Hits are counted by the probe that found them; a miss only here,
+        // once every layout has been tried.
+        Count(shard, &ShardCounters::misses);
+        if (adaptive_) {
+            RecordMisses(shard, 1U);
+        }
+        return PromoteFromDisk(shard, key, hash, visitor) ? Probe::kHit : Probe::kMiss;
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::EnableFrontCache(const bool enabled) noexcept {
+    front_cache_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+    requires LookupKey<K, Key>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Contains(const K& key) const {
+    const std::uint64_t hash = HashOf(key);
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    for (;;) {
+        const Layout& layout = CurrentLayout();
+        if (const Layout* const previous = layout.previous.load(std::memory_order_acquire);
+            previous != nullptr &&
+            ProbeContains(previous->shards[ShardIndexForHash(*previous, hash)], key) == Probe::kHit) {
+            return true;
+        }
+
+        const Probe probe = ProbeContains(layout.shards[ShardIndexForHash(layout, hash)], key);
+        if (probe == Probe::kHit) {
+            return true;
+        }
+        if (probe == Probe::kMiss && &layout == layout_.load(std::memory_order_acquire)) {
+            return false;
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename KeyCodec, typename ValueCodec>
+    requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::EnableDiskTier(DiskTierOptions options) {
+    std::scoped_lock resize_lock(resize_mutex_);
+    if (disk_tier_owner_ != nullptr) {
+        throw std::logic_error("a disk tier is already enabled");
+    }
+
+    disk_tier_owner_ = SpillTier::template Create<KeyCodec, ValueCodec>(std::move(options));
+    disk_tier_.store(disk_tier_owner_.get(), std::memory_order_release);
+    // Layouts built from now on get the handler from MakeLayout.
+    for (const std::unique_ptr<Layout>& layout : layouts_) {
+        for (std::size_t i = 0; i < layout->shard_count; ++i) {
+            Shard& shard = layout->shards[i];
+            WriteShard(shard, [&](ShardCache&) { InstallRemovalHandler(shard); });
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+DiskTierStats ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::DiskStats() const {
+    const SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+    return tier != nullptr ? tier->Stats() : DiskTierStats{};
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::EnableRefreshAhead(
+    RefreshOptions options, std::function<Value(const Key&)> loader) {
+    if (options.refresh_after <= std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("ShardedLRUCache refresh_after must be greater than zero");
+    }
+    if (!loader) {
+        throw std::invalid_argument("ShardedLRUCache refresh loader must not be empty");
+    }
+
+    std::scoped_lock resize_lock(resize_mutex_);
+    if (refresher_owner_ != nullptr) {
+        throw std::logic_error("refresh-ahead is already enabled");
+    }
+
+    // The pool rejects zero threads or max_pending.
+    refresher_owner_ = std::make_unique<Refresher>(options, std::move(loader));
+    refresher_.store(refresher_owner_.get(), std::memory_order_release);
+    for (const std::unique_ptr<Layout>& layout : layouts_) {
+        for (std::size_t i = 0; i < layout->shard_count; ++i) {
+            WriteShard(layout->shards[i], [](ShardCache& cache) { cache.EnableWriteStamps(); });
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+RefreshAheadStats ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RefreshStats() const {
+    const Refresher* const refresher = refresher_.load(std::memory_order_acquire);
+    if (refresher == nullptr) {
+        return RefreshAheadStats{};
+    }
+    return RefreshAheadStats{
+        .scheduled = refresher->scheduled.load(std::memory_order_relaxed),
+        .replaced = refresher->replaced.load(std::memory_order_relaxed),
+        .discarded = refresher->discarded.load(std::memory_order_relaxed),
+        .failed = refresher->failed.load(std::memory_order_relaxed),
+        .rejected = refresher->rejected.load(std::memory_order_relaxed),
+    };
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Put(const Key& key, const Value& value) {
+    Emplace(key, value);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Put(Key&& key, Value&& value) {
+    Emplace(std::move(key), std::move(value));
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Put(const Key& key, const Value& value,
+                                                                 const std::chrono::milliseconds ttl) {
+    WriteKey(key, [&](ShardCache& cache) { cache.Put(key, value, ttl); });
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Put(Key&& key, Value&& value,
+                                                                 const std::chrono::milliseconds ttl) {
+    WriteKey(key, [&](ShardCache& cache) { cache.Put(std::move(key), std::move(value), ttl); });
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K, typename... Args>
+    requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+             std::constructible_from<Value, Args&&...>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Emplace(K&& key, Args&&... args) {
+    WriteKey(key, [&](ShardCache& cache) {
+        cache.Emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    });
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename Loader>
+    requires std::invocable<Loader&, const Key&> &&
+             std::convertible_to<std::invoke_result_t<Loader&, const Key&>, Value>
+Value ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::GetOrLoad(const Key& key, Loader&& loader) {
+    if (std::optional<Value> cached = Get(key)) {
+        return std::move(*cached);
+    }
+
+    std::promise<Value> promise;
+    std::shared_future<Value> in_flight;
+    // The shard the load is registered in, which it keeps as a user. A
+    // retired shard no longer takes registrations; the caller then loads on
+    // its own.
+    Shard* registered = nullptr;
+    {
+        const EpochReclaimer::Guard guard = reclaimer_.Pin();
+        Layout& layout = CurrentLayout();
+        Shard& shard = layout.shards[ShardIndexForHash(layout, HashOf(key))];
+        // The re-check may reclaim an expired entry.
+        RemovalScope removals(*this);
+        std::scoped_lock lock(shard.mutex);
+        removals.Arm();
+        if (!shard.retired) {
+            // Re-check under the exclusive lock: another loader may have
+            // finished between the miss above and now.
+            if (std::optional<Value> cached = shard.cache.Get(key)) {
+                return std::move(*cached);
+            }
+
+            if (const auto found = shard.loading.find(key); found != shard.loading.end()) {
+                in_flight = found->second;
+            } else {
+                shard.loading.emplace(key, promise.get_future().share());
+                shard.users.fetch_add(1U, std::memory_order_relaxed);
+                registered = &shard;
+            }
+        }
+    }
+
+    if (in_flight.valid()) {
+        return in_flight.get();
+    }
+
+    try {
+        Value value = std::invoke(loader, key);
+        // Stored before the registration is dropped, so a caller arriving in
+        // between finds the value rather than starting another load.
+        Put(key, value);
+        if (registered != nullptr) {
+            {
+                std::scoped_lock lock(registered->mutex);
+                registered->loading.erase(key);
+            }
+            registered->users.fetch_sub(1U, std::memory_order_release);
+            registered = nullptr;
+        }
+        promise.set_value(value);
+        return value;
+    } catch (...) {
+        if (registered != nullptr) {
+            {
+                std::scoped_lock lock(registered->mutex);
+                registered->loading.erase(key);
+            }
+            registered->users.fetch_sub(1U, std::memory_order_release);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename Loader>
+    requires std::invocable<Loader&, const Key&> &&
+             std::same_as<std::invoke_result_t<Loader&, const Key&>, Task<Value>>
+Task<Value> ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::GetAsync(Executor& executor, Key key,
+                                                                             Loader loader) {
+    // No co_await below runs with a shard lock held: every lock is tried,
+    // and a busy one sends the coroutine back to the executor.
+    Shard* shard = nullptr;
+    std::shared_ptr<AsyncLoad> load;
+    bool registered = false;
+    for (;;) {
+        std::optional<Value> cached;
+        const auto visit = [&cached](const Value& value) { cached.emplace(value); };
+        const Probe probe = Lookup<false>(key, visit);
+        if (probe == Probe::kHit) {
+            co_return std::move(*cached);
+        }
+        if (probe == Probe::kBusy) {
+            co_await Reschedule(executor);
+            continue;
+        }
+
+        bool locked = false;
+        {
+            // A guard belongs to its thread, so the pin ends before any
+            // co_await; past it, only a registered load keeps using `shard`.
+            const EpochReclaimer::Guard guard = reclaimer_.Pin();
+            Layout& layout = CurrentLayout();
+            shard = &layout.shards[ShardIndexForHash(layout, HashOf(key))];
+            // The re-check may reclaim an expired entry.
+            RemovalScope removals(*this);
+            std::unique_lock lock(shard->mutex, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                Count(*shard, &ShardCounters::contended_locks);
+            } else {
+                locked = true;
+                removals.Arm();
+                // A retired shard takes no registrations; the caller then
+                // loads on its own.
+                if (!shard->retired) {
+                    cached = shard->cache.Get(key);
+                    if (cached.has_value()) {
+                        // Another load finished since the miss above.
+                    } else if (const auto found = shard->async_loading.find(key);
+                               found != shard->async_loading.end()) {
+                        load = found->second;
+                    } else {
+                        load = std::make_shared<AsyncLoad>();
+                        shard->async_loading.emplace(key, load);
+                        shard->users.fetch_add(1U, std::memory_order_relaxed);
+                        registered = true;
+                    }
+                }
+            }
+        }
+        if (cached.has_value()) {
+            co_return std::move(*cached);
+        }
+        if (locked) {
+            break;
+        }
+        co_await Reschedule(executor);
+    }
+
+    if (load != nullptr && !registered) {
+        co_return co_await AwaitLoad(std::move(load), executor);
+    }
+
+    std::optional<Value> value;
+    std::exception_ptr error;
+    try {
+        value.emplace(co_await std::invoke(loader, std::as_const(key)));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Stored before the registration is dropped, so a caller arriving in
+    // between finds the value rather than starting another load.
+    if (value.has_value()) {
+        while (!WriteKey<false>(key, [&](ShardCache& cache) { cache.Emplace(key, *value); })) {
+            co_await Reschedule(executor);
+        }
+    }
+    if (registered) {
+        for (;;) {
+            {
+                std::unique_lock lock(shard->mutex, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    shard->async_loading.erase(key);
+                    break;
+                }
+            }
+            co_await Reschedule(executor);
+        }
+        shard->users.fetch_sub(1U, std::memory_order_release);
+        FinishAsyncLoad(*load, value, error);
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+    co_return std::move(*value);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+    requires LookupKey<K, Key>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Erase(const K& key) {
+    const std::uint64_t hash = HashOf(key);
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    for (;;) {
+        Layout& layout = CurrentLayout();
+        Shard& shard = layout.shards[ShardIndexForHash(layout, hash)];
+        SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+        bool erased = false;
+        bool retired = false;
+        const auto erase_from = [&](Shard& target, ShardCache& cache) {
+            if (target.retired) {
+                retired = &target == &shard;
+                return;
+            }
+            if (tier != nullptr) {
+                ForgetSpilled(target, *tier, key, hash);
+            }
+            erased = cache.Erase(key) || erased;
+        };
+
+        if (Layout* const previous = layout.previous.load(std::memory_order_acquire); previous == nullptr) {
+            WriteShard(shard, [&](ShardCache& cache) { erase_from(shard, cache); });
+        } else {
+            // Same lock order as WriteKey, so a migrating copy cannot slip
+            // from the old shard into the new one in between.
+            Shard& old_shard = previous->shards[ShardIndexForHash(*previous, hash)];
+            WriteShard(old_shard, [&](ShardCache& old_cache) {
+                erase_from(old_shard, old_cache);
+                WriteShard(shard, [&](ShardCache& cache) { erase_from(shard, cache); });
+            });
+        }
+        if (!retired) {
+            return erased;
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::vector<std::optional<Value>> ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MultiGet(
+    const std::span<const Key> keys) {
+    std::vector<std::optional<Value>> results(keys.size());
+    const auto get_one = [this, keys, &results](const std::size_t position) {
+        std::optional<Value>& result = results[position];
+        GetWith(keys[position], [&result](const Value& value) { result.emplace(value); });
+    };
+
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    Layout& layout = CurrentLayout();
+    if (layout.previous.load(std::memory_order_acquire) != nullptr) {
+        // Mid-migration a key may sit in either layout; look each one up.
+        for (std::size_t position = 0; position < keys.size(); ++position) {
+            get_one(position);
+        }
+        return results;
+    }
+
+    const std::vector<ShardSlot> slots = GroupByShard(
+        layout, keys.size(), [keys](const std::size_t position) -> const Key& { return keys[position]; });
+    const SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+    // Positions whose hits are due for a refresh-ahead reload.
+    std::vector<std::pair<std::size_t, Stamp>> stale;
+    Stamp written{};
+
+    for (std::size_t begin = 0; begin < slots.size();) {
+        std::size_t end = begin + 1U;
+        while (end < slots.size() && slots[end].shard == slots[begin].shard) {
+            ++end;
+        }
+
+        Shard& shard = layout.shards[slots[begin].shard];
+        std::uint64_t misses = 0;
+        bool retired = false;
+        stale.clear();
+        ReadShard(shard, [&](ShardCache& cache) {
+            if (shard.retired) {
+                retired = true;
+                return;
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                const std::size_t position = slots[i].position;
+                std::optional<Value>& result = results[position];
+                const auto visit = [&result](const Value& value) { result.emplace(value); };
+                if (!VisitLocked(cache, keys[position], visit, &written)) {
+                    ++misses;
+                } else if (DueForRefresh(written)) {
+                    stale.emplace_back(position, written);
+                }
+            }
+        });
+        if (retired) {
+            for (std::size_t i = begin; i < end; ++i) {
+                get_one(slots[i].position);
+            }
+        } else {
+            for (const auto& [position, stamp] : stale) {
+                ScheduleRefresh(shard, keys[position], stamp);
+            }
+            Count(shard, &ShardCounters::hits, (end - begin) - misses);
+            Count(shard, &ShardCounters::misses, misses);
+            if (misses != 0U && adaptive_) {
+                RecordMisses(shard, misses);
+            }
+            // Misses may still be on disk.
+            for (std::size_t i = begin; i < end && misses != 0U && tier != nullptr; ++i) {
+                std::optional<Value>& result = results[slots[i].position];
+                const Key& key = keys[slots[i].position];
+                if (!result.has_value()) {
+                    const auto visit = [&result](const Value& value) { result.emplace(value); };
+                    (void)PromoteFromDisk(shard, key, HashOf(key), visit);
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // Keys a Reshard moved while the batch ran may have read as misses.
+    if (&layout != layout_.load(std::memory_order_acquire)) {
+        for (std::size_t position = 0; position < keys.size(); ++position) {
+            if (!results[position].has_value()) {
+                get_one(position);
+            }
+        }
+    }
+    return results;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MultiPut(
+    const std::span<const std::pair<Key, Value>> entries) {
+    reclaimer_.ReclaimShared();
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    Layout& layout = CurrentLayout();
+    if (layout.previous.load(std::memory_order_acquire) != nullptr) {
+        for (const auto& [key, value] : entries) {
+            Put(key, value);
+        }
+        return;
+    }
+
+    const std::vector<ShardSlot> slots =
+        GroupByShard(layout, entries.size(), [entries](const std::size_t position) -> const Key& {
+            return entries[position].first;
+        });
+
+    for (std::size_t begin = 0; begin < slots.size();) {
+        std::size_t end = begin + 1U;
+        while (end < slots.size() && slots[end].shard == slots[begin].shard) {
+            ++end;
+        }
+
+        Shard& shard = layout.shards[slots[begin].shard];
+        SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+        bool retired = false;
+        WriteShard(shard, [&](ShardCache& cache) {
+            if (shard.retired) {
+                retired = true;
+                return;
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& [key, value] = entries[slots[i].position];
+                if (tier != nullptr) {
+                    ForgetSpilled(shard, *tier, key, HashOf(key));
+                }
+                cache.Put(key, value);
+            }
+        });
+        if (retired) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& [key, value] = entries[slots[i].position];
+                Put(key, value);
+            }
+        } else {
+            Count(shard, &ShardCounters::puts, end - begin);
+        }
+        begin = end;
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Size() const {
+    const std::size_t size = SumShards([](const ShardCache& cache) { return cache.Size(); });
+    // Shards are counted one at a time, so capacity moving from a shard
+    // already counted to one not yet counted can be counted twice. The
+    // shards themselves never hold more than the total.
+    return adaptive_ ? std::min(size, total_capacity_) : size;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::WeightedSize() const {
+    return SumShards([](const ShardCache& cache) { return cache.WeightedSize(); });
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Clear() {
+    const auto clear = [this](Layout& layout) {
+        for (std::size_t i = 0; i < layout.shard_count; ++i) {
+            Shard& shard = layout.shards[i];
+            WriteShard(shard, [&shard](ShardCache& cache) {
+                cache.Clear();
+                shard.spilled.clear();
+                for (const typename SpillTier::Record& record : shard.flushing) {
+                    shard.unflushed.push_back(record.hash);
+                }
+            });
+        }
+    };
+
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    Layout& layout = CurrentLayout();
+    if (Layout* const previous = layout.previous.load(std::memory_order_acquire); previous != nullptr) {
+        clear(*previous);
+    }
+    clear(layout);
+    // After the shards, so nothing they held can be flushed to disk later. A
+    // batch already in flight is erased again when its append returns.
+    if (SpillTier* const tier = disk_tier_.load(std::memory_order_acquire); tier != nullptr) {
+        tier->Clear();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::SetRemovalListener(
+    RemovalListener<Key, Value> listener, const RemovalDelivery delivery) {
+    std::scoped_lock resize_lock(resize_mutex_);
+    if (removals_owner_ != nullptr) {
+        throw std::logic_error("a removal listener is already set");
+    }
+
+    removals_owner_ = std::make_unique<Dispatcher>(std::move(listener), delivery);
+    removals_.store(removals_owner_.get(), std::memory_order_release);
+    for (const std::unique_ptr<Layout>& layout : layouts_) {
+        for (std::size_t i = 0; i < layout->shard_count; ++i) {
+            Shard& shard = layout->shards[i];
+            WriteShard(shard, [&](ShardCache&) { InstallRemovalHandler(shard); });
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::FlushRemovals() {
+    if (Dispatcher* const dispatcher = removals_.load(std::memory_order_acquire); dispatcher != nullptr) {
+        dispatcher->Flush();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Resize(const std::size_t capacity_per_shard) {
+    if (capacity_per_shard == 0U) {
+        throw std::invalid_argument("capacity_per_shard must be greater than zero");
+    }
+    if (adaptive_) {
+        throw std::logic_error("Resize does not apply to a SharedCapacity cache");
+    }
+
+    std::scoped_lock resize_lock(resize_mutex_);
+    Layout& layout = CurrentLayout();
+    FinishMigration(layout);
+    capacity_per_shard_ = capacity_per_shard;
+    for (std::size_t i = 0; i < layout.shard_count; ++i) {
+        bool done = false;
+        while (!done) {
+            WriteShard(layout.shards[i], [&](ShardCache& cache) {
+                const std::size_t excess =
+                    cache.Size() > capacity_per_shard ? cache.Size() - capacity_per_shard : 0U;
+                const std::size_t step = std::min(excess, kMigrationBatch);
+                cache.SetCapacity(capacity_per_shard + (excess - step));
+                done = step == excess;
+            });
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Reshard(const std::size_t shard_count) {
+    if (shard_count == 0U) {
+        throw std::invalid_argument("shard_count must be greater than zero");
+    }
+    if (shard_count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("shard_count must fit in 32 bits");
+    }
+
+    std::scoped_lock resize_lock(resize_mutex_);
+    Layout& old_layout = CurrentLayout();
+    // A migration interrupted by an exception is completed first, so at most
+    // two layouts ever hold entries.
+    FinishMigration(old_layout);
+    RetireDrainedLayouts();
+    if (shard_count == old_layout.shard_count) {
+        return;
+    }
+
+    layouts_.reserve(layouts_.size() + 1U);
+    std::unique_ptr<Layout> next = MakeLayout(shard_count);
+    next->previous.store(&old_layout, std::memory_order_relaxed);
+    Layout& layout = *layouts_.emplace_back(std::move(next));
+    {
+        // Rebalance and adaptive Size work on one layout at a time.
+        std::scoped_lock rebalance_lock(rebalance_mutex_);
+        layout_.store(&layout, std::memory_order_release);
+    }
+    FinishMigration(layout);
+    RetireDrainedLayouts();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::EnableLatencySampling(
+    const std::uint32_t one_in) noexcept {
+    latency_.SetSampleInterval(one_in);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+CacheStats ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Stats() const {
+    CacheStats stats;
+    if constexpr (kCacheMetricsEnabled) {
+        const EpochReclaimer::Guard guard = reclaimer_.Pin();
+        const Layout& layout = CurrentLayout();
+        stats.shards.reserve(layout.shard_count);
+        for (std::size_t i = 0; i < layout.shard_count; ++i) {
+            stats.shards.push_back(layout.shards[i].metrics.Read());
+            stats.total += stats.shards.back();
+        }
+    }
+    latency_.CopyTo(stats);
+    return stats;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename KeyCodec, typename ValueCodec>
+    requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::SaveSnapshot(const std::string& path) {
+    SnapshotWriter writer(path, MakeSnapshotHeader<Key, Value, KeyCodec, ValueCodec>());
+    // A migrating cache saves the previous layout's shards too; an entry
+    // that moves meanwhile may be saved twice, and the later copy wins.
+    // Pinned throughout, so neither layout is freed while the save walks it.
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    const Layout& layout = CurrentLayout();
+    const Layout* const previous = layout.previous.load(std::memory_order_acquire);
+    std::string bytes;
+    std::uint64_t entries = 0;
+    const auto encode = [&](const Key& key, const Value& value, const std::chrono::milliseconds ttl) {
+        AppendSnapshotTtl(bytes, static_cast<std::int64_t>(ttl.count()));
+        KeyCodec::Encode(key, bytes);
+        ValueCodec::Encode(value, bytes);
+        ++entries;
+    };
+    // Copyable entries are copied out under the lock and encoded after it is
+    // released, so the codecs never run while the shard is locked.
+    std::vector<std::tuple<Key, Value, std::chrono::milliseconds>> copied;
+    for (const Layout* current : {previous, &layout}) {
+        for (std::size_t i = 0; current != nullptr && i < current->shard_count; ++i) {
+            bytes.clear();
+            entries = 0;
+            ReadShard(current->shards[i], [&](const ShardCache& cache) {
+                if constexpr (std::is_copy_constructible_v<Value>) {
+                    copied.clear();
+                    copied.reserve(cache.Size());
+                    cache.ForEach(
+                        [&](const Key& key, const Value& value, const std::chrono::milliseconds ttl) {
+                            copied.emplace_back(key, value, ttl);
+                        });
+                } else {
+                    cache.ForEach(encode);
+                }
+            });
+            if constexpr (std::is_copy_constructible_v<Value>) {
+                for (const auto& [key, value, ttl] : copied) {
+                    encode(key, value, ttl);
+                }
+            }
+            writer.AddSection(entries, bytes);
+        }
+    }
+    return static_cast<std::size_t>(writer.Commit());
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename KeyCodec, typename ValueCodec>
+    requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+std::future<std::size_t> ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::SaveSnapshotAsync(
+    std::string path) {
+    return std::async(std::launch::async, [this, path = std::move(path)]() {
+        return SaveSnapshot<KeyCodec, ValueCodec>(path);
+    });
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename KeyCodec, typename ValueCodec>
+    requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::LoadSnapshot(const std::string& path,
+                                                                                 const std::size_t threads) {
+    const SnapshotFile file(path);
+    file.CheckCompatible(MakeSnapshotHeader<Key, Value, KeyCodec, ValueCodec>());
+    const std::vector<SnapshotFile::Section>& sections = file.Sections();
+
+    std::atomic<std::size_t> next_section{0};
+    std::atomic<std::size_t> loaded{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto load_sections = [&]() {
+        try {
+            for (std::size_t i = next_section.fetch_add(1U); i < sections.size() && !failed.load();
+                 i = next_section.fetch_add(1U)) {
+                SnapshotReader reader(sections[i].bytes);
+                for (std::uint64_t entry = 0; entry < sections[i].entry_count; ++entry) {
+                    const std::chrono::milliseconds ttl(ReadSnapshotTtl(reader));
+                    Key key = KeyCodec::Decode(reader);
+                    Value value = ValueCodec::Decode(reader);
+                    if (ttl < std::chrono::milliseconds::zero()) {
+                        throw std::runtime_error("snapshot entry has a negative TTL");
+                    }
+                    WriteKey(key, [&](ShardCache& cache) { cache.Put(std::move(key), std::move(value), ttl); });
+                    loaded.fetch_add(1U, std::memory_order_relaxed);
+                }
+                if (!reader.AtEnd()) {
+                    throw std::runtime_error("snapshot section has trailing bytes");
+                }
+            }
+        } catch (...) {
+            const std::scoped_lock lock(error_mutex);
+            if (error == nullptr) {
+                error = std::current_exception();
+            }
+            failed.store(true);
+        }
+    };
+
+    // The calling thread loads too.
+    const std::size_t requested =
+        threads != 0U ? threads : std::max(1U, std::thread::hardware_concurrency());
+    const std::size_t workers = std::min(requested, std::max<std::size_t>(1U, sections.size()));
+    std::vector<std::thread> helpers;
+    helpers.reserve(workers - 1U);
+    for (std::size_t i = 1; i < workers; ++i) {
+        helpers.emplace_back(load_sections);
+    }
+    load_sections();
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+    return loaded.load();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ScopedLatency::ScopedLatency(
+    ShardedLRUCache& cache, LatencyHistogram LatencyMetrics::*const histogram) noexcept
+    : histogram_(cache.latency_.Sample(histogram)) {
+    if (histogram_ != nullptr) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ScopedLatency::~ScopedLatency() {
+    if (histogram_ != nullptr) {
+        histogram_->Record(std::chrono::steady_clock::now() - start_);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardArrayDeleter::operator()(
+    Shard* const shards) const noexcept {
+    std::destroy_n(shards, count);
+    std::allocator<Shard>{}.deallocate(shards, count);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardArray
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MakeShards(
+    const std::size_t count, const std::size_t capacity, const std::size_t max_weight, const Weigher& weigher,
+    const std::chrono::milliseconds default_ttl) {
+    // Shards hold a mutex and cannot be moved, so they are constructed in place
+    // in one over-aligned allocation rather than through std::vector.
+    std::allocator<Shard> allocator;
+    Shard* const shards = allocator.allocate(count);
+    std::size_t constructed = 0;
+    try {
+        for (; constructed < count; ++constructed) {
+            std::construct_at(shards + constructed, capacity, max_weight, weigher, default_ttl);
+        }
+    } catch (...) {
+        std::destroy_n(shards, constructed);
+        allocator.deallocate(shards, count);
+        throw;
+    }
+
+    return ShardArray(shards, ShardArrayDeleter{count});
+}
 
-    shards_.reserve(shard_count_);
-    for (std::size_t i = 0; i < shard_count_; ++i) {
-        shards_.push_back(std::make_unique<Shard>(capacity_per_shard_));
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::unique_ptr<typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Layout>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MakeLayout(const std::size_t count) const {
+    // Adaptive shards are built (and their policies sized) for the largest
+    // quota.
+    const std::size_t capacity =
+        adaptive_ ? MaxQuota(SharedCapacity{total_capacity_}, count) : capacity_per_shard_;
+    auto layout = std::make_unique<Layout>(
+        MakeShards(count, capacity, max_weight_per_shard_, weigher_, default_ttl_), count);
+    if (adaptive_) {
+        AssignEqualQuotas(*layout);
+    }
+    if (disk_tier_.load(std::memory_order_acquire) != nullptr ||
+        removals_.load(std::memory_order_acquire) != nullptr) {
+        for (std::size_t i = 0; i < count; ++i) {
+            InstallRemovalHandler(layout->shards[i]);
+        }
+    }
+    if (refresher_.load(std::memory_order_acquire) != nullptr) {
+        for (std::size_t i = 0; i < count; ++i) {
+            layout->shards[i].cache.EnableWriteStamps();
+        }
     }
+    return layout;
 }
 
-template <typename Key, typename Value>
-std::optional<Value> ShardedLRUCache<Key, Value>::Get(const Key& key) {
-    const std::size_t shard_index = ShardIndexForKey(key);
-    Shard& shard = *shards_[shard_index];
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::AssignEqualQuotas(Layout& layout) const {
+    const std::size_t count = layout.shard_count;
+    const std::size_t share = total_capacity_ / count;
+    layout.min_quota = std::max<std::size_t>(1U, share / kQuotaFactor);
+    layout.max_quota = MaxQuota(SharedCapacity{total_capacity_}, count);
+    for (std::size_t i = 0; i < count; ++i) {
+        Shard& shard = layout.shards[i];
+        const std::size_t quota = share + (i < total_capacity_ % count ? 1U : 0U);
+        shard.target_quota.store(quota, std::memory_order_relaxed);
+        shard.quota.store(quota, std::memory_order_relaxed);
+        shard.spare_quota = &layout.spare_quota;
+        shard.cache.SetCapacity(quota);
+    }
+}
 
-    std::scoped_lock lock(shard.mutex);
-    return shard.cache.Get(key);
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Layout&
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::CurrentLayout() const noexcept {
+    return *layout_.load(std::memory_order_acquire);
 }
 
-template <typename Key, typename Value>
-void ShardedLRUCache<Key, Value>::Put(const Key& key, const Value& value) {
-    const std::size_t shard_index = ShardIndexForKey(key);
-    Shard& shard = *shards_[shard_index];
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::FinishMigration(Layout& layout) {
+    Layout* const previous = layout.previous.load(std::memory_order_relaxed);
+    if (previous == nullptr) {
+        return;
+    }
 
-    std::scoped_lock lock(shard.mutex);
-    shard.cache.Put(key, value);
+    for (std::size_t i = 0; i < previous->shard_count; ++i) {
+        MigrateShard(previous->shards[i], layout);
+    }
+    layout.previous.store(nullptr, std::memory_order_release);
 }
 
-template <typename Key, typename Value>
-std::size_t ShardedLRUCache<Key, Value>::Size() const {
-    std::size_t total_size = 0;
-    for (const auto& shard_ptr : shards_) {
-        std::scoped_lock lock(shard_ptr->mutex);
-        total_size += shard_ptr->cache.Size();
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MigrateShard(Shard& old_shard, Layout& layout) {
+    bool drained = false;
+    while (!drained) {
+        // Lock order is always old shard, then new shard, as in WriteKey.
+        WriteShard(old_shard, [&](ShardCache& cache) {
+            // A key still here was either not written since the migration
+            // began or last written by a caller holding the old layout;
+            // either way this copy is the newest, so it overwrites.
+            (void)cache.Extract(kMigrationBatch, [&](Key&& key, Value&& value,
+                                                      const std::chrono::milliseconds ttl) {
+                Shard& target = layout.shards[ShardIndexForHash(layout, HashOf(key))];
+                WriteShard(target, [&](ShardCache& target_cache) {
+                    target_cache.Put(std::move(key), std::move(value), ttl);
+                });
+            });
+            if (cache.Size() == 0U) {
+                // Also drops whatever ghost history the policy keeps.
+                cache.Clear();
+                old_shard.retired = true;
+                drained = true;
+                // A reload scheduled from now on would outlive the layout.
+                std::scoped_lock refresh_lock(old_shard.refresh_mutex);
+                old_shard.takes_refreshes = false;
+            }
+        });
     }
+}
 
-    return total_size;
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RetireDrainedLayouts() {
+    // Only the current layout is reachable outside a migration; readers
+    // still pinned from before it was published keep the rest alive until
+    // they unpin. Retired layouts go to the shared list, so the next write
+    // frees them rather than this thread's next Reshard.
+    const auto retire = [this](std::unique_ptr<Layout>& layout) {
+        if (layout.get() == layout_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        for (std::size_t i = 0; i < layout->shard_count; ++i) {
+            if (layout->shards[i].users.load(std::memory_order_acquire) != 0U) {
+                return false;
+            }
+        }
+        reclaimer_.RetireShared(layout.release());
+        return true;
+    };
+    std::erase_if(layouts_, retire);
+    reclaimer_.ReclaimShared();
 }
 
-template <typename Key, typename Value>
-void ShardedLRUCache<Key, Value>::Clear() {
-    for (auto& shard_ptr : shards_) {
-        std::scoped_lock lock(shard_ptr->mutex);
-        shard_ptr->cache.Clear();
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename Read>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ReadShard(Shard& shard, Read&& read) {
+    if constexpr (kBufferedReads) {
+        {
+            std::shared_lock lock(shard.mutex, std::defer_lock);
+            if (!AcquireShardLock<kWait>(shard, lock)) {
+                return false;
+            }
+            read(shard.cache);
+        }
+        if (shard.cache.NeedsDrain()) {
+            std::unique_lock lock(shard.mutex, std::try_to_lock);
+            if (lock.owns_lock()) {
+                shard.cache.Drain();
+            }
+        }
+    } else if constexpr (kSharedReads) {
+        std::shared_lock lock(shard.mutex, std::defer_lock);
+        if (!AcquireShardLock<kWait>(shard, lock)) {
+            return false;
+        }
+        read(shard.cache);
+    } else {
+        // An exclusive Get removes the expired entries it finds.
+        RemovalScope removals(*this);
+        std::unique_lock lock(shard.mutex, std::defer_lock);
+        if (!AcquireShardLock<kWait>(shard, lock)) {
+            return false;
+        }
+        removals.Arm();
+        read(shard.cache);
     }
+    return true;
 }
 
-template <typename Key, typename Value>
-std::size_t ShardedLRUCache<Key, Value>::ShardIndexForKey(const Key& key) const noexcept {
-    return hasher_(key) % shard_count_;
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K, typename Visitor>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Probe
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::GetWithFront(const Layout& layout, Shard& shard,
+                                                                     const std::uint64_t hash, const K& key,
+                                                                     Visitor& visitor) {
+    FrontCache<Key, Value>& front = LocalFrontCache();
+    // Draining bumps a shard's version, so a matching copy is never from a
+    // retired shard.
+    if (auto* const slot = front.Find(layout.front_owner, hash, key); slot != nullptr) {
+        if (slot->version == shard.version.load(std::memory_order_acquire) &&
+            slot->hits + 1U < kFrontRefreshInterval) {
+            ++slot->hits;
+            std::invoke(visitor, std::as_const(slot->entry->second));
+            return Probe::kHit;
+        }
+        // Hits served from the copy are counted in one batch as it goes back
+        // to the shard, so a front-cache hit writes no shared counter.
+        Count(shard, &ShardCounters::hits, std::exchange(slot->hits, 0U));
+    }
+
+    // The value and the version it belongs to are copied under one lock;
+    // writers bump the version only while holding the exclusive lock.
+    std::optional<Value> copy;
+    std::uint64_t version = 0;
+    Probe probe = Probe::kMiss;
+    Stamp written{};
+    ReadShard(shard, [&](ShardCache& cache) {
+        if (shard.retired) {
+            probe = Probe::kRetired;
+            return;
+        }
+        const auto visit = [&](const Value& value) {
+            std::invoke(visitor, value);
+            if (!cache.HasExpiringEntries()) {
+                copy.emplace(value);
+                version = shard.version.load(std::memory_order_relaxed);
+            }
+        };
+        if (VisitLocked(cache, key, visit, &written)) {
+            probe = Probe::kHit;
+        }
+    });
+    if (probe == Probe::kHit) {
+        Count(shard, &ShardCounters::hits);
+        if (DueForRefresh(written)) {
+            ScheduleRefresh(shard, key, written);
+        }
+    }
+
+    if (probe == Probe::kHit && copy.has_value()) {
+        front.Store(layout.front_owner, hash, version, Key(key), std::move(*copy));
+    }
+    return probe;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename K, typename Visitor>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Probe
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ProbeShard(
+    Shard& shard, const K& key, Visitor& visitor) {
+    Probe probe = Probe::kMiss;
+    Stamp written{};
+    const bool locked = ReadShard<kWait>(shard, [&](ShardCache& cache) {
+        if (shard.retired) {
+            probe = Probe::kRetired;
+        } else if (VisitLocked(cache, key, visitor, &written)) {
+            probe = Probe::kHit;
+        }
+    });
+    if (!locked) {
+        return Probe::kBusy;
+    }
+    if (probe == Probe::kHit) {
+        Count(shard, &ShardCounters::hits);
+        if (DueForRefresh(written)) {
+            ScheduleRefresh(shard, key, written);
+        }
+    }
+    return probe;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Probe
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ProbeContains(const Shard& shard, const K& key) {
+    const auto probe = [&shard, &key] {
+        if (shard.retired) {
+            return Probe::kRetired;
+        }
+        return shard.cache.Contains(key) ? Probe::kHit : Probe::kMiss;
+    };
+
+    if constexpr (kSharedReads) {
+        std::shared_lock lock(shard.mutex, std::defer_lock);
+        AcquireShardLock(shard, lock);
+        return probe();
+    } else {
+        std::unique_lock lock(shard.mutex, std::defer_lock);
+        AcquireShardLock(shard, lock);
+        return probe();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename Write>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::WriteShard(Shard& shard, Write&& write) {
+    struct VersionBump {
+        std::atomic<std::uint64_t>& version;
+
+        ~VersionBump() { version.fetch_add(1U, std::memory_order_release); }
+    };
+
+    SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+    bool flush = false;
+    RemovalScope removals(*this);
+    {
+        std::unique_lock lock(shard.mutex, std::defer_lock);
+        if (!AcquireShardLock<kWait>(shard, lock)) {
+            return false;
+        }
+        removals.Arm();
+        // Declared after the lock, so the bump happens before the unlock.
+        const VersionBump bump{shard.version};
+        if (adaptive_) {
+            ApplyQuota(shard);
+        }
+        write(shard.cache);
+        if constexpr (kCacheMetricsEnabled) {
+            shard.metrics.evictions.store(shard.cache.Evictions(), std::memory_order_relaxed);
+        }
+        // The batch is taken here and appended after the unlock.
+        if (tier != nullptr && !shard.appending && DueForSpill(shard)) {
+            shard.flushing = std::exchange(shard.spilled, {});
+            shard.appending = true;
+            flush = true;
+        }
+    }
+    if (flush) {
+        FlushSpilled(shard, *tier);
+    }
+    return true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::DueForSpill(const Shard& shard) noexcept {
+    // A retired shard takes no more writes, so its remainder goes now.
+    return !shard.spilled.empty() && (shard.spilled.size() >= kSpillBatch || shard.retired);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::FlushSpilled(Shard& shard, SpillTier& tier) {
+    bool appended = false;
+    for (bool more = true; more;) {
+        bool ok = true;
+        try {
+            tier.Append(shard.flushing);
+        } catch (const std::system_error&) {
+            // Evicted entries may always be lost; the cache stays usable.
+            ok = false;
+        }
+        appended = appended || ok;
+
+        std::scoped_lock lock(shard.mutex);
+        if (ok) {
+            for (const std::uint64_t hash : shard.unflushed) {
+                tier.Erase(hash);
+            }
+        }
+        shard.unflushed.clear();
+        shard.flushing.clear();
+        more = DueForSpill(shard);
+        if (more) {
+            shard.flushing = std::exchange(shard.spilled, {});
+        } else {
+            shard.appending = false;
+        }
+    }
+    if (appended) {
+        tier.Maintain();
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename Lock>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::AcquireShardLock(
+    const Shard& shard, Lock& lock) {
+    if constexpr (!kWait) {
+        if (lock.try_lock()) {
+            return true;
+        }
+        Count(shard, &ShardCounters::contended_locks);
+        return false;
+    } else if constexpr (kCacheMetricsEnabled) {
+        // The uncontended path costs what a plain lock() would; only a
+        // caller that is about to block reads the clock.
+        if (lock.try_lock()) {
+            return true;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        const auto waited = std::chrono::steady_clock::now() - start;
+        Count(shard, &ShardCounters::contended_locks);
+        const auto waited_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+        Count(shard, &ShardCounters::lock_wait_ns, static_cast<std::uint64_t>(waited_ns));
+        return true;
+    } else {
+        (void)shard;
+        lock.lock();
+        return true;
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Count(
+    const Shard& shard, std::atomic<std::uint64_t> ShardCounters::*const counter,
+    const std::uint64_t amount) noexcept {
+    if constexpr (kCacheMetricsEnabled) {
+        if (amount != 0U) {
+            (shard.metrics.*counter).fetch_add(amount, std::memory_order_relaxed);
+        }
+    } else {
+        (void)shard;
+        (void)counter;
+        (void)amount;
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <bool kWait, typename K, typename Write>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::WriteKey(const K& key, Write&& write) {
+    const ScopedLatency timer(*this, &LatencyMetrics::put);
+    const std::uint64_t hash = HashOf(key);
+    // Frees drained layouts left to readers that were pinned at the time.
+    reclaimer_.ReclaimShared();
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    for (;;) {
+        Layout& layout = CurrentLayout();
+        Shard& shard = layout.shards[ShardIndexForHash(layout, hash)];
+        // `write` runs at most once; a retired shard leaves it untouched for
+        // the retry.
+        bool written = false;
+        SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+        const auto write_current = [&](ShardCache& cache) {
+            if (!shard.retired) {
+                if (tier != nullptr) {
+                    ForgetSpilled(shard, *tier, key, hash);
+                }
+                write(cache);
+                written = true;
+            }
+        };
+
+        if (Layout* const previous = layout.previous.load(std::memory_order_acquire); previous == nullptr) {
+            if (!WriteShard<kWait>(shard, write_current)) {
+                return false;
+            }
+        } else {
+            // The old copy is dropped and the new one stored under the old
+            // shard's lock, so a reader probing old then new sees one or the
+            // other, never neither and never the old value after the write.
+            // Migrations are short, so this waits for both locks regardless
+            // of kWait.
+            Shard& old_shard = previous->shards[ShardIndexForHash(*previous, hash)];
+            WriteShard(old_shard, [&](ShardCache& old_cache) {
+                if (!old_shard.retired) {
+                    (void)old_cache.Erase(key, RemovalCause::kReplaced);
+                    if (tier != nullptr) {
+                        ForgetSpilled(old_shard, *tier, key, hash);
+                    }
+                }
+                WriteShard(shard, write_current);
+            });
+        }
+        if (written) {
+            Count(shard, &ShardCounters::puts);
+            return true;
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::InstallRemovalHandler(Shard& shard) const {
+    const auto handler = [this, &shard](Key&& key, Value&& value, const std::chrono::milliseconds ttl,
+                                        const RemovalCause cause) {
+        if (cause == RemovalCause::kCapacity && disk_tier_.load(std::memory_order_acquire) != nullptr) {
+            // Buffered entries keep aging, so the deadline is stored.
+            std::chrono::steady_clock::time_point deadline{};
+            if (ttl > std::chrono::milliseconds::zero()) {
+                deadline = std::chrono::steady_clock::now() + ttl;
+            }
+            const std::uint64_t hash = HashOf(key);
+            shard.spilled.push_back(
+                typename SpillTier::Record{hash, std::move(key), std::move(value), deadline});
+            return;
+        }
+
+        // No frame: the lock was taken before the listener was set.
+        RemovalFrame* const frame = CurrentRemovalFrame();
+        if (frame == nullptr || frame->cache != this) {
+            return;
+        }
+        RemovalEvent<Key, Value> event{std::move(key), std::move(value), cause};
+        if (frame->dispatcher->Delivery() == RemovalDelivery::kSync) {
+            frame->events.push_back(std::move(event));
+        } else {
+            frame->dispatcher->Enqueue(std::move(event));
+            frame->enqueued = true;
+        }
+    };
+    shard.cache.SetRemovalHandler(handler);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RemovalFrame*&
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::CurrentRemovalFrame() noexcept {
+    thread_local RemovalFrame* frame = nullptr;
+    return frame;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RemovalScope::~RemovalScope() {
+    if (!owner_) {
+        return;
+    }
+    CurrentRemovalFrame() = frame_.outer;
+    if (frame_.enqueued) {
+        frame_.dispatcher->Notify();
+    }
+    frame_.dispatcher->Deliver(frame_.events);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RemovalScope::Arm() noexcept {
+    Dispatcher* const dispatcher = cache_.removals_.load(std::memory_order_acquire);
+    if (dispatcher == nullptr) {
+        return;
+    }
+    RemovalFrame*& current = CurrentRemovalFrame();
+    if (current != nullptr && current->cache == &cache_) {
+        return;
+    }
+
+    frame_.cache = &cache_;
+    frame_.dispatcher = dispatcher;
+    frame_.outer = current;
+    current = &frame_;
+    owner_ = true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ForgetSpilled(
+    Shard& shard, SpillTier& tier, const K& key, const std::uint64_t hash) {
+    std::erase_if(shard.spilled, [&](const typename SpillTier::Record& record) {
+        return record.hash == hash && record.key == key;
+    });
+    // May also drop a colliding key's record, which only costs a miss.
+    tier.Erase(hash);
+    // A copy still being appended is erased again once it lands.
+    if (shard.appending &&
+        std::ranges::find(shard.flushing, hash, &SpillTier::Record::hash) != shard.flushing.end()) {
+        shard.unflushed.push_back(hash);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+const typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::SpillTier::Record*
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::FindSpilled(const Shard& shard, const K& key,
+                                                                    const std::uint64_t hash) {
+    const auto matches = [&](const typename SpillTier::Record& record) {
+        return record.hash == hash && record.key == key;
+    };
+    if (const auto spilled = std::ranges::find_if(shard.spilled, matches); spilled != shard.spilled.end()) {
+        return &*spilled;
+    }
+    // A move-only record cannot be taken from under the append.
+    if constexpr (!std::is_copy_constructible_v<typename SpillTier::Record>) {
+        return nullptr;
+    }
+    if (!shard.appending || std::ranges::find(shard.unflushed, hash) != shard.unflushed.end()) {
+        return nullptr;
+    }
+    const auto flushing = std::ranges::find_if(shard.flushing, matches);
+    return flushing != shard.flushing.end() ? &*flushing : nullptr;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K, typename Visitor>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::PromoteFromDisk(Shard& shard, const K& key,
+                                                                             const std::uint64_t hash,
+                                                                             Visitor& visitor) {
+    SpillTier* const tier = disk_tier_.load(std::memory_order_acquire);
+    if (tier == nullptr) {
+        return false;
+    }
+
+    // Recent evictions are still in the shard's buffers. The scan takes the
+    // read lock; the write lock (and the version bump that invalidates
+    // front-cache copies) is taken only to move a match back in.
+    bool buffered = false;
+    bool retired = false;
+    ReadShard(shard, [&](const ShardCache&) {
+        retired = shard.retired;
+        buffered = !retired && FindSpilled(shard, key, hash) != nullptr;
+    });
+    if (retired) {
+        return false;
+    }
+    bool found = false;
+    if (buffered) {
+        WriteShard(shard, [&](ShardCache& cache) {
+            if (shard.retired) {
+                return;
+            }
+            const auto matches = [&](const typename SpillTier::Record& record) {
+                return record.hash == hash && record.key == key;
+            };
+            std::optional<typename SpillTier::Record> record;
+            const auto spilled = std::ranges::find_if(shard.spilled, matches);
+            if (spilled != shard.spilled.end()) {
+                record.emplace(std::move(*spilled));
+                shard.spilled.erase(spilled);
+            } else if constexpr (std::is_copy_constructible_v<typename SpillTier::Record>) {
+                // A record still being appended is copied, and its disk copy
+                // erased once the append returns.
+                const typename SpillTier::Record* const in_flight = FindSpilled(shard, key, hash);
+                if (in_flight == nullptr) {
+                    return;
+                }
+                record.emplace(*in_flight);
+                shard.unflushed.push_back(hash);
+            } else {
+                return;
+            }
+            std::chrono::milliseconds ttl = std::chrono::milliseconds::zero();
+            if (record->deadline != std::chrono::steady_clock::time_point{}) {
+                const auto left = record->deadline - std::chrono::steady_clock::now();
+                ttl = std::chrono::ceil<std::chrono::milliseconds>(left);
+                if (ttl <= std::chrono::milliseconds::zero()) {
+                    return;
+                }
+            }
+            cache.Put(std::move(record->key), std::move(record->value), ttl);
+            found = cache.GetWith(key, visitor);
+        });
+        return found;
+    }
+
+    // The read runs unlocked. The record is taken only if it is still the
+    // one read: a write to the key since then erased or superseded it.
+    std::optional<typename SpillTier::Found> record = tier->Read(key, hash);
+    if (!record.has_value()) {
+        return false;
+    }
+    WriteShard(shard, [&](ShardCache& cache) {
+        // An unflushed hash was written or cleared while its copy was in
+        // flight, so the copy just read is stale.
+        if (shard.retired || std::ranges::find(shard.unflushed, hash) != shard.unflushed.end() ||
+            !tier->Remove(hash, record->location)) {
+            return;
+        }
+        cache.Put(std::move(record->key), std::move(record->value), record->ttl);
+        found = cache.GetWith(key, visitor);
+    });
+    return found;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::DueForRefresh(
+    const Stamp written) const noexcept {
+    const Refresher* const refresher = refresher_.load(std::memory_order_acquire);
+    return refresher != nullptr && CoarseNow() - written >= refresher->options.refresh_after;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Stamp
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::CoarseNow() noexcept {
+#ifdef CLOCK_MONOTONIC_COARSE
+    // steady_clock reads CLOCK_MONOTONIC, so both share an epoch.
+    timespec now{};
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &now) == 0) {
+        const auto since_boot = std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+        return Stamp(std::chrono::duration_cast<std::chrono::steady_clock::duration>(since_boot));
+    }
+#endif
+    return std::chrono::steady_clock::now();
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ScheduleRefresh(Shard& shard, const K& key,
+                                                                             const Stamp stamp) {
+    Refresher& refresher = *refresher_.load(std::memory_order_acquire);
+    Key owned(key);
+    {
+        std::scoped_lock lock(shard.refresh_mutex);
+        if (!shard.takes_refreshes || !shard.refreshing.insert(owned).second) {
+            return;
+        }
+        shard.users.fetch_add(1U, std::memory_order_relaxed);
+    }
+
+    bool submitted = false;
+    try {
+        submitted = refresher.pool.TrySubmit([this, &shard, owned, stamp] { Refresh(shard, owned, stamp); });
+    } catch (...) {
+        // Treated like a full pool: the entry keeps being served as is.
+    }
+    if (submitted) {
+        refresher.scheduled.fetch_add(1U, std::memory_order_relaxed);
+        return;
+    }
+    refresher.rejected.fetch_add(1U, std::memory_order_relaxed);
+    {
+        std::scoped_lock lock(shard.refresh_mutex);
+        shard.refreshing.erase(owned);
+    }
+    shard.users.fetch_sub(1U, std::memory_order_release);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Refresh(
+    Shard& shard, const Key& key, const Stamp stamp) {
+    Refresher& refresher = *refresher_.load(std::memory_order_acquire);
+    // The loader runs with no lock held; readers keep getting the old value.
+    std::optional<Value> value;
+    try {
+        value.emplace(std::invoke(refresher.loader, key));
+    } catch (...) {
+        refresher.failed.fetch_add(1U, std::memory_order_relaxed);
+    }
+
+    // A write since the read gave the entry a new stamp; an eviction or
+    // erase took the stamp away.
+    bool replaced = false;
+    WriteShard(shard, [&](ShardCache& cache) {
+        if (value.has_value() && !shard.retired && cache.WriteStampOf(key) == stamp) {
+            cache.Emplace(key, std::move(*value));
+            replaced = true;
+        }
+    });
+    {
+        std::scoped_lock lock(shard.refresh_mutex);
+        shard.refreshing.erase(key);
+    }
+    shard.users.fetch_sub(1U, std::memory_order_release);
+    if (replaced) {
+        refresher.replaced.fetch_add(1U, std::memory_order_relaxed);
+    } else if (value.has_value()) {
+        refresher.discarded.fetch_add(1U, std::memory_order_relaxed);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::FinishAsyncLoad(
+    AsyncLoad& load, const std::optional<Value>& value, const std::exception_ptr error) {
+    std::vector<std::pair<std::coroutine_handle<>, Executor*>> waiters;
+    {
+        std::scoped_lock lock(load.mutex);
+        load.value = value;
+        load.error = error;
+        load.done = true;
+        waiters.swap(load.waiters);
+    }
+    // Posted, not resumed here, so each waiter runs on its own executor and
+    // the loading coroutine does not run the waiters' code.
+    for (const auto& [handle, executor] : waiters) {
+        executor->Post(handle);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::AwaitLoad::await_suspend(
+    const std::coroutine_handle<> handle) const {
+    std::scoped_lock lock(load_->mutex);
+    if (load_->done) {
+        return false;
+    }
+    load_->waiters.emplace_back(handle, &executor_);
+    return true;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+Value ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::AwaitLoad::await_resume() const {
+    // The result was written under the mutex before `done` was seen there
+    // or this coroutine was posted.
+    if (load_->error != nullptr) {
+        std::rethrow_exception(load_->error);
+    }
+    return *load_->value;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+FrontCache<Key, Value>& ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::LocalFrontCache() {
+    thread_local FrontCache<Key, Value> front;
+    return front;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K, typename Visitor>
+bool ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::VisitLocked(
+    ShardCache& cache, const K& key, Visitor&& visitor, Stamp* const written) {
+    if constexpr (kSharedReads) {
+        return cache.GetWithShared(key, visitor, written);
+    } else {
+        return cache.GetWith(key, visitor, written);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename KeyAt>
+std::vector<typename ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardSlot>
+ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::GroupByShard(
+    const Layout& layout, const std::size_t count, KeyAt key_at) const {
+    std::vector<ShardSlot> slots(count);
+    if (count == 0U) {
+        return slots;
+    }
+
+    std::vector<std::size_t> shard_of(count);
+    for (std::size_t position = 0; position < count; ++position) {
+        shard_of[position] = ShardIndexForHash(layout, HashOf(key_at(position)));
+    }
+
+    // Counting sort keyed by shard is linear and stable; it only pays off
+    // while the shard table is not much larger than the batch.
+    const std::size_t shard_count = layout.shard_count;
+    if (shard_count <= count * 4U) {
+        std::vector<std::size_t> offsets(shard_count + 1U, 0U);
+        for (const std::size_t shard : shard_of) {
+            ++offsets[shard + 1U];
+        }
+        for (std::size_t shard = 0; shard < shard_count; ++shard) {
+            offsets[shard + 1U] += offsets[shard];
+        }
+        for (std::size_t position = 0; position < count; ++position) {
+            slots[offsets[shard_of[position]]++] = ShardSlot{shard_of[position], position};
+        }
+        return slots;
+    }
+
+    for (std::size_t position = 0; position < count; ++position) {
+        slots[position] = ShardSlot{shard_of[position], position};
+    }
+    std::sort(slots.begin(), slots.end(), [](const ShardSlot& left, const ShardSlot& right) {
+        return left.shard != right.shard ? left.shard < right.shard : left.position < right.position;
+    });
+    return slots;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename Measure>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::SumShards(Measure measure) const {
+    // The previous layout goes first: an entry that moves meanwhile is then
+    // counted twice rather than missed.
+    const EpochReclaimer::Guard guard = reclaimer_.Pin();
+    const Layout& layout = CurrentLayout();
+    const Layout* const previous = layout.previous.load(std::memory_order_acquire);
+    std::size_t total = 0;
+    for (const Layout* current : {previous, &layout}) {
+        for (std::size_t i = 0; current != nullptr && i < current->shard_count; ++i) {
+            std::scoped_lock lock(current->shards[i].mutex);
+            total += measure(current->shards[i].cache);
+        }
+    }
+
+    return total;
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+template <typename K>
+std::uint64_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::HashOf(const K& key) const {
+    return Selector::Hash(static_cast<std::uint64_t>(hasher_(key)));
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ShardIndexForHash(
+    const Layout& layout, const std::uint64_t hash) noexcept {
+    return Selector::Index(hash, layout.shard_count);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+std::size_t ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::MaxQuota(const SharedCapacity capacity,
+                                                                             const std::size_t shard_count) {
+    if (shard_count == 0U) {
+        throw std::invalid_argument("shard_count must be greater than zero");
+    }
+    if (capacity.total < shard_count) {
+        throw std::invalid_argument("total capacity must be at least shard_count");
+    }
+
+    const std::size_t share = (capacity.total + shard_count - 1U) / shard_count;
+    return std::min(capacity.total, share * kQuotaFactor);
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::RecordMisses(
+    Shard& shard, const std::uint64_t count) {
+    const std::uint64_t before = shard.misses.fetch_add(count, std::memory_order_relaxed);
+    if (before >= kRebalanceInterval || before + count < kRebalanceInterval) {
+        return;
+    }
+
+    {
+        // Whoever crosses the interval rebalances; if a rebalance is already
+        // running it will pick these misses up, so there is nothing to wait
+        // for.
+        std::unique_lock lock(rebalance_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        Rebalance();
+    }
+
+    // Shrinks free the capacity growing shards wait for, and a shard with
+    // few misses may rarely write. A shard whose lock is busy applies its
+    // quota on its next write instead.
+    Layout& layout = CurrentLayout();
+    for (std::size_t i = 0; i < layout.shard_count; ++i) {
+        Shard& other = layout.shards[i];
+        const std::size_t target = other.target_quota.load(std::memory_order_relaxed);
+        if (target < other.quota.load(std::memory_order_relaxed)) {
+            (void)WriteShard<false>(other, [](ShardCache&) {});
+        }
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::Rebalance() {
+    // Quotas restart equal once a migration ends, so a round during one
+    // would be wasted.
+    Layout& layout = CurrentLayout();
+    if (layout.previous.load(std::memory_order_acquire) != nullptr) {
+        return;
+    }
+
+    const std::size_t shard_count = layout.shard_count;
+    std::vector<std::uint64_t> misses(shard_count);
+    std::uint64_t total_misses = 0;
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        misses[i] = layout.shards[i].misses.exchange(0U, std::memory_order_relaxed);
+        total_misses += misses[i];
+    }
+    if (total_misses == 0U) {
+        return;
+    }
+
+    // Moving halfway damps oscillation when miss pressure shifts.
+    const std::size_t lendable = total_capacity_ - shard_count * layout.min_quota;
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        std::atomic<std::size_t>& target = layout.shards[i].target_quota;
+        const double fraction = static_cast<double>(misses[i]) / static_cast<double>(total_misses);
+        const std::size_t share =
+            layout.min_quota + static_cast<std::size_t>(static_cast<double>(lendable) * fraction);
+        const std::size_t current = target.load(std::memory_order_relaxed);
+        target.store(std::clamp(current / 2U + share / 2U, layout.min_quota, layout.max_quota),
+                     std::memory_order_relaxed);
+    }
+}
+
+template <typename Key, typename Value, EvictionPolicy<Key> Policy, EntryWeigher<Key, Value> Weigher,
+          ShardSelector Selector>
+void ShardedLRUCache<Key, Value, Policy, Weigher, Selector>::ApplyQuota(Shard& shard) {
+    const std::size_t target = shard.target_quota.load(std::memory_order_relaxed);
+    const std::size_t quota = shard.quota.load(std::memory_order_relaxed);
+    if (target < quota) {
+        shard.cache.SetCapacity(target);
+        shard.quota.store(target, std::memory_order_relaxed);
+        // Released only once the evictions are done, so a shard that takes
+        // the capacity never makes the shards hold more than the total.
+        shard.spare_quota->fetch_add(quota - target, std::memory_order_release);
+        return;
+    }
+
+    std::atomic<std::size_t>& pool = *shard.spare_quota;
+    const std::size_t wanted = target > quota ? target - quota : 0U;
+    std::size_t spare = pool.load(std::memory_order_acquire);
+    std::size_t grant = std::min(wanted, spare);
+    while (grant != 0U && !pool.compare_exchange_weak(spare, spare - grant, std::memory_order_acquire)) {
+        grant = std::min(wanted, spare);
+    }
+    if (grant != 0U) {
+        shard.cache.SetCapacity(quota + grant);
+        shard.quota.store(quota + grant, std::memory_order_relaxed);
+    }
 }
 
 #endif  // SHARDED_LRU_CACHE_SHARDEDLRUCACHE_CPP
@@ -1,25 +1,111 @@
 #ifndef SHARDED_LRU_CACHE_SHARDEDLRUCACHE_H
 #define SHARDED_LRU_CACHE_SHARDEDLRUCACHE_H
 
+#include "ArcPolicy.h"
+#include "BufferedPolicy.h"
+#include "CacheMetrics.h"
+#include "CacheTraits.h"
+#include "ClockPolicy.h"
+#include "DiskTier.h"
+#include "EpochReclaimer.h"
+#include "Executor.h"
+#include "FrontCache.h"
+#include "HashMix.h"
 #include "LRUCache.h"
+#include "RemovalListener.h"
+#include "S3FifoPolicy.h"
+#include "Snapshot.h"
+#include "Task.h"
+#include "TinyLfuPolicy.h"
+#include "TwoQueuePolicy.h"
+#include "WorkerPool.h"
 
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <time.h>
+
+// One capacity shared by all shards of a ShardedLRUCache, which then adapts
+// per-shard quotas to where misses occur.
+struct SharedCapacity {
+    std::size_t total;
+};
+
+struct RefreshOptions {
+    // A hit on an entry written at least this long ago schedules a reload.
+    std::chrono::milliseconds refresh_after;
+    std::size_t threads = 1;
+    // Reloads waiting for a thread; past this, stale hits schedule nothing.
+    std::size_t max_pending = 1024;
+};
+
+struct RefreshAheadStats {
+    std::uint64_t scheduled = 0;
+    // Reloads stored, and reloads dropped because the entry was evicted,
+    // erased or overwritten while they ran.
+    std::uint64_t replaced = 0;
+    std::uint64_t discarded = 0;
+    // Reloads whose loader threw, and stale hits refused by a full pool.
+    std::uint64_t failed = 0;
+    std::uint64_t rejected = 0;
+};
+
 // Thread-safe sharded LRU cache.
 // Locking strategy:
 // - Each shard owns an independent mutex.
 // - Public methods lock only the shard(s) they touch.
 // - No global mutex is used, reducing contention across disjoint key sets.
-template <typename Key, typename Value>
+// - Shards are laid out contiguously, each padded to its own cache line(s) so
+//   neighbouring shard mutexes never false-share.
+// Policy selects the per-shard eviction strategy (LRU, 2Q, ARC, S3-FIFO,
+// W-TinyLFU admission, CLOCK, buffered). With a ConcurrentAccessPolicy such as
+// ClockPolicy or BufferedPolicy, shards use a shared_mutex and Get takes only
+// a shared lock; buffered hits are replayed by whichever reader wins try_lock.
+// Weigher turns the per-shard limit into a weight (e.g. byte) budget; the
+// default UnitWeigher counts entries. Selector maps key hashes to shards.
+// The shard array is reached through an atomic pointer so Reshard can swap in
+// a new one and migrate entries into it while the cache stays in use.
+// Each shard counts its hits, misses, puts, evictions and lock waits in
+// relaxed atomics (see CacheMetrics.h for the compile-time switch).
+template <typename Key, typename Value, EvictionPolicy<Key> Policy = LruPolicy<Key>,
+          EntryWeigher<Key, Value> Weigher = UnitWeigher, ShardSelector Selector = MixedShardSelector>
 class ShardedLRUCache final {
 public:
-    explicit ShardedLRUCache(std::size_t capacity_per_shard, std::size_t shard_count);
+    // `default_ttl` applies to every insert without an explicit TTL; zero means
+    // entries never expire. Each shard tracks deadlines in its own timing wheel.
+    explicit ShardedLRUCache(std::size_t capacity_per_shard, std::size_t shard_count,
+                             std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
+    // Weighted cache: each shard holds at most `capacity_per_shard` entries
+    // whose weights sum to at most `max_weight_per_shard`, so the whole cache
+    // stays within shard_count * max_weight_per_shard.
+    ShardedLRUCache(std::size_t capacity_per_shard, std::size_t shard_count, std::size_t max_weight_per_shard,
+                    Weigher weigher = {},
+                    std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
+    // Adaptive cache: at most `capacity.total` entries overall. Every shard
+    // starts with an equal quota; quotas are then lent from shards with few
+    // misses to shards with many, between a quarter and four times the equal
+    // share. Size() never exceeds the total.
+    ShardedLRUCache(SharedCapacity capacity, std::size_t shard_count,
+                    std::chrono::milliseconds default_ttl = std::chrono::milliseconds::zero());
     ~ShardedLRUCache() = default;
 
     ShardedLRUCache(const ShardedLRUCache&) = delete;
@@ -27,27 +113,557 @@ public:
     ShardedLRUCache(ShardedLRUCache&&) = delete;
     ShardedLRUCache& operator=(ShardedLRUCache&&) = delete;
 
-    [[nodiscard]] std::optional<Value> Get(const Key& key);
+    // Lookups take Key or, for std::string keys, std::string_view/const char*;
+    // shard selection and the index probe both hash the view directly.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] std::optional<Value> Get(const K& key);
+    // Runs `visitor(const Value&)` on the cached value in place while the
+    // shard lock is held (shared for concurrent-access policies) and returns
+    // false on a miss. The visitor must not call back into the cache.
+    template <typename K = Key, typename Visitor>
+        requires LookupKey<K, Key> && std::invocable<Visitor&, const Value&>
+    bool GetWith(const K& key, Visitor&& visitor);
+    // Serves repeat Get/GetWith calls from a small per-thread table of value
+    // copies (2-way, 256 entries per thread and cache type). A copy is used
+    // only while its shard's version is unchanged; every write to the shard
+    // (including evictions and Clear) bumps that version, so a front-cache
+    // hit is never stale. Each copy goes back to the shard every 64 hits to
+    // refresh the policy's view of the key. Nothing is copied from a shard
+    // that holds entries with a TTL, nor for non-copyable values. Off by
+    // default; may be toggled at any time.
+    void EnableFrontCache(bool enabled = true) noexcept;
+    // Presence check that does not count as a hit for the eviction policy.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    [[nodiscard]] bool Contains(const K& key) const;
+    // Gives the cache a log-structured second tier on local disk (see
+    // DiskTier.h). From then on entries evicted for capacity or weight are
+    // buffered per shard and appended kSpillBatch at a time; expired victims
+    // are dropped (or reported to the removal listener). A lookup that
+    // misses memory checks its shard's buffer and the disk, and a hit there
+    // moves the entry back into the shard with the TTL it had left; the
+    // lookup still counts as a miss in Stats(). Writes and Clear remove
+    // older copies from both places, so the disk never serves a stale value.
+    // Contains sees memory only. Garbage collection runs on the writing
+    // thread that flushed a batch, outside the shard lock. A failed disk
+    // write drops its batch. Throws std::logic_error if a tier is already
+    // enabled, and what DiskTier::Create throws.
+    template <typename KeyCodec = SnapshotCodec<Key>, typename ValueCodec = SnapshotCodec<Value>>
+        requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+    void EnableDiskTier(DiskTierOptions options);
+    // All zero while no disk tier is enabled.
+    [[nodiscard]] DiskTierStats DiskStats() const;
     void Put(const Key& key, const Value& value);
+    void Put(Key&& key, Value&& value);
+    // As Put, but the entry expires `ttl` from now (zero: never). Expired
+    // entries read as misses and are reclaimed by the shard's next insert.
+    void Put(const Key& key, const Value& value, std::chrono::milliseconds ttl);
+    void Put(Key&& key, Value&& value, std::chrono::milliseconds ttl);
+    // Inserts or replaces the entry for `key`, constructing the value in place
+    // from `args` under the shard lock.
+    template <typename K, typename... Args>
+        requires LookupKey<std::remove_cvref_t<K>, Key> && std::constructible_from<Key, K&&> &&
+                 std::constructible_from<Value, Args&&...>
+    void Emplace(K&& key, Args&&... args);
+    // Returns the cached value, or fills a miss with `loader(key)`. Loads are
+    // single-flight: one caller per key runs the loader, with no shard lock
+    // held, while concurrent callers for that key wait for its result. If
+    // the loader throws, every waiter gets the same exception, nothing is
+    // cached, and the next call retries. The loader must not request the key
+    // it is loading. Calls that straddle a Reshard may each run the loader.
+    template <typename Loader>
+        requires std::invocable<Loader&, const Key&> &&
+                 std::convertible_to<std::invoke_result_t<Loader&, const Key&>, Value>
+    [[nodiscard]] Value GetOrLoad(const Key& key, Loader&& loader);
+    // Coroutine form of GetOrLoad for callers running on an executor. A hit
+    // completes without suspending. Where GetOrLoad would wait for a shard
+    // lock, GetAsync suspends and is posted back to `executor` to try again,
+    // so the thread moves on to other coroutines. On a miss, one caller per
+    // key awaits `loader(key)` and stores the result; other GetAsync callers
+    // for that key suspend until it is done, then are posted to their own
+    // executors with the value or the loader's exception. Nothing is cached
+    // on failure, and the next call retries. GetAsync and GetOrLoad loads of
+    // one key are not merged. Still blocking: disk-tier reads, refresh-ahead
+    // scheduling and writes during a Reshard. The coroutine must run to
+    // completion before the cache is destroyed.
+    template <typename Loader>
+        requires std::invocable<Loader&, const Key&> &&
+                 std::same_as<std::invoke_result_t<Loader&, const Key&>, Task<Value>>
+    [[nodiscard]] Task<Value> GetAsync(Executor& executor, Key key, Loader loader);
+    // Refresh-ahead: a hit on an entry written at least
+    // options.refresh_after ago still returns the cached value at once, and
+    // schedules one `loader(key)` call on a pool of options.threads threads.
+    // The result replaces the entry, with the default TTL, only if the entry
+    // is still the one that was read; if it was evicted, erased or
+    // overwritten meanwhile, the result is dropped. One reload per key is in
+    // flight at a time. A loader that throws leaves the entry as it is, and
+    // the next stale hit retries. Entries written before this call count as
+    // stale. Front-cache hits are checked only when their copy goes back to
+    // the shard. Throws std::invalid_argument for a non-positive
+    // refresh_after, zero threads or max_pending, or an empty loader, and
+    // std::logic_error if refresh-ahead is already enabled.
+    void EnableRefreshAhead(RefreshOptions options, std::function<Value(const Key&)> loader);
+    // All zero while refresh-ahead is off.
+    [[nodiscard]] RefreshAheadStats RefreshStats() const;
+    // Removes `key` from memory, and from the disk tier if there is one.
+    // Returns false if it was not in memory.
+    template <typename K = Key>
+        requires LookupKey<K, Key>
+    bool Erase(const K& key);
+    // Batched lookups: results come back in input order, but keys are hashed
+    // up front and grouped so each shard is locked once per batch.
+    [[nodiscard]] std::vector<std::optional<Value>> MultiGet(std::span<const Key> keys);
+    // Batched inserts with the same grouping; when a key repeats, the later
+    // entry wins, as with consecutive Put calls.
+    void MultiPut(std::span<const std::pair<Key, Value>> entries);
+    // While a Reshard is migrating, an entry that moves during the count may
+    // be counted twice. In adaptive mode the count is capped at the total.
     [[nodiscard]] std::size_t Size() const;
+    // Summed entry weight across all shards; equals Size() for UnitWeigher.
+    [[nodiscard]] std::size_t WeightedSize() const;
     void Clear();
+    // Reports every entry that leaves memory, and every value a write
+    // replaces, to `listener` with its RemovalCause (see RemovalListener.h).
+    // Events are recorded inside the shard's critical section and handed
+    // over once the call's shard locks are released:
+    // - kAsync: queued lock-free and delivered in batches on a background
+    //   thread; FlushRemovals waits until they have been.
+    // - kSync: the listener runs on the calling thread before the call that
+    //   caused the removals returns (write-through). It may call back into
+    //   the cache, except Resize and Reshard.
+    // With a disk tier, capacity evictions spill to disk instead of being
+    // reported. Entries Reshard moves are not reported. Throws
+    // std::logic_error if a listener is already set.
+    void SetRemovalListener(RemovalListener<Key, Value> listener,
+                            RemovalDelivery delivery = RemovalDelivery::kAsync);
+    // Waits until every removal made so far has reached an async listener.
+    void FlushRemovals();
+    // Changes every shard's entry limit. Shrinking evicts at most
+    // kMigrationBatch entries per shard lock hold. Shard policies keep the
+    // sizing they were built with (see LRUCache::SetCapacity). Throws
+    // std::logic_error for a SharedCapacity cache, whose quotas rebalance
+    // on their own.
+    void Resize(std::size_t capacity_per_shard);
+    // Moves the cache onto `shard_count` shards while it stays in use. The
+    // new shards are published first; the old ones are then drained into them
+    // kMigrationBatch entries per lock hold, so no caller waits on more than
+    // one batch. Meanwhile lookups probe the old shard and then the new one,
+    // and writes drop the key from the old shard before storing it in the
+    // new, so no entry is lost or read stale. Entries keep their remaining
+    // TTL. Resize and Reshard calls are serialized. In adaptive mode the
+    // total is re-split over the new shards (it may be exceeded while the
+    // migration runs) and quotas restart equal. Once the migration ends, the
+    // old shard array is freed as soon as no reader can still reach it;
+    // one that a load or refresh still uses waits for a later Reshard.
+    void Reshard(std::size_t shard_count);
+    // Times one Get/GetWith and one Put/Emplace in every `one_in` per thread
+    // into the latency histograms that Stats() reports; zero, the default,
+    // stops sampling. Batched calls are not timed.
+    void EnableLatencySampling(std::uint32_t one_in) noexcept;
+    // Reads the current shards' counters and the latency histograms with
+    // relaxed loads, taking no lock. Contains is not counted as a lookup.
+    // Front-cache hits reach their shard's counter in batches, when a copy
+    // is refreshed or found stale. Counters live in the shards, so shards
+    // created by Reshard start from zero.
+    [[nodiscard]] CacheStats Stats() const;
+    // Writes every live entry to `path` in the format described in
+    // Snapshot.h: one section per shard, entries coldest first (index order
+    // for policies that are not an OrderedPolicy), each with the TTL it has
+    // left. A shard is locked, under the lock a Get takes, only while its
+    // entries are copied out; they are encoded after the unlock (under it,
+    // for non-copyable values). Writes that race the save may or may not be
+    // included. The file is replaced atomically. Returns the number of
+    // entries written.
+    template <typename KeyCodec = SnapshotCodec<Key>, typename ValueCodec = SnapshotCodec<Value>>
+        requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+    std::size_t SaveSnapshot(const std::string& path);
+    // SaveSnapshot on a background thread. The cache must outlive the future.
+    template <typename KeyCodec = SnapshotCodec<Key>, typename ValueCodec = SnapshotCodec<Value>>
+        requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+    [[nodiscard]] std::future<std::size_t> SaveSnapshotAsync(std::string path);
+    // Puts every entry of a snapshot written with the same codecs. The file
+    // is mapped read-only and its sections are decoded by up to `threads`
+    // threads at once (zero: one per hardware thread); within a section
+    // entries go in file order, which restores recency. TTLs count from the
+    // load, not the save. Throws std::runtime_error (std::system_error for
+    // OS errors) for a missing, corrupt or incompatible file; entries put
+    // before the error stay. Returns the number of entries put.
+    template <typename KeyCodec = SnapshotCodec<Key>, typename ValueCodec = SnapshotCodec<Value>>
+        requires SnapshotCodecFor<KeyCodec, Key> && SnapshotCodecFor<ValueCodec, Value>
+    std::size_t LoadSnapshot(const std::string& path, std::size_t threads = 0);
 
 private:
-    struct Shard {
-        explicit Shard(std::size_t capacity) : cache(capacity) {}
+    static constexpr bool kSharedReads = ConcurrentAccessPolicy<Policy, Key>;
+    static constexpr bool kBufferedReads = BufferedAccessPolicy<Policy, Key>;
+    // Adaptive mode: misses per shard between rebalances, and how far a quota
+    // may move from the equal share (up to this factor, down to its inverse).
+    static constexpr std::uint64_t kRebalanceInterval = 512;
+    static constexpr std::size_t kQuotaFactor = 4;
+    // Front-cache hits served from one copy before it is refreshed.
+    static constexpr std::uint32_t kFrontRefreshInterval = 64;
+    // Entries Resize evicts, or Reshard moves, per shard lock hold.
+    static constexpr std::size_t kMigrationBatch = 64;
+    // Evicted entries a shard buffers before appending them to the disk tier.
+    static constexpr std::size_t kSpillBatch = 32;
+    // Lookups that can use the front cache: it stores copies of the value
+    // and of the key the caller looked up.
+    template <typename K>
+    static constexpr bool kFrontCacheable =
+        std::copy_constructible<Value> && std::constructible_from<Key, const K&>;
+
+    using ShardMutex = std::conditional_t<kSharedReads, std::shared_mutex, std::mutex>;
+
+    // std::hardware_destructive_interference_size is 64 on mainstream targets,
+    // but GCC warns (-Winterference-size) when it is used in a header because
+    // it follows -mtune. Pin it so the shard layout is stable across builds.
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    using ShardCache = LRUCache<Key, Value, Policy, Weigher>;
+    using SpillTier = DiskTier<Key, Value>;
+
+    // One GetAsync load and the coroutines waiting for it.
+    struct AsyncLoad {
+        // Held only to add a waiter or to publish the result.
+        std::mutex mutex;
+        bool done = false;
+        std::optional<Value> value;
+        std::exception_ptr error;
+        std::vector<std::pair<std::coroutine_handle<>, Executor*>> waiters;
+    };
+
+    // Suspends the caller until `load` is done, then yields its value or
+    // rethrows its exception.
+    class AwaitLoad {
+    public:
+        AwaitLoad(std::shared_ptr<AsyncLoad> load, Executor& executor) noexcept
+            : load_(std::move(load)), executor_(executor) {}
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        // Returns false, resuming the caller at once, if the load is done.
+        bool await_suspend(std::coroutine_handle<> handle) const;
+        Value await_resume() const;
+
+    private:
+        std::shared_ptr<AsyncLoad> load_;
+        Executor& executor_;
+    };
+
+    struct alignas(kCacheLineSize) Shard {
+        Shard(std::size_t capacity, std::size_t max_weight, const Weigher& weigher,
+              std::chrono::milliseconds default_ttl)
+            : cache(capacity, max_weight, weigher, default_ttl) {}
 
-        LRUCache<Key, Value> cache;
-        mutable std::mutex mutex;
+        ShardCache cache;
+        // Loads in progress, keyed like the cache; guarded by `mutex`.
+        std::unordered_map<Key, std::shared_future<Value>, KeyHash<Key>, std::equal_to<>> loading;
+        // GetAsync loads in progress; guarded by `mutex`.
+        std::unordered_map<Key, std::shared_ptr<AsyncLoad>, KeyHash<Key>, std::equal_to<>> async_loading;
+        // Keys with a refresh-ahead reload in flight, and whether the shard
+        // still takes reloads (cleared once it is drained). Guarded by
+        // refresh_mutex, so a stale hit never needs `mutex` exclusively.
+        std::unordered_set<Key, KeyHash<Key>, std::equal_to<>> refreshing;
+        bool takes_refreshes = true;
+        std::mutex refresh_mutex;
+        // Evictions not yet appended to the disk tier; guarded by `mutex`.
+        std::vector<typename SpillTier::Record> spilled;
+        // While `appending`, the batch being appended with no lock held. It
+        // stays searchable but unchanged; writes and promotions list its
+        // hashes in `unflushed` instead, and the appended copies of those are
+        // erased once the append returns. Guarded by `mutex`.
+        std::vector<typename SpillTier::Record> flushing;
+        std::vector<std::uint64_t> unflushed;
+        bool appending = false;
+        // Misses since the last rebalance; counted only in adaptive mode.
+        std::atomic<std::uint64_t> misses{0};
+        // Adaptive mode only: the quota Rebalance last set, the quota applied
+        // to `cache` (written under `mutex`), and the layout's spare pool.
+        std::atomic<std::size_t> target_quota{0};
+        std::atomic<std::size_t> quota{0};
+        std::atomic<std::size_t>* spare_quota = nullptr;
+        mutable ShardMutex mutex;
+        // Set under `mutex` once Reshard has drained the shard; callers that
+        // find it set retry against the current layout.
+        bool retired = false;
+        // Registered loads and queued refreshes, which use the shard past
+        // the pin they found it under. Reshard keeps the layout while this is
+        // non-zero; the release decrement is a user's last access.
+        std::atomic<std::uint32_t> users{0};
+        // Bumped after every write under the exclusive lock. Front-cache hits
+        // read it without locking, so it sits on its own cache line, away
+        // from the mutex that every locked operation writes.
+        alignas(kCacheLineSize) std::atomic<std::uint64_t> version{0};
+        // Updated by readers under a shared lock and by Contains, hence
+        // mutable; padded onto its own cache line(s).
+        [[no_unique_address]] mutable ShardMetrics metrics;
     };
 
-    [[nodiscard]] std::size_t ShardIndexForKey(const Key& key) const noexcept;
+    struct ShardArrayDeleter {
+        std::size_t count;
 
+        void operator()(Shard* shards) const noexcept;
+    };
+
+    using ShardArray = std::unique_ptr<Shard[], ShardArrayDeleter>;
+
+    // One generation of shards. Reshard publishes a new layout and drains the
+    // previous one into it.
+    struct Layout {
+        Layout(ShardArray shard_array, std::size_t count)
+            : shards(std::move(shard_array)), shard_count(count) {}
+
+        ShardArray shards;
+        std::size_t shard_count;
+        // Tags this layout's front-cache copies, whose versions only mean
+        // something against this layout's shards.
+        std::uint64_t front_owner = NextFrontCacheOwner();
+        // Adaptive mode only. `spare_quota` is capacity that shrunk shards
+        // have given up and growing shards have not taken yet; it and the
+        // applied quotas sum to the total.
+        std::size_t min_quota = 0;
+        std::size_t max_quota = 0;
+        std::atomic<std::size_t> spare_quota{0};
+        // The layout being drained into this one; null outside a migration.
+        std::atomic<Layout*> previous{nullptr};
+    };
+
+    // Times the enclosing call into one of latency_'s histograms when the
+    // calling thread's sampling countdown runs out.
+    class ScopedLatency {
+    public:
+        ScopedLatency(ShardedLRUCache& cache, LatencyHistogram LatencyMetrics::*histogram) noexcept;
+        ~ScopedLatency();
+
+        ScopedLatency(const ScopedLatency&) = delete;
+        ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+    private:
+        LatencyHistogram* histogram_ = nullptr;
+        std::chrono::steady_clock::time_point start_{};
+    };
+
+    using Dispatcher = RemovalDispatcher<Key, Value>;
+    using Stamp = typename ShardCache::Stamp;
+
+    struct Refresher {
+        Refresher(const RefreshOptions& refresh_options, std::function<Value(const Key&)> load)
+            : options(refresh_options),
+              loader(std::move(load)),
+              pool(refresh_options.threads, refresh_options.max_pending) {}
+
+        RefreshOptions options;
+        std::function<Value(const Key&)> loader;
+        std::atomic<std::uint64_t> scheduled{0};
+        std::atomic<std::uint64_t> replaced{0};
+        std::atomic<std::uint64_t> discarded{0};
+        std::atomic<std::uint64_t> failed{0};
+        std::atomic<std::uint64_t> rejected{0};
+        // Last, so its threads stop before the rest goes.
+        WorkerPool pool;
+    };
+
+    // Removals one thread made under this cache's shard locks.
+    struct RemovalFrame {
+        const ShardedLRUCache* cache = nullptr;
+        Dispatcher* dispatcher = nullptr;
+        // The frame of another cache whose lock this thread also holds.
+        RemovalFrame* outer = nullptr;
+        // kSync: events to deliver; kAsync: whether any were queued.
+        std::vector<RemovalEvent<Key, Value>> events;
+        bool enqueued = false;
+    };
+
+    // Declared before a shard lock and armed once it is held; delivers the
+    // removals recorded meanwhile after the lock is released. A scope armed
+    // inside another on the same thread (a migration holds two shard locks)
+    // leaves delivery to the outer one.
+    class RemovalScope {
+    public:
+        explicit RemovalScope(const ShardedLRUCache& cache) noexcept : cache_(cache) {}
+        ~RemovalScope();
+
+        RemovalScope(const RemovalScope&) = delete;
+        RemovalScope& operator=(const RemovalScope&) = delete;
+
+        // Requires the shard lock, under which SetRemovalListener installs
+        // the handler, so handler and listener are seen together.
+        void Arm() noexcept;
+
+    private:
+        const ShardedLRUCache& cache_;
+        bool owner_ = false;
+        RemovalFrame frame_;
+    };
+
+    // Outcome of probing one shard. kBusy only comes from probes that do not
+    // wait for the shard lock.
+    enum class Probe { kHit, kMiss, kRetired, kBusy };
+
+    // Batch position tagged with the shard its key maps to.
+    struct ShardSlot {
+        std::size_t shard;
+        std::size_t position;
+    };
+
+    [[nodiscard]] static ShardArray MakeShards(std::size_t count, std::size_t capacity,
+                                               std::size_t max_weight, const Weigher& weigher,
+                                               std::chrono::milliseconds default_ttl);
+    // Builds `count` shards sized for the current capacity settings.
+    [[nodiscard]] std::unique_ptr<Layout> MakeLayout(std::size_t count) const;
+    // Splits total_capacity_ equally over an unpublished layout's shards.
+    void AssignEqualQuotas(Layout& layout) const;
+    [[nodiscard]] Layout& CurrentLayout() const noexcept;
+    // Drains what is left of `layout.previous` into `layout`, then ends the
+    // migration. Requires resize_mutex_.
+    void FinishMigration(Layout& layout);
+    // Moves every entry of `old_shard` into `layout` and retires the shard.
+    void MigrateShard(Shard& old_shard, Layout& layout);
+    // Hands every layout but the current one whose shards have no users to
+    // reclaimer_. Requires resize_mutex_ and no migration.
+    void RetireDrainedLayouts();
+    // Locks the deferred `lock` on `shard`; a lock that try_lock could not
+    // take is counted as contended, with the time spent waiting for it.
+    // Without kWait, a contended lock is given up instead: returns false.
+    template <bool kWait = true, typename Lock>
+    static bool AcquireShardLock(const Shard& shard, Lock& lock);
+    static void Count(const Shard& shard, std::atomic<std::uint64_t> ShardCounters::*counter,
+                      std::uint64_t amount = 1U) noexcept;
+    // Runs `read(cache)` under the lock Get uses for this policy (exclusive,
+    // or shared for concurrent-access policies), then replays buffered hits
+    // if enough are pending. Without kWait, returns false without running
+    // `read` if the lock is contended.
+    template <bool kWait = true, typename Read>
+    bool ReadShard(Shard& shard, Read&& read);
+    // Runs `write(cache)` under the shard's exclusive lock, then publishes
+    // the shard's eviction count and bumps its version (the latter even if
+    // `write` throws). kWait as for ReadShard.
+    template <bool kWait = true, typename Write>
+    bool WriteShard(Shard& shard, Write&& write);
+    // Whether `shard`'s spill buffer should be appended to the disk tier now.
+    // Requires the shard's lock.
+    [[nodiscard]] static bool DueForSpill(const Shard& shard) noexcept;
+    // Appends `shard.flushing` to `tier` with no lock held, then erases the
+    // copies written or promoted meanwhile. Repeats while another batch is
+    // due. Called by the writer that set `shard.appending`.
+    void FlushSpilled(Shard& shard, SpillTier& tier);
+    // Runs `write(cache)` on the shard `key` maps to in the current layout,
+    // removing any copy left in the previous layout first. kWait as for
+    // ReadShard, except that a migration always waits for the locks.
+    template <bool kWait = true, typename K, typename Write>
+    bool WriteKey(const K& key, Write&& write);
+    // Routes `shard`'s evictions into its spill buffer when there is a disk
+    // tier, and its other removals to the current RemovalFrame. Requires the
+    // shard's exclusive lock, or an unpublished shard.
+    void InstallRemovalHandler(Shard& shard) const;
+    [[nodiscard]] static RemovalFrame*& CurrentRemovalFrame() noexcept;
+    // Drops `key` from `shard`'s spill buffer and from the disk tier before
+    // a write. Requires the shard's exclusive lock.
+    template <typename K>
+    void ForgetSpilled(Shard& shard, SpillTier& tier, const K& key, std::uint64_t hash);
+    // The buffered record for `key`, in `spilled` or (if copyable and not
+    // yet forgotten) in `flushing`, or null. Requires the shard's lock.
+    template <typename K>
+    [[nodiscard]] static const typename SpillTier::Record* FindSpilled(const Shard& shard, const K& key,
+                                                                     std::uint64_t hash);
+    // After a memory miss in `shard`, moves `key` back from the spill buffer
+    // or the disk tier and visits it there. Returns false on a miss.
+    template <typename K, typename Visitor>
+    bool PromoteFromDisk(Shard& shard, const K& key, std::uint64_t hash, Visitor& visitor);
+    // Whether refresh-ahead is on and an entry with this write stamp is due
+    // for a reload.
+    [[nodiscard]] bool DueForRefresh(Stamp written) const noexcept;
+    // steady_clock time read from the kernel's coarse monotonic clock: a few
+    // ns instead of tens, but behind by up to one scheduler tick.
+    [[nodiscard]] static Stamp CoarseNow() noexcept;
+    // Queues a reload of `key` unless one is in flight. Takes the shard's
+    // refresh_mutex, never its `mutex`.
+    template <typename K>
+    void ScheduleRefresh(Shard& shard, const K& key, Stamp stamp);
+    // Runs on the refresh pool.
+    void Refresh(Shard& shard, const Key& key, Stamp stamp);
+    // Publishes the outcome of `load` and posts its waiters.
+    static void FinishAsyncLoad(AsyncLoad& load, const std::optional<Value>& value, std::exception_ptr error);
+    // GetWith without the latency sample. Without kWait, skips the front
+    // cache and returns kBusy where it would wait for a shard lock.
+    template <bool kWait, typename K, typename Visitor>
+    Probe Lookup(const K& key, Visitor& visitor);
+    template <bool kWait = true, typename K, typename Visitor>
+    Probe ProbeShard(Shard& shard, const K& key, Visitor& visitor);
+    template <typename K>
+    [[nodiscard]] static Probe ProbeContains(const Shard& shard, const K& key);
+    // ProbeShard through the calling thread's front cache.
+    template <typename K, typename Visitor>
+    Probe GetWithFront(const Layout& layout, Shard& shard, std::uint64_t hash, const K& key,
+                       Visitor& visitor);
+    [[nodiscard]] static FrontCache<Key, Value>& LocalFrontCache();
+    // Looks `key` up in a shard cache whose ReadShard lock is held.
+    template <typename K, typename Visitor>
+    static bool VisitLocked(ShardCache& cache, const K& key, Visitor&& visitor, Stamp* written = nullptr);
+    // Batch positions sorted by shard, then by position, so a batch visits
+    // each shard once and keeps input order within a shard.
+    template <typename KeyAt>
+    [[nodiscard]] std::vector<ShardSlot> GroupByShard(const Layout& layout, std::size_t count,
+                                                      KeyAt key_at) const;
+    // Sums `measure(cache)` over every shard, previous layout first.
+    template <typename Measure>
+    [[nodiscard]] std::size_t SumShards(Measure measure) const;
+    template <typename K>
+    [[nodiscard]] std::uint64_t HashOf(const K& key) const;
+    [[nodiscard]] static std::size_t ShardIndexForHash(const Layout& layout, std::uint64_t hash) noexcept;
+    // Largest quota an adaptive shard may reach; also its policy sizing.
+    [[nodiscard]] static std::size_t MaxQuota(SharedCapacity capacity, std::size_t shard_count);
+    // Adds to a shard's miss count and, every kRebalanceInterval misses,
+    // rebalances unless another thread already is, then applies the new
+    // shrinks to shards whose lock is free. Never waits for a lock. No shard
+    // lock may be held.
+    void RecordMisses(Shard& shard, std::uint64_t count);
+    // Moves every target quota halfway towards a share of the lendable
+    // capacity proportional to its misses. Touches no shard lock; shards
+    // apply their targets in ApplyQuota. Skipped while a Reshard migrates.
+    // Requires rebalance_mutex_.
+    void Rebalance();
+    // Brings an adaptive shard's capacity to its target quota. A shrink
+    // evicts and returns the capacity to the spare pool; a grow takes only
+    // what the pool holds, so the applied quotas never sum above the total.
+    // Requires the shard's exclusive lock.
+    static void ApplyQuota(Shard& shard);
+
+    // Settings for shards built later; written under resize_mutex_.
     std::size_t capacity_per_shard_;
-    std::size_t shard_count_;
-    std::hash<Key> hasher_;
-    std::vector<std::unique_ptr<Shard>> shards_;
+    std::size_t max_weight_per_shard_;
+    Weigher weigher_;
+    std::chrono::milliseconds default_ttl_;
+    KeyHash<Key> hasher_;
+    bool adaptive_ = false;
+    std::size_t total_capacity_ = 0;
+    // The current layout and drained ones not yet retired, oldest first;
+    // guarded by resize_mutex_. Calls that reach shards through layout_ pin
+    // reclaimer_, which frees the layouts Reshard retires.
+    std::vector<std::unique_ptr<Layout>> layouts_;
+    std::atomic<Layout*> layout_{nullptr};
+    mutable EpochReclaimer reclaimer_;
+    mutable std::mutex rebalance_mutex_;
+    std::mutex resize_mutex_;
+    std::atomic<bool> front_cache_enabled_{false};
+    // Set once by EnableDiskTier; disk_tier_ is what the hot paths load.
+    std::unique_ptr<SpillTier> disk_tier_owner_;
+    std::atomic<SpillTier*> disk_tier_{nullptr};
+    // Set once by SetRemovalListener, like the disk tier.
+    std::unique_ptr<Dispatcher> removals_owner_;
+    std::atomic<Dispatcher*> removals_{nullptr};
+    [[no_unique_address]] CacheLatencyMetrics latency_;
+    // Set once by EnableRefreshAhead. Declared last: its pool's threads
+    // write to the shards and report removals, so they are stopped first.
+    std::unique_ptr<Refresher> refresher_owner_;
+    std::atomic<Refresher*> refresher_{nullptr};
 };
 
+// Values held behind shared_ptr<const Value>: a hit copies only the handle
+// under the shard lock, and the value stays readable after eviction for as
+// long as the caller holds it.
+template <typename Key, typename Value, EvictionPolicy<Key> Policy = LruPolicy<Key>>
+using SharedValueShardedLRUCache = ShardedLRUCache<Key, std::shared_ptr<const Value>, Policy>;
+
 #include "ShardedLRUCache.cpp"
 
 #endif  // SHARDED_LRU_CACHE_SHARDEDLRUCACHE_H
@@ -0,0 +1,493 @@
+#ifndef SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_CPP
+#define SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_CPP
+
+#include "SharedMemoryLRUCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shared_memory_detail {
+
+// How long an attaching process waits for the creator to format the region.
+inline constexpr std::chrono::seconds kAttachTimeout{5};
+
+[[nodiscard]] constexpr std::size_t RoundUpToLine(const std::size_t bytes) noexcept {
+    return (bytes + 63U) / 64U * 64U;
+}
+
+}  // namespace shared_memory_detail
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+SharedMemoryLRUCache<Key, Value>::SharedMemoryLRUCache(const std::string& name,
+                                                       const std::size_t capacity_per_shard,
+                                                       const std::size_t shard_count)
+    : shard_count_(shard_count), capacity_(capacity_per_shard) {
+    using shared_memory_detail::RoundUpToLine;
+    if (capacity_per_shard == 0U || capacity_per_shard >= kNil) {
+        throw std::invalid_argument("capacity_per_shard must be in [1, 2^32 - 1)");
+    }
+    if (shard_count == 0U || shard_count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("shard_count must be in [1, 2^32)");
+    }
+
+    const std::size_t bucket_count = std::bit_ceil(capacity_per_shard);
+    bucket_mask_ = bucket_count - 1U;
+    slots_offset_ = sizeof(ShardHeader) + RoundUpToLine(bucket_count * sizeof(std::uint32_t));
+    shard_bytes_ = slots_offset_ + RoundUpToLine(capacity_per_shard * sizeof(Slot));
+    region_bytes_ = kHeaderBytes + shard_count * shard_bytes_;
+
+    // O_EXCL elects exactly one creator; everyone else attaches.
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    const bool creator = fd >= 0;
+    if (!creator) {
+        if (errno != EEXIST) {
+            throw std::system_error(errno, std::generic_category(), "cannot create shared cache " + name);
+        }
+        fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open shared cache " + name);
+        }
+    }
+
+    const auto fail = [&](const int error, const std::string& what) {
+        ::close(fd);
+        if (creator) {
+            (void)::shm_unlink(name.c_str());
+        }
+        throw std::system_error(error, std::generic_category(), what + " " + name);
+    };
+    if (creator) {
+        if (::ftruncate(fd, static_cast<off_t>(region_bytes_)) != 0) {
+            fail(errno, "cannot size shared cache");
+        }
+    } else {
+        // The creator sizes the object right after creating it.
+        const auto deadline = std::chrono::steady_clock::now() + shared_memory_detail::kAttachTimeout;
+        struct stat status {};
+        while (::fstat(fd, &status) == 0 && status.st_size == 0 &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (status.st_size != static_cast<off_t>(region_bytes_)) {
+            ::close(fd);
+            throw std::runtime_error("shared cache " + name + " was created with other sizes or never sized");
+        }
+    }
+
+    void* const mapping = ::mmap(nullptr, region_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        fail(errno, "cannot map shared cache");
+    }
+    ::close(fd);
+    region_ = static_cast<std::byte*>(mapping);
+    header_ = reinterpret_cast<RegionHeader*>(region_);
+
+    try {
+        if (creator) {
+            Format();
+        } else {
+            AwaitReady(name);
+        }
+    } catch (...) {
+        ::munmap(region_, region_bytes_);
+        if (creator) {
+            (void)::shm_unlink(name.c_str());
+        }
+        throw;
+    }
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+SharedMemoryLRUCache<Key, Value>::~SharedMemoryLRUCache() {
+    ::munmap(region_, region_bytes_);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+bool SharedMemoryLRUCache<Key, Value>::Remove(const std::string& name) {
+    if (::shm_unlink(name.c_str()) == 0) {
+        return true;
+    }
+    if (errno == ENOENT) {
+        return false;
+    }
+    throw std::system_error(errno, std::generic_category(), "cannot remove shared cache " + name);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+std::optional<Value> SharedMemoryLRUCache<Key, Value>::Get(const Key& key) {
+    const std::uint64_t hash = HashOf(key);
+    ShardHeader& shard = ShardFor(hash);
+    const ShardLock lock(shard, *this);
+    const std::uint32_t index = Find(shard, key, hash);
+    if (index == kNil) {
+        ++shard.misses;
+        return std::nullopt;
+    }
+
+    BeginChange(shard);
+    Unlink(shard, index);
+    LinkNewest(shard, index);
+    EndChange(shard);
+    ++shard.hits;
+    return Slots(shard)[index].value;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+bool SharedMemoryLRUCache<Key, Value>::Contains(const Key& key) const {
+    const std::uint64_t hash = HashOf(key);
+    ShardHeader& shard = ShardFor(hash);
+    const ShardLock lock(shard, *this);
+    return Find(shard, key, hash) != kNil;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Put(const Key& key, const Value& value) {
+    const std::uint64_t hash = HashOf(key);
+    ShardHeader& shard = ShardFor(hash);
+    const ShardLock lock(shard, *this);
+    BeginChange(shard);
+    Store(shard, key, hash, value);
+    EndChange(shard);
+    ++shard.puts;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+template <typename Updater>
+    requires std::invocable<Updater&, const std::optional<Value>&> &&
+             std::convertible_to<std::invoke_result_t<Updater&, const std::optional<Value>&>, Value>
+Value SharedMemoryLRUCache<Key, Value>::Update(const Key& key, Updater&& update) {
+    const std::uint64_t hash = HashOf(key);
+    ShardHeader& shard = ShardFor(hash);
+    const ShardLock lock(shard, *this);
+    std::optional<Value> current;
+    if (const std::uint32_t index = Find(shard, key, hash); index != kNil) {
+        current = Slots(shard)[index].value;
+    }
+
+    // Runs before the shard is marked dirty: a process dying in `update`
+    // leaves the shard intact for the next locker.
+    const Value next = std::invoke(update, std::as_const(current));
+    BeginChange(shard);
+    Store(shard, key, hash, next);
+    EndChange(shard);
+    ++shard.puts;
+    return next;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+bool SharedMemoryLRUCache<Key, Value>::Erase(const Key& key) {
+    const std::uint64_t hash = HashOf(key);
+    ShardHeader& shard = ShardFor(hash);
+    const ShardLock lock(shard, *this);
+    const std::uint32_t index = Find(shard, key, hash);
+    if (index == kNil) {
+        return false;
+    }
+
+    BeginChange(shard);
+    RemoveFromChain(shard, index);
+    Unlink(shard, index);
+    Slots(shard)[index].chain = shard.free;
+    shard.free = index;
+    --shard.size;
+    EndChange(shard);
+    return true;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+std::size_t SharedMemoryLRUCache<Key, Value>::Size() const {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < shard_count_; ++i) {
+        ShardHeader& shard = ShardAt(i);
+        const ShardLock lock(shard, *this);
+        size += static_cast<std::size_t>(shard.size);
+    }
+    return size;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Clear() {
+    for (std::size_t i = 0; i < shard_count_; ++i) {
+        ShardHeader& shard = ShardAt(i);
+        const ShardLock lock(shard, *this);
+        BeginChange(shard);
+        ResetShard(shard);
+        EndChange(shard);
+    }
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+SharedCacheStats SharedMemoryLRUCache<Key, Value>::Stats() const {
+    SharedCacheStats stats;
+    for (std::size_t i = 0; i < shard_count_; ++i) {
+        ShardHeader& shard = ShardAt(i);
+        const ShardLock lock(shard, *this);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.puts += shard.puts;
+        stats.evictions += shard.evictions;
+        stats.recoveries += shard.recoveries;
+        stats.size += shard.size;
+    }
+    return stats;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+SharedMemoryLRUCache<Key, Value>::ShardLock::ShardLock(ShardHeader& shard, const SharedMemoryLRUCache& cache)
+    : shard_(shard) {
+    const int result = ::pthread_mutex_lock(&shard_.mutex);
+    if (result == EOWNERDEAD) {
+        // The previous owner died holding the lock. Links it was changing may
+        // be half-written, so such a shard starts over empty.
+        if (shard_.dirty.load(std::memory_order_relaxed) != 0U) {
+            cache.ResetShard(shard_);
+        }
+        ++shard_.recoveries;
+        (void)::pthread_mutex_consistent(&shard_.mutex);
+    } else if (result != 0) {
+        throw std::system_error(result, std::generic_category(), "cannot lock shared cache shard");
+    }
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+SharedMemoryLRUCache<Key, Value>::ShardLock::~ShardLock() {
+    (void)::pthread_mutex_unlock(&shard_.mutex);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+std::uint64_t SharedMemoryLRUCache<Key, Value>::HashOf(const Key& key) noexcept {
+    // std::hash may differ between the binaries sharing the region; the
+    // key's bytes do not.
+    const auto* const bytes = reinterpret_cast<const unsigned char*>(&key);
+    std::uint64_t hash = sizeof(Key);
+    for (std::size_t offset = 0; offset < sizeof(Key); offset += sizeof(std::uint64_t)) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, bytes + offset, std::min(sizeof(word), sizeof(Key) - offset));
+        hash = MixHash(hash ^ word);
+    }
+    return hash;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Describe(RegionHeader& header) const noexcept {
+    header.key_size = static_cast<std::uint32_t>(sizeof(Key));
+    header.value_size = static_cast<std::uint32_t>(sizeof(Value));
+    header.shard_count = static_cast<std::uint32_t>(shard_count_);
+    header.capacity_per_shard = capacity_;
+    header.bucket_count = bucket_mask_ + 1U;
+    header.shard_bytes = shard_bytes_;
+    header.region_bytes = region_bytes_;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Format() {
+    std::construct_at(header_);
+    Describe(*header_);
+
+    pthread_mutexattr_t attributes;
+    ::pthread_mutexattr_init(&attributes);
+    ::pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    for (std::size_t i = 0; i < shard_count_; ++i) {
+        ShardHeader* const shard = std::construct_at(reinterpret_cast<ShardHeader*>(region_ + kHeaderBytes +
+                                                                                    i * shard_bytes_));
+        if (const int result = ::pthread_mutex_init(&shard->mutex, &attributes); result != 0) {
+            ::pthread_mutexattr_destroy(&attributes);
+            throw std::system_error(result, std::generic_category(), "cannot initialize shared cache mutex");
+        }
+        Slot* const slots = Slots(*shard);
+        for (std::size_t slot = 0; slot < capacity_; ++slot) {
+            std::construct_at(slots + slot);
+        }
+        ResetShard(*shard);
+    }
+    ::pthread_mutexattr_destroy(&attributes);
+
+    // Publishes everything above to processes waiting in AwaitReady.
+    header_->state.store(kReady, std::memory_order_release);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::AwaitReady(const std::string& name) const {
+    const auto deadline = std::chrono::steady_clock::now() + shared_memory_detail::kAttachTimeout;
+    while (header_->state.load(std::memory_order_acquire) != kReady) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error("shared cache " + name + " was never formatted; Remove it and retry");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    RegionHeader expected;
+    Describe(expected);
+    const RegionHeader& actual = *header_;
+    if (actual.magic != RegionHeader::kMagic || actual.version != RegionHeader::kVersion) {
+        throw std::runtime_error("shared cache " + name + " has an unknown format");
+    }
+    if (actual.key_size != expected.key_size || actual.value_size != expected.value_size ||
+        actual.shard_count != expected.shard_count ||
+        actual.capacity_per_shard != expected.capacity_per_shard ||
+        actual.bucket_count != expected.bucket_count || actual.shard_bytes != expected.shard_bytes ||
+        actual.region_bytes != expected.region_bytes) {
+        throw std::runtime_error("shared cache " + name + " was created with other types or sizes");
+    }
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+typename SharedMemoryLRUCache<Key, Value>::ShardHeader& SharedMemoryLRUCache<Key, Value>::ShardAt(
+    const std::size_t index) const noexcept {
+    return *std::launder(reinterpret_cast<ShardHeader*>(region_ + kHeaderBytes + index * shard_bytes_));
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+typename SharedMemoryLRUCache<Key, Value>::ShardHeader& SharedMemoryLRUCache<Key, Value>::ShardFor(
+    const std::uint64_t hash) const noexcept {
+    // Shards take the high bits (multiply-shift), buckets the low ones.
+    return ShardAt(static_cast<std::size_t>(((hash >> 32U) * shard_count_) >> 32U));
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+std::uint32_t* SharedMemoryLRUCache<Key, Value>::Buckets(ShardHeader& shard) const noexcept {
+    return reinterpret_cast<std::uint32_t*>(reinterpret_cast<std::byte*>(&shard) + sizeof(ShardHeader));
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+typename SharedMemoryLRUCache<Key, Value>::Slot* SharedMemoryLRUCache<Key, Value>::Slots(
+    ShardHeader& shard) const noexcept {
+    return std::launder(reinterpret_cast<Slot*>(reinterpret_cast<std::byte*>(&shard) + slots_offset_));
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::ResetShard(ShardHeader& shard) const noexcept {
+    std::fill_n(Buckets(shard), bucket_mask_ + 1U, kNil);
+    Slot* const slots = Slots(shard);
+    for (std::size_t slot = 0; slot < capacity_; ++slot) {
+        slots[slot].chain = slot + 1U < capacity_ ? static_cast<std::uint32_t>(slot + 1U) : kNil;
+        slots[slot].newer = kNil;
+        slots[slot].older = kNil;
+    }
+    shard.free = 0;
+    shard.newest = kNil;
+    shard.oldest = kNil;
+    shard.size = 0;
+    shard.dirty.store(0U, std::memory_order_relaxed);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+std::uint32_t SharedMemoryLRUCache<Key, Value>::Find(ShardHeader& shard, const Key& key,
+                                                     const std::uint64_t hash) const noexcept {
+    const Slot* const slots = Slots(shard);
+    std::uint32_t index = Buckets(shard)[hash & bucket_mask_];
+    for (; index != kNil; index = slots[index].chain) {
+        if (slots[index].hash == hash && std::memcmp(&slots[index].key, &key, sizeof(Key)) == 0) {
+            return index;
+        }
+    }
+    return kNil;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Store(ShardHeader& shard, const Key& key, const std::uint64_t hash,
+                                             const Value& value) const noexcept {
+    Slot* const slots = Slots(shard);
+    if (const std::uint32_t index = Find(shard, key, hash); index != kNil) {
+        slots[index].value = value;
+        Unlink(shard, index);
+        LinkNewest(shard, index);
+        return;
+    }
+
+    if (shard.free == kNil) {
+        const std::uint32_t victim = shard.oldest;
+        RemoveFromChain(shard, victim);
+        Unlink(shard, victim);
+        slots[victim].chain = kNil;
+        shard.free = victim;
+        --shard.size;
+        ++shard.evictions;
+    }
+
+    const std::uint32_t index = shard.free;
+    Slot& slot = slots[index];
+    shard.free = slot.chain;
+    slot.hash = hash;
+    slot.key = key;
+    slot.value = value;
+    std::uint32_t& bucket = Buckets(shard)[hash & bucket_mask_];
+    slot.chain = bucket;
+    bucket = index;
+    LinkNewest(shard, index);
+    ++shard.size;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::Unlink(ShardHeader& shard, const std::uint32_t index) const noexcept {
+    Slot* const slots = Slots(shard);
+    Slot& slot = slots[index];
+    if (slot.newer != kNil) {
+        slots[slot.newer].older = slot.older;
+    } else {
+        shard.newest = slot.older;
+    }
+    if (slot.older != kNil) {
+        slots[slot.older].newer = slot.newer;
+    } else {
+        shard.oldest = slot.newer;
+    }
+    slot.newer = kNil;
+    slot.older = kNil;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::LinkNewest(ShardHeader& shard,
+                                                  const std::uint32_t index) const noexcept {
+    Slot* const slots = Slots(shard);
+    slots[index].older = shard.newest;
+    slots[index].newer = kNil;
+    if (shard.newest != kNil) {
+        slots[shard.newest].newer = index;
+    } else {
+        shard.oldest = index;
+    }
+    shard.newest = index;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::RemoveFromChain(ShardHeader& shard,
+                                                       const std::uint32_t index) const noexcept {
+    Slot* const slots = Slots(shard);
+    std::uint32_t* link = &Buckets(shard)[slots[index].hash & bucket_mask_];
+    while (*link != index) {
+        link = &slots[*link].chain;
+    }
+    *link = slots[index].chain;
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::BeginChange(ShardHeader& shard) noexcept {
+    // Only a dying process matters here, so a compiler fence is enough: the
+    // next owner sees its stores through the kernel's robust-list handoff.
+    shard.dirty.store(1U, std::memory_order_relaxed);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+void SharedMemoryLRUCache<Key, Value>::EndChange(ShardHeader& shard) noexcept {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    shard.dirty.store(0U, std::memory_order_relaxed);
+}
+
+#endif  // SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_CPP
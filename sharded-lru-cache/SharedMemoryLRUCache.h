@@ -0,0 +1,195 @@
+#ifndef SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_H
+#define SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_H
+
+#include "HashMix.h"
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include <pthread.h>
+
+// Keys are hashed and compared as their object bytes, so every bit must be
+// significant (no padding, no floating point).
+template <typename T>
+concept SharedMemoryKey = std::is_trivially_copyable_v<T> && std::default_initializable<T> &&
+                          std::has_unique_object_representations_v<T>;
+
+// Values are copied in and out of the region as bytes. Pointers qualify too
+// but are meaningless in another process.
+template <typename T>
+concept SharedMemoryValue = std::is_trivially_copyable_v<T> && std::default_initializable<T>;
+
+struct SharedCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t puts = 0;
+    std::uint64_t evictions = 0;
+    // Shard locks taken over from a process that died holding them.
+    std::uint64_t recoveries = 0;
+    std::uint64_t size = 0;
+};
+
+// Sharded LRU cache that lives in a POSIX shared-memory object, so several
+// processes on one host attach to the same entries and share their hits.
+// - The whole cache, shard headers, bucket heads and entry slots, is one
+//   fixed-size region. Links are 32-bit slot indices and shards sit at fixed
+//   offsets, so each process may map the region at a different address.
+// - Each shard has a process-shared, robust pthread mutex. If a process dies
+//   holding it, the next locker takes it over: a shard that was mid-update
+//   (its dirty flag is set around every change) is emptied, otherwise it is
+//   kept as is.
+// - The first process to open a name creates and formats the region; the
+//   others wait for it to be marked ready, then check that it was built for
+//   the same key/value sizes and geometry.
+// Thread-safe and process-safe. The object outlives every process until
+// Remove is called (or the host restarts).
+template <SharedMemoryKey Key, SharedMemoryValue Value>
+class SharedMemoryLRUCache final {
+public:
+    // Opens the shared-memory object `name` ("/" followed by a file name),
+    // creating it if it does not exist. Throws std::invalid_argument for bad
+    // sizes, std::system_error for OS errors and std::runtime_error if the
+    // existing region does not match or never became ready.
+    SharedMemoryLRUCache(const std::string& name, std::size_t capacity_per_shard, std::size_t shard_count);
+    // Unmaps the region; the entries stay for other processes.
+    ~SharedMemoryLRUCache();
+
+    SharedMemoryLRUCache(const SharedMemoryLRUCache&) = delete;
+    SharedMemoryLRUCache& operator=(const SharedMemoryLRUCache&) = delete;
+    SharedMemoryLRUCache(SharedMemoryLRUCache&&) = delete;
+    SharedMemoryLRUCache& operator=(SharedMemoryLRUCache&&) = delete;
+
+    // Deletes the shared-memory object. Processes that have it mapped keep
+    // using it; the next open creates a new one. Returns false if there was
+    // none.
+    static bool Remove(const std::string& name);
+
+    [[nodiscard]] std::optional<Value> Get(const Key& key);
+    // Presence check that does not count as a hit.
+    [[nodiscard]] bool Contains(const Key& key) const;
+    void Put(const Key& key, const Value& value);
+    // Stores `update(current)` under the shard lock, where `current` is the
+    // cached value or empty, and returns what was stored. This is how
+    // processes read-modify-write one entry without racing each other.
+    template <typename Updater>
+        requires std::invocable<Updater&, const std::optional<Value>&> &&
+                 std::convertible_to<std::invoke_result_t<Updater&, const std::optional<Value>&>, Value>
+    Value Update(const Key& key, Updater&& update);
+    bool Erase(const Key& key);
+    [[nodiscard]] std::size_t Size() const;
+    void Clear();
+    // Sums every shard's counters; they are shared by all processes.
+    [[nodiscard]] SharedCacheStats Stats() const;
+
+private:
+    static constexpr std::uint32_t kNil = 0xffffffffU;
+    static constexpr std::size_t kCacheLineSize = 64;
+    static constexpr std::uint32_t kReady = 0x52454459U;
+
+    struct RegionHeader {
+        static constexpr std::array<char, 8> kMagic{'S', 'L', 'R', 'U', 'S', 'H', 'M', 0};
+        static constexpr std::uint32_t kVersion = 1;
+
+        std::array<char, 8> magic = kMagic;
+        std::uint32_t version = kVersion;
+        std::uint32_t key_size = 0;
+        std::uint32_t value_size = 0;
+        std::uint32_t shard_count = 0;
+        std::uint64_t capacity_per_shard = 0;
+        std::uint64_t bucket_count = 0;
+        std::uint64_t shard_bytes = 0;
+        std::uint64_t region_bytes = 0;
+        // Set to kReady, last, by the creating process.
+        std::atomic<std::uint32_t> state{0};
+    };
+
+    struct alignas(kCacheLineSize) ShardHeader {
+        pthread_mutex_t mutex;
+        // Non-zero while the lock holder is changing the shard.
+        std::atomic<std::uint32_t> dirty{0};
+        // Most and least recently used slots, and the free list.
+        std::uint32_t newest = kNil;
+        std::uint32_t oldest = kNil;
+        std::uint32_t free = kNil;
+        std::uint64_t size = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t puts = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t recoveries = 0;
+    };
+
+    struct Slot {
+        std::uint64_t hash = 0;
+        // Next slot in the bucket chain, or in the free list.
+        std::uint32_t chain = kNil;
+        std::uint32_t newer = kNil;
+        std::uint32_t older = kNil;
+        Key key{};
+        Value value{};
+    };
+
+    static constexpr std::size_t kHeaderBytes =
+        (sizeof(RegionHeader) + kCacheLineSize - 1U) / kCacheLineSize * kCacheLineSize;
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+                  "shared-memory atomics must be lock-free to work across processes");
+    static_assert(alignof(Slot) <= kCacheLineSize);
+
+    // Holds a shard's mutex, taking it over from a dead owner if need be.
+    class ShardLock {
+    public:
+        explicit ShardLock(ShardHeader& shard, const SharedMemoryLRUCache& cache);
+        ~ShardLock();
+
+        ShardLock(const ShardLock&) = delete;
+        ShardLock& operator=(const ShardLock&) = delete;
+
+    private:
+        ShardHeader& shard_;
+    };
+
+    [[nodiscard]] static std::uint64_t HashOf(const Key& key) noexcept;
+    // Writes this cache's sizes and geometry into `header`.
+    void Describe(RegionHeader& header) const noexcept;
+    // Builds the header and every shard in a freshly created region.
+    void Format();
+    // Waits for the creator to finish formatting, then checks the geometry.
+    void AwaitReady(const std::string& name) const;
+    [[nodiscard]] ShardHeader& ShardAt(std::size_t index) const noexcept;
+    [[nodiscard]] ShardHeader& ShardFor(std::uint64_t hash) const noexcept;
+    [[nodiscard]] std::uint32_t* Buckets(ShardHeader& shard) const noexcept;
+    [[nodiscard]] Slot* Slots(ShardHeader& shard) const noexcept;
+    // Empties `shard`, threading every slot onto the free list.
+    void ResetShard(ShardHeader& shard) const noexcept;
+    // Slot holding `key`, or kNil. Requires the shard lock.
+    [[nodiscard]] std::uint32_t Find(ShardHeader& shard, const Key& key, std::uint64_t hash) const noexcept;
+    // Stores `value` under `key` as the newest entry, evicting the oldest if
+    // the shard is full. Requires the shard lock.
+    void Store(ShardHeader& shard, const Key& key, std::uint64_t hash, const Value& value) const noexcept;
+    void Unlink(ShardHeader& shard, std::uint32_t index) const noexcept;
+    void LinkNewest(ShardHeader& shard, std::uint32_t index) const noexcept;
+    void RemoveFromChain(ShardHeader& shard, std::uint32_t index) const noexcept;
+    static void BeginChange(ShardHeader& shard) noexcept;
+    static void EndChange(ShardHeader& shard) noexcept;
+
+    std::byte* region_ = nullptr;
+    std::size_t region_bytes_ = 0;
+    RegionHeader* header_ = nullptr;
+    std::size_t shard_count_ = 0;
+    std::size_t shard_bytes_ = 0;
+    std::size_t capacity_ = 0;
+    std::size_t bucket_mask_ = 0;
+    std::size_t slots_offset_ = 0;
+};
+
+#include "SharedMemoryLRUCache.cpp"
+
+#endif  // SHARDED_LRU_CACHE_SHAREDMEMORYLRUCACHE_H
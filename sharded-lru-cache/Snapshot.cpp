@@ -0,0 +1,206 @@
+#ifndef SHARDED_LRU_CACHE_SNAPSHOT_CPP
+#define SHARDED_LRU_CACHE_SNAPSHOT_CPP
+
+#include "Snapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+inline SnapshotReader::SnapshotReader(const std::span<const std::byte> bytes) noexcept : bytes_(bytes) {}
+
+inline void SnapshotReader::ReadBytes(void* const out, const std::size_t count) {
+    if (count > bytes_.size()) {
+        throw std::runtime_error("snapshot section is truncated");
+    }
+    std::memcpy(out, bytes_.data(), count);
+    bytes_ = bytes_.subspan(count);
+}
+
+inline std::string_view SnapshotReader::ReadView(const std::size_t count) {
+    if (count > bytes_.size()) {
+        throw std::runtime_error("snapshot section is truncated");
+    }
+    const std::string_view view(reinterpret_cast<const char*>(bytes_.data()), count);
+    bytes_ = bytes_.subspan(count);
+    return view;
+}
+
+inline bool SnapshotReader::AtEnd() const noexcept {
+    return bytes_.empty();
+}
+
+template <RawSnapshotType T>
+void SnapshotCodec<T>::Encode(const T& value, std::string& out) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <RawSnapshotType T>
+T SnapshotCodec<T>::Decode(SnapshotReader& in) {
+    T value;
+    in.ReadBytes(&value, sizeof(T));
+    return value;
+}
+
+inline void SnapshotCodec<std::string>::Encode(const std::string& value, std::string& out) {
+    SnapshotCodec<std::uint64_t>::Encode(value.size(), out);
+    out.append(value);
+}
+
+inline std::string SnapshotCodec<std::string>::Decode(SnapshotReader& in) {
+    const std::uint64_t size = SnapshotCodec<std::uint64_t>::Decode(in);
+    return std::string(in.ReadView(static_cast<std::size_t>(size)));
+}
+
+template <typename Key, typename Value, typename KeyCodec, typename ValueCodec>
+SnapshotHeader MakeSnapshotHeader() {
+    SnapshotHeader header;
+    if constexpr (kRawSnapshot<Key, Value, KeyCodec, ValueCodec>) {
+        header.flags = SnapshotHeader::kRawEntries;
+        header.key_size = static_cast<std::uint32_t>(sizeof(Key));
+        header.value_size = static_cast<std::uint32_t>(sizeof(Value));
+    }
+    return header;
+}
+
+inline void AppendSnapshotTtl(std::string& out, const std::int64_t ttl_ms) {
+    SnapshotCodec<std::int64_t>::Encode(ttl_ms, out);
+}
+
+inline std::int64_t ReadSnapshotTtl(SnapshotReader& in) {
+    return SnapshotCodec<std::int64_t>::Decode(in);
+}
+
+inline SnapshotWriter::SnapshotWriter(std::string path, const SnapshotHeader& header)
+    : path_(std::move(path)), temp_path_(path_ + ".tmp"), header_(header) {
+    out_.open(temp_path_, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("cannot create snapshot " + temp_path_);
+    }
+    // Rewritten with the final counts by Commit.
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+}
+
+inline SnapshotWriter::~SnapshotWriter() {
+    if (!committed_) {
+        out_.close();
+        (void)std::remove(temp_path_.c_str());
+    }
+}
+
+inline void SnapshotWriter::AddSection(const std::uint64_t entry_count, const std::string_view bytes) {
+    const SnapshotSection section{entry_count, bytes.size()};
+    out_.write(reinterpret_cast<const char*>(&section), sizeof(section));
+    out_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    ++header_.section_count;
+    header_.entry_count += entry_count;
+}
+
+inline std::uint64_t SnapshotWriter::Commit() {
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("cannot write snapshot " + temp_path_);
+    }
+    if (std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot rename snapshot to " + path_);
+    }
+    committed_ = true;
+    return header_.entry_count;
+}
+
+inline SnapshotFile::SnapshotFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open snapshot " + path);
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        ::close(fd);
+        throw std::runtime_error("snapshot " + path + " is truncated");
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::system_error(errno, std::generic_category(), "cannot map snapshot " + path);
+    }
+    // Sections are read front to back, several at once.
+    (void)::madvise(mapping_, size_, MADV_WILLNEED);
+
+    const std::span<const std::byte> bytes(static_cast<const std::byte*>(mapping_), size_);
+    std::memcpy(&header_, bytes.data(), sizeof(header_));
+    const auto fail = [this, &path](const char* const reason) {
+        ::munmap(mapping_, size_);
+        mapping_ = nullptr;
+        throw std::runtime_error("snapshot " + path + ": " + reason);
+    };
+    if (header_.magic != SnapshotHeader::kMagic) {
+        fail("not a snapshot file");
+    }
+    if (header_.byte_order != SnapshotHeader::kByteOrderMark) {
+        fail("written with another byte order");
+    }
+    if (header_.version != SnapshotHeader::kVersion) {
+        fail("unsupported version");
+    }
+
+    std::size_t offset = sizeof(SnapshotHeader);
+    for (std::uint64_t i = 0; i < header_.section_count; ++i) {
+        SnapshotSection section;
+        if (size_ - offset < sizeof(section)) {
+            fail("section table is truncated");
+        }
+        std::memcpy(&section, bytes.data() + offset, sizeof(section));
+        offset += sizeof(section);
+        if (size_ - offset < section.byte_count) {
+            fail("section is truncated");
+        }
+        const auto byte_count = static_cast<std::size_t>(section.byte_count);
+        sections_.push_back(Section{section.entry_count, bytes.subspan(offset, byte_count)});
+        offset += byte_count;
+    }
+}
+
+inline SnapshotFile::~SnapshotFile() {
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, size_);
+    }
+}
+
+inline const SnapshotHeader& SnapshotFile::Header() const noexcept {
+    return header_;
+}
+
+inline const std::vector<SnapshotFile::Section>& SnapshotFile::Sections() const noexcept {
+    return sections_;
+}
+
+inline void SnapshotFile::CheckCompatible(const SnapshotHeader& expected) const {
+    if (header_.flags != expected.flags || header_.key_size != expected.key_size ||
+        header_.value_size != expected.value_size) {
+        throw std::runtime_error("snapshot was written for other key/value types or codecs");
+    }
+    if ((header_.flags & SnapshotHeader::kRawEntries) == 0U) {
+        return;
+    }
+
+    const std::uint64_t entry_size = sizeof(std::int64_t) + header_.key_size + header_.value_size;
+    for (const Section& section : sections_) {
+        if (section.bytes.size() != section.entry_count * entry_size) {
+            throw std::runtime_error("snapshot section size does not match its entry count");
+        }
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_SNAPSHOT_CPP
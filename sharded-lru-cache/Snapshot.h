@@ -0,0 +1,164 @@
+#ifndef SHARDED_LRU_CACHE_SNAPSHOT_H
+#define SHARDED_LRU_CACHE_SNAPSHOT_H
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Binary snapshot format written by ShardedLRUCache::SaveSnapshot:
+//   SnapshotHeader, then section_count x (SnapshotSection, entry bytes).
+// A section holds one shard's live entries, coldest first, so reinserting
+// them in file order restores recency. Each entry is its remaining TTL in
+// milliseconds (int64, zero: none), then the encoded key, then the encoded
+// value. Integers are in native byte order; the header records which, and a
+// file from another byte order is rejected.
+
+// Types stored as their object bytes. Pointers and handles qualify too but
+// are meaningless in another process; give such types their own codec.
+template <typename T>
+concept RawSnapshotType = std::is_trivially_copyable_v<T> && std::default_initializable<T>;
+
+// Bounds-checked cursor over one section's bytes. Reads past the end throw
+// std::runtime_error.
+class SnapshotReader final {
+public:
+    explicit SnapshotReader(std::span<const std::byte> bytes) noexcept;
+
+    void ReadBytes(void* out, std::size_t count);
+    // A view into the mapped file; valid while the load runs.
+    [[nodiscard]] std::string_view ReadView(std::size_t count);
+    [[nodiscard]] bool AtEnd() const noexcept;
+
+private:
+    std::span<const std::byte> bytes_;
+};
+
+// Serialization of one key or value type. Specialize it for other types:
+//   static void Encode(const T& value, std::string& out);  // appends
+//   static T Decode(SnapshotReader& in);                    // consumes
+// or pass codec types to SaveSnapshot/LoadSnapshot directly.
+template <typename T>
+struct SnapshotCodec;
+
+template <RawSnapshotType T>
+struct SnapshotCodec<T> {
+    static void Encode(const T& value, std::string& out);
+    [[nodiscard]] static T Decode(SnapshotReader& in);
+};
+
+// Length-prefixed bytes.
+template <>
+struct SnapshotCodec<std::string> {
+    static void Encode(const std::string& value, std::string& out);
+    [[nodiscard]] static std::string Decode(SnapshotReader& in);
+};
+
+template <typename Codec, typename T>
+concept SnapshotCodecFor = requires(const T& value, std::string& out, SnapshotReader& in) {
+    Codec::Encode(value, out);
+    { Codec::Decode(in) } -> std::convertible_to<T>;
+};
+
+// Raw files: both types use the byte-copy codec, so every entry has the same
+// size, which the loader checks once per section instead of per field.
+template <typename Key, typename Value, typename KeyCodec, typename ValueCodec>
+inline constexpr bool kRawSnapshot = RawSnapshotType<Key> && RawSnapshotType<Value> &&
+                                     std::same_as<KeyCodec, SnapshotCodec<Key>> &&
+                                     std::same_as<ValueCodec, SnapshotCodec<Value>>;
+
+struct SnapshotHeader {
+    static constexpr std::array<char, 8> kMagic{'S', 'L', 'R', 'U', 'S', 'N', 'A', 'P'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kByteOrderMark = 0x01020304U;
+    static constexpr std::uint32_t kRawEntries = 1U;
+
+    std::array<char, 8> magic = kMagic;
+    std::uint32_t version = kVersion;
+    std::uint32_t byte_order = kByteOrderMark;
+    std::uint32_t flags = 0;
+    // sizeof(Key) and sizeof(Value) in raw files; zero otherwise.
+    std::uint32_t key_size = 0;
+    std::uint32_t value_size = 0;
+    std::uint32_t reserved = 0;
+    std::uint64_t section_count = 0;
+    std::uint64_t entry_count = 0;
+};
+
+struct SnapshotSection {
+    std::uint64_t entry_count = 0;
+    std::uint64_t byte_count = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader> && sizeof(SnapshotHeader) == 48U);
+static_assert(std::is_trivially_copyable_v<SnapshotSection> && sizeof(SnapshotSection) == 16U);
+
+// The header a cache of these types writes.
+template <typename Key, typename Value, typename KeyCodec, typename ValueCodec>
+[[nodiscard]] SnapshotHeader MakeSnapshotHeader();
+
+void AppendSnapshotTtl(std::string& out, std::int64_t ttl_ms);
+[[nodiscard]] std::int64_t ReadSnapshotTtl(SnapshotReader& in);
+
+// Writes a snapshot to `path` + ".tmp" and renames it over `path` on
+// Commit, so readers never see a partial file. An uncommitted writer removes
+// its temporary file. Throws std::runtime_error on I/O errors.
+class SnapshotWriter final {
+public:
+    SnapshotWriter(std::string path, const SnapshotHeader& header);
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void AddSection(std::uint64_t entry_count, std::string_view bytes);
+    // Patches the header's counts, flushes and renames; returns the number
+    // of entries written.
+    std::uint64_t Commit();
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    SnapshotHeader header_;
+    bool committed_ = false;
+};
+
+// A snapshot mapped read-only with mmap. The constructor checks the header
+// and that every section lies inside the file, and throws
+// std::runtime_error otherwise.
+class SnapshotFile final {
+public:
+    struct Section {
+        std::uint64_t entry_count;
+        std::span<const std::byte> bytes;
+    };
+
+    explicit SnapshotFile(const std::string& path);
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    [[nodiscard]] const SnapshotHeader& Header() const noexcept;
+    [[nodiscard]] const std::vector<Section>& Sections() const noexcept;
+    // Throws std::runtime_error unless the file was written with `expected`'s
+    // encoding (raw or codec) and, for raw files, the same type sizes.
+    void CheckCompatible(const SnapshotHeader& expected) const;
+
+private:
+    void* mapping_ = nullptr;
+    std::size_t size_ = 0;
+    SnapshotHeader header_;
+    std::vector<Section> sections_;
+};
+
+#include "Snapshot.cpp"
+
+#endif  // SHARDED_LRU_CACHE_SNAPSHOT_H
@@ -0,0 +1,81 @@
+#ifndef SHARDED_LRU_CACHE_TASK_CPP
+#define SHARDED_LRU_CACHE_TASK_CPP
+
+#include "Task.h"
+
+namespace task_detail {
+
+template <typename Promise>
+std::coroutine_handle<> PromiseBase::FinalAwaiter::await_suspend(
+    const std::coroutine_handle<Promise> handle) const noexcept {
+    return handle.promise().continuation_;
+}
+
+inline void PromiseBase::RethrowIfFailed() const {
+    if (error_ != nullptr) {
+        std::rethrow_exception(error_);
+    }
+}
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+template <typename T>
+T Promise<T>::TakeResult() {
+    RethrowIfFailed();
+    return std::move(*value_);
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+inline void Promise<void>::TakeResult() const {
+    RethrowIfFailed();
+}
+
+}  // namespace task_detail
+
+template <typename T>
+Task<T>::Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+template <typename T>
+Task<T>& Task<T>::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+template <typename T>
+Task<T>::~Task() {
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+template <typename T>
+typename Task<T>::Awaiter Task<T>::operator co_await() && noexcept {
+    return Awaiter(handle_);
+}
+
+template <typename T>
+std::coroutine_handle<> Task<T>::Awaiter::await_suspend(
+    const std::coroutine_handle<> awaiting) const noexcept {
+    // Starting the task is a transfer too: the awaiting coroutine stays
+    // suspended until the task's final suspend hands control back.
+    handle_.promise().SetContinuation(awaiting);
+    return handle_;
+}
+
+template <typename T>
+T Task<T>::Awaiter::await_resume() const {
+    return handle_.promise().TakeResult();
+}
+
+#endif  // SHARDED_LRU_CACHE_TASK_CPP
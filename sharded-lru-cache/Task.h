@@ -0,0 +1,106 @@
+#ifndef SHARDED_LRU_CACHE_TASK_H
+#define SHARDED_LRU_CACHE_TASK_H
+
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T = void>
+class Task;
+
+namespace task_detail {
+
+class PromiseBase {
+public:
+    // Resumes whoever awaited the task, by symmetric transfer, so chains of
+    // tasks finishing together do not grow the stack.
+    struct FinalAwaiter {
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    [[nodiscard]] std::suspend_always initial_suspend() const noexcept { return {}; }
+    [[nodiscard]] FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+    void SetContinuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+protected:
+    void RethrowIfFailed() const;
+
+private:
+    std::coroutine_handle<> continuation_ = std::noop_coroutine();
+    std::exception_ptr error_;
+};
+
+template <typename T>
+class Promise final : public PromiseBase {
+public:
+    [[nodiscard]] Task<T> get_return_object() noexcept;
+    template <typename U>
+        requires std::convertible_to<U&&, T>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+    [[nodiscard]] T TakeResult();
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class Promise<void> final : public PromiseBase {
+public:
+    [[nodiscard]] Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void TakeResult() const;
+};
+
+}  // namespace task_detail
+
+// Lazily started coroutine producing a T. Nothing runs until the task is
+// awaited; the awaiting coroutine resumes when the task finishes, on the
+// thread that finished it, and gets its value or its exception. A task is
+// move-only and may be awaited once; one never awaited is destroyed without
+// running.
+template <typename T>
+class [[nodiscard]] Task final {
+public:
+    using promise_type = task_detail::Promise<T>;
+
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+    ~Task();
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    class Awaiter {
+    public:
+        explicit Awaiter(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept;
+        T await_resume() const;
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    Awaiter operator co_await() && noexcept;
+
+private:
+    friend promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+#include "Task.cpp"
+
+#endif  // SHARDED_LRU_CACHE_TASK_H
@@ -0,0 +1,160 @@
+#ifndef SHARDED_LRU_CACHE_TIMINGWHEEL_CPP
+#define SHARDED_LRU_CACHE_TIMINGWHEEL_CPP
+
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+template <typename Key>
+typename TimingWheel<Key>::Handle TimingWheel<Key>::Schedule(const Key& key, const Tick deadline) {
+    // New nodes are built in a staging list and then spliced into their slot,
+    // so placement shares one code path with cascading.
+    staging_.push_back(Node{&key, deadline, 0U, 0U});
+    const Handle node = std::prev(staging_.end());
+    // The current tick has already been expired, so due keys go to the next.
+    Place(staging_, node, current_ + 1U);
+    ++size_;
+    return node;
+}
+
+template <typename Key>
+void TimingWheel<Key>::Cancel(const Handle handle) noexcept {
+    Slot& slot = slots_[handle->level][handle->slot];
+    const std::size_t level = handle->level;
+    const std::size_t index = handle->slot;
+    slot.erase(handle);
+    if (slot.empty()) {
+        occupied_[level] &= ~(std::uint64_t{1} << index);
+    }
+    --size_;
+}
+
+template <typename Key>
+template <typename OnExpire>
+void TimingWheel<Key>::Advance(const Tick now, OnExpire&& on_expire) {
+    while (current_ < now) {
+        if (size_ == 0U) {
+            current_ = now;
+            return;
+        }
+
+        // While every level below `lowest` is empty, nothing can expire or
+        // move until the next `lowest`-level boundary, so jump to just
+        // before it.
+        std::size_t lowest = 0;
+        while (occupied_[lowest] == 0U) {
+            ++lowest;
+        }
+        if (lowest > 0U) {
+            const Tick period_end = current_ | ((Tick{1} << (kSlotBits * lowest)) - 1U);
+            if (now <= period_end) {
+                current_ = now;
+                return;
+            }
+            current_ = period_end;
+        }
+
+        // Expire level-0 slots up to `now` or the end of this revolution,
+        // whichever comes first, visiting only occupied slots.
+        const Tick revolution_end = current_ | kSlotMask;
+        const Tick target = std::min(now, revolution_end);
+        if (target > current_) {
+            const auto first = static_cast<unsigned>((current_ + 1U) & kSlotMask);
+            const auto last = static_cast<unsigned>(target & kSlotMask);
+            const std::uint64_t through_last =
+                last == kSlotMask ? ~std::uint64_t{0} : (std::uint64_t{1} << (last + 1U)) - 1U;
+            std::uint64_t due = occupied_[0] & through_last & ~((std::uint64_t{1} << first) - 1U);
+            while (due != 0U) {
+                const auto slot = static_cast<std::size_t>(std::countr_zero(due));
+                due &= due - 1U;
+                ExpireSlot(slot, on_expire);
+            }
+            current_ = target;
+        }
+
+        if (current_ < now) {
+            // Crossing into the next revolution: pull the next higher-level
+            // slots down before expiring the new revolution's first tick.
+            current_ = revolution_end + 1U;
+            Cascade();
+            if ((occupied_[0] & 1U) != 0U) {
+                ExpireSlot(0U, on_expire);
+            }
+        }
+    }
+}
+
+template <typename Key>
+std::size_t TimingWheel<Key>::Size() const noexcept {
+    return size_;
+}
+
+template <typename Key>
+void TimingWheel<Key>::Clear() noexcept {
+    for (auto& level : slots_) {
+        for (Slot& slot : level) {
+            slot.clear();
+        }
+    }
+    occupied_.fill(0U);
+    size_ = 0U;
+}
+
+template <typename Key>
+void TimingWheel<Key>::Place(Slot& source, const Handle node, const Tick earliest) noexcept {
+    // Deadlines before `earliest` are placed at it; deadlines past the wheel's
+    // span park in the top level and are re-placed when it cascades.
+    const Tick deadline = std::clamp(node->deadline, earliest, current_ + kSpan - 1U);
+    const Tick delta = deadline - current_;
+
+    std::size_t level = 0;
+    while (level + 1U < kLevels && delta >= (Tick{1} << (kSlotBits * (level + 1U)))) {
+        ++level;
+    }
+    const auto slot = static_cast<std::size_t>((deadline >> (kSlotBits * level)) & kSlotMask);
+
+    node->level = static_cast<std::uint8_t>(level);
+    node->slot = static_cast<std::uint8_t>(slot);
+    slots_[level][slot].splice(slots_[level][slot].end(), source, node);
+    occupied_[level] |= std::uint64_t{1} << slot;
+}
+
+template <typename Key>
+void TimingWheel<Key>::Cascade() noexcept {
+    for (std::size_t level = 1; level < kLevels; ++level) {
+        if ((current_ & ((Tick{1} << (kSlotBits * level)) - 1U)) != 0U) {
+            return;
+        }
+
+        const auto index = static_cast<std::size_t>((current_ >> (kSlotBits * level)) & kSlotMask);
+        if ((occupied_[level] & (std::uint64_t{1} << index)) == 0U) {
+            continue;
+        }
+
+        Slot pending;
+        pending.splice(pending.end(), slots_[level][index]);
+        occupied_[level] &= ~(std::uint64_t{1} << index);
+        // Runs before the boundary tick itself is expired, so keys due
+        // exactly now may land in its level-0 slot.
+        while (!pending.empty()) {
+            Place(pending, pending.begin(), current_);
+        }
+    }
+}
+
+template <typename Key>
+template <typename OnExpire>
+void TimingWheel<Key>::ExpireSlot(const std::size_t slot, OnExpire& on_expire) {
+    Slot& due = slots_[0][slot];
+    occupied_[0] &= ~(std::uint64_t{1} << slot);
+    while (!due.empty()) {
+        const Key& key = *due.front().key;
+        due.pop_front();
+        --size_;
+        on_expire(key);
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_TIMINGWHEEL_CPP
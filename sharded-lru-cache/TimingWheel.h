@@ -0,0 +1,70 @@
+#ifndef SHARDED_LRU_CACHE_TIMINGWHEEL_H
+#define SHARDED_LRU_CACHE_TIMINGWHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+
+// Hierarchical timing wheel of key deadlines, measured in abstract ticks.
+// - kLevels levels of 64 slots each. Level L covers deltas below 64^(L+1)
+//   ticks, so five levels span about 2^30 ticks (12 days at 1 ms per tick).
+//   Later deadlines park in the top level and are re-placed when it cascades.
+// - Schedule/Cancel are O(1). Advance expires due keys and cascades one
+//   higher-level slot into lower levels each time a lower level wraps, so
+//   every key moves at most kLevels times before it expires.
+// - A 64-bit occupancy mask per level lets Advance skip empty slots, and whole
+//   periods of a level while every level below it is empty.
+// Keys are referenced, not copied: the caller keeps them alive until they are
+// cancelled or handed to the Advance callback.
+template <typename Key>
+class TimingWheel final {
+public:
+    using Tick = std::uint64_t;
+
+private:
+    struct Node {
+        const Key* key;
+        Tick deadline;
+        std::uint8_t level;
+        std::uint8_t slot;
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    // Inserts `key` to expire at `deadline`; deadlines at or before the
+    // current tick expire on the next Advance past it.
+    [[nodiscard]] Handle Schedule(const Key& key, Tick deadline);
+    void Cancel(Handle handle) noexcept;
+    // Moves the wheel to `now`, calling `on_expire(key)` for every key whose
+    // deadline is at or before it. Each key is unlinked before its callback.
+    template <typename OnExpire>
+    void Advance(Tick now, OnExpire&& on_expire);
+    [[nodiscard]] std::size_t Size() const noexcept;
+    void Clear() noexcept;
+
+private:
+    static constexpr std::size_t kLevels = 5;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+    static constexpr Tick kSlotMask = kSlots - 1U;
+    static constexpr Tick kSpan = Tick{1} << (kSlotBits * kLevels);
+
+    using Slot = std::list<Node>;
+
+    void Place(Slot& source, Handle node, Tick earliest) noexcept;
+    void Cascade() noexcept;
+    template <typename OnExpire>
+    void ExpireSlot(std::size_t slot, OnExpire& on_expire);
+
+    std::array<std::array<Slot, kSlots>, kLevels> slots_;
+    std::array<std::uint64_t, kLevels> occupied_{};
+    Slot staging_;
+    Tick current_ = 0;
+    std::size_t size_ = 0;
+};
+
+#include "TimingWheel.cpp"
+
+#endif  // SHARDED_LRU_CACHE_TIMINGWHEEL_H
@@ -0,0 +1,120 @@
+#ifndef SHARDED_LRU_CACHE_TINYLFUPOLICY_CPP
+#define SHARDED_LRU_CACHE_TINYLFUPOLICY_CPP
+
+#include "TinyLfuPolicy.h"
+
+#include <algorithm>
+#include <iterator>
+
+template <typename Key>
+TinyLfuPolicy<Key>::TinyLfuPolicy(const std::size_t capacity)
+    : window_limit_(std::max<std::size_t>(1U, capacity / 100U)),
+      main_limit_(capacity - std::min(capacity, window_limit_)),
+      protected_limit_((main_limit_ * 4U) / 5U),
+      sketch_(capacity) {}
+
+template <typename Key>
+typename TinyLfuPolicy<Key>::Handle TinyLfuPolicy<Key>::OnInsert(const Key& key) {
+    sketch_.Increment(key);
+    window_.push_front(Node{&key, Segment::kWindow});
+    return window_.begin();
+}
+
+template <typename Key>
+void TinyLfuPolicy<Key>::OnAccess(const Handle handle) {
+    sketch_.Increment(*handle->key);
+
+    switch (handle->segment) {
+        case Segment::kWindow:
+            window_.splice(window_.begin(), window_, handle);
+            break;
+        case Segment::kProbation:
+            MoveTo(handle, Segment::kProtected);
+            if (protected_.size() > protected_limit_) {
+                MoveTo(std::prev(protected_.end()), Segment::kProbation);
+            }
+            break;
+        case Segment::kProtected:
+            protected_.splice(protected_.begin(), protected_, handle);
+            break;
+    }
+}
+
+template <typename Key>
+const Key& TinyLfuPolicy<Key>::Victim() {
+    // While the main area has room, window overflow is admitted for free.
+    while (window_.size() > window_limit_ && MainSize() < main_limit_) {
+        MoveTo(std::prev(window_.end()), Segment::kProbation);
+    }
+
+    if (MainSize() == 0U) {
+        return *window_.back().key;
+    }
+    if (window_.size() < window_limit_) {
+        return *MainVictim()->key;
+    }
+
+    const Handle candidate = std::prev(window_.end());
+    const Handle victim = MainVictim();
+    if (sketch_.Estimate(*candidate->key) > sketch_.Estimate(*victim->key)) {
+        MoveTo(candidate, Segment::kProbation);
+        return *victim->key;
+    }
+
+    return *candidate->key;
+}
+
+template <typename Key>
+void TinyLfuPolicy<Key>::OnEvict(const Handle handle) noexcept {
+    ListFor(handle->segment).erase(handle);
+}
+
+template <typename Key>
+void TinyLfuPolicy<Key>::OnRemove(const Handle handle) noexcept {
+    ListFor(handle->segment).erase(handle);
+}
+
+template <typename Key>
+void TinyLfuPolicy<Key>::Clear() noexcept {
+    window_.clear();
+    probation_.clear();
+    protected_.clear();
+    sketch_.Clear();
+}
+
+template <typename Key>
+std::list<typename TinyLfuPolicy<Key>::Node>& TinyLfuPolicy<Key>::ListFor(
+    const Segment segment) noexcept {
+    switch (segment) {
+        case Segment::kWindow:
+            return window_;
+        case Segment::kProbation:
+            return probation_;
+        case Segment::kProtected:
+            break;
+    }
+    return protected_;
+}
+
+template <typename Key>
+std::size_t TinyLfuPolicy<Key>::MainSize() const noexcept {
+    return probation_.size() + protected_.size();
+}
+
+template <typename Key>
+typename TinyLfuPolicy<Key>::Handle TinyLfuPolicy<Key>::MainVictim() noexcept {
+    if (!probation_.empty()) {
+        return std::prev(probation_.end());
+    }
+
+    return std::prev(protected_.end());
+}
+
+template <typename Key>
+void TinyLfuPolicy<Key>::MoveTo(const Handle handle, const Segment segment) noexcept {
+    std::list<Node>& destination = ListFor(segment);
+    destination.splice(destination.begin(), ListFor(handle->segment), handle);
+    handle->segment = segment;
+}
+
+#endif  // SHARDED_LRU_CACHE_TINYLFUPOLICY_CPP
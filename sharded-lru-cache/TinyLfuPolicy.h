@@ -0,0 +1,58 @@
+#ifndef SHARDED_LRU_CACHE_TINYLFUPOLICY_H
+#define SHARDED_LRU_CACHE_TINYLFUPOLICY_H
+
+#include "FrequencySketch.h"
+
+#include <cstddef>
+#include <list>
+
+// W-TinyLFU (Einziger et al.): an admission filter in front of a segmented LRU.
+// - New keys always enter a small LRU window (1% of capacity) so bursts get a
+//   chance to build up frequency.
+// - When the window overflows, its LRU key becomes a candidate for the main
+//   area and is admitted only if the frequency sketch estimates it more popular
+//   than the main area's victim; otherwise the candidate itself is evicted.
+// - The main area is a segmented LRU: admitted keys enter probation and a hit
+//   there promotes to protected, which is capped at 80% of the main area.
+// The sketch is owned by the policy, so in ShardedLRUCache it is per shard and
+// only touched under that shard's lock.
+template <typename Key>
+class TinyLfuPolicy final {
+private:
+    enum class Segment { kWindow, kProbation, kProtected };
+
+    struct Node {
+        const Key* key;
+        Segment segment;
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    explicit TinyLfuPolicy(std::size_t capacity);
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle);
+    [[nodiscard]] const Key& Victim();
+    void OnEvict(Handle handle) noexcept;
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+
+private:
+    [[nodiscard]] std::list<Node>& ListFor(Segment segment) noexcept;
+    [[nodiscard]] std::size_t MainSize() const noexcept;
+    [[nodiscard]] Handle MainVictim() noexcept;
+    void MoveTo(Handle handle, Segment segment) noexcept;
+
+    std::size_t window_limit_;
+    std::size_t main_limit_;
+    std::size_t protected_limit_;
+    std::list<Node> window_;
+    std::list<Node> probation_;
+    std::list<Node> protected_;
+    FrequencySketch<Key> sketch_;
+};
+
+#include "TinyLfuPolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_TINYLFUPOLICY_H
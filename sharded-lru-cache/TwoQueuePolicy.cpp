@@ -0,0 +1,70 @@
+#ifndef SHARDED_LRU_CACHE_TWOQUEUEPOLICY_CPP
+#define SHARDED_LRU_CACHE_TWOQUEUEPOLICY_CPP
+
+#include "TwoQueuePolicy.h"
+
+#include <algorithm>
+
+// Kin = 25% and Kout = 50% of capacity, the values recommended by the paper.
+template <typename Key>
+TwoQueuePolicy<Key>::TwoQueuePolicy(const std::size_t capacity)
+    : in_limit_(std::max<std::size_t>(1U, capacity / 4U)),
+      out_(std::max<std::size_t>(1U, capacity / 2U)) {}
+
+template <typename Key>
+typename TwoQueuePolicy<Key>::Handle TwoQueuePolicy<Key>::OnInsert(const Key& key) {
+    const bool seen_recently = out_.Erase(key);
+    out_.Trim();
+    if (seen_recently) {
+        main_.push_front(Node{&key, true});
+        return main_.begin();
+    }
+
+    in_.push_front(Node{&key, false});
+    return in_.begin();
+}
+
+template <typename Key>
+void TwoQueuePolicy<Key>::OnAccess(const Handle handle) noexcept {
+    if (handle->hot) {
+        main_.splice(main_.begin(), main_, handle);
+    }
+}
+
+template <typename Key>
+const Key& TwoQueuePolicy<Key>::Victim() const noexcept {
+    if (!in_.empty() && (in_.size() > in_limit_ || main_.empty())) {
+        return *in_.back().key;
+    }
+
+    return *main_.back().key;
+}
+
+template <typename Key>
+void TwoQueuePolicy<Key>::OnEvict(const Handle handle) {
+    if (handle->hot) {
+        main_.erase(handle);
+        return;
+    }
+
+    out_.Push(*handle->key);
+    in_.erase(handle);
+}
+
+template <typename Key>
+void TwoQueuePolicy<Key>::OnRemove(const Handle handle) noexcept {
+    if (handle->hot) {
+        main_.erase(handle);
+    } else {
+        in_.erase(handle);
+    }
+}
+
+template <typename Key>
+void TwoQueuePolicy<Key>::Clear() noexcept {
+    in_.clear();
+    main_.clear();
+    out_.Clear();
+}
+
+#endif  // SHARDED_LRU_CACHE_TWOQUEUEPOLICY_CPP
@@ -0,0 +1,43 @@
+#ifndef SHARDED_LRU_CACHE_TWOQUEUEPOLICY_H
+#define SHARDED_LRU_CACHE_TWOQUEUEPOLICY_H
+
+#include "GhostList.h"
+
+#include <cstddef>
+#include <list>
+
+// Full 2Q (Johnson & Shasha):
+// - A1in: FIFO of first-time keys; hits there are treated as correlated and
+//   do not promote, so a one-pass scan only ever churns A1in.
+// - A1out: ghost keys recently evicted from A1in.
+// - Am: LRU of keys that were referenced again after leaving A1in.
+template <typename Key>
+class TwoQueuePolicy final {
+private:
+    struct Node {
+        const Key* key;
+        bool hot;
+    };
+
+public:
+    using Handle = typename std::list<Node>::iterator;
+
+    explicit TwoQueuePolicy(std::size_t capacity);
+
+    [[nodiscard]] Handle OnInsert(const Key& key);
+    void OnAccess(Handle handle) noexcept;
+    [[nodiscard]] const Key& Victim() const noexcept;
+    void OnEvict(Handle handle);
+    void OnRemove(Handle handle) noexcept;
+    void Clear() noexcept;
+
+private:
+    std::size_t in_limit_;
+    std::list<Node> in_;
+    std::list<Node> main_;
+    GhostList<Key> out_;
+};
+
+#include "TwoQueuePolicy.cpp"
+
+#endif  // SHARDED_LRU_CACHE_TWOQUEUEPOLICY_H
@@ -0,0 +1,85 @@
+#ifndef SHARDED_LRU_CACHE_WORKERPOOL_CPP
+#define SHARDED_LRU_CACHE_WORKERPOOL_CPP
+
+#include "WorkerPool.h"
+
+#include <stdexcept>
+#include <utility>
+
+inline WorkerPool::WorkerPool(const std::size_t threads, const std::size_t max_queued)
+    : max_queued_(max_queued) {
+    if (threads == 0U) {
+        throw std::invalid_argument("WorkerPool threads must be greater than zero");
+    }
+    if (max_queued == 0U) {
+        throw std::invalid_argument("WorkerPool max_queued must be greater than zero");
+    }
+
+    threads_.reserve(threads);
+    try {
+        for (std::size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this] { Run(); });
+        }
+    } catch (...) {
+        {
+            std::scoped_lock lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+        throw;
+    }
+}
+
+inline WorkerPool::~WorkerPool() {
+    {
+        std::scoped_lock lock(mutex_);
+        stopping_ = true;
+        tasks_.clear();
+    }
+    ready_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+inline bool WorkerPool::TrySubmit(std::function<void()> task) {
+    {
+        std::scoped_lock lock(mutex_);
+        if (stopping_ || tasks_.size() >= max_queued_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+    return true;
+}
+
+inline std::size_t WorkerPool::Queued() const {
+    std::scoped_lock lock(mutex_);
+    return tasks_.size();
+}
+
+inline void WorkerPool::Run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        try {
+            task();
+        } catch (...) {
+            // A task owns its errors; the thread keeps serving the queue.
+        }
+    }
+}
+
+#endif  // SHARDED_LRU_CACHE_WORKERPOOL_CPP
@@ -0,0 +1,44 @@
+#ifndef SHARDED_LRU_CACHE_WORKERPOOL_H
+#define SHARDED_LRU_CACHE_WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running submitted tasks in FIFO order. The queue is
+// bounded: TrySubmit refuses work instead of letting a backlog grow, so the
+// caller decides what to do with it. Exceptions thrown by a task are caught
+// and dropped.
+class WorkerPool final {
+public:
+    // Throws std::invalid_argument if either count is zero.
+    WorkerPool(std::size_t threads, std::size_t max_queued);
+    // Drops tasks still queued and waits for the running ones.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Returns false, without running `task`, if max_queued tasks are already
+    // waiting for a thread.
+    bool TrySubmit(std::function<void()> task);
+    [[nodiscard]] std::size_t Queued() const;
+
+private:
+    void Run();
+
+    std::size_t max_queued_;
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+#include "WorkerPool.cpp"
+
+#endif  // SHARDED_LRU_CACHE_WORKERPOOL_H
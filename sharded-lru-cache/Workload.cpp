@@ -0,0 +1,215 @@
+#ifndef SHARDED_LRU_CACHE_WORKLOAD_CPP
+#define SHARDED_LRU_CACHE_WORKLOAD_CPP
+
+#include "Workload.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+inline std::vector<Operation> ParseTrace(std::istream& input) {
+    std::vector<Operation> trace;
+    std::string line;
+    for (std::size_t line_number = 1; std::getline(input, line); ++line_number) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first.front() == '#') {
+            continue;
+        }
+
+        Operation operation;
+        std::string key_field = first;
+        if (std::isdigit(static_cast<unsigned char>(first.front())) == 0) {
+            std::transform(first.begin(), first.end(), first.begin(),
+                           [](const unsigned char c) { return static_cast<char>(std::toupper(c)); });
+            if (first == "PUT" || first == "SET" || first == "W") {
+                operation.write = true;
+            } else if (first != "GET" && first != "R") {
+                throw std::runtime_error("trace line " + std::to_string(line_number) +
+                                         ": unknown operation '" + first + "'");
+            }
+            if (!(fields >> key_field)) {
+                throw std::runtime_error("trace line " + std::to_string(line_number) + ": missing key");
+            }
+        }
+
+        std::size_t parsed = 0;
+        try {
+            operation.key = std::stoull(key_field, &parsed);
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        std::string rest;
+        if (parsed != key_field.size() || (fields >> rest)) {
+            throw std::runtime_error("trace line " + std::to_string(line_number) + ": malformed key");
+        }
+        trace.push_back(operation);
+    }
+    return trace;
+}
+
+inline std::vector<Operation> LoadTrace(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("cannot open trace " + path);
+    }
+    return ParseTrace(input);
+}
+
+inline Workload::Workload(WorkloadSpec spec) : spec_(spec) {
+    if (spec_.key_space == 0U) {
+        throw std::invalid_argument("workload key_space must be greater than zero");
+    }
+    if (!(spec_.read_ratio >= 0.0 && spec_.read_ratio <= 1.0)) {
+        throw std::invalid_argument("workload read_ratio must be in [0, 1]");
+    }
+    if (!(spec_.hot_key_fraction > 0.0 && spec_.hot_key_fraction <= 1.0) ||
+        !(spec_.hot_access_fraction >= 0.0 && spec_.hot_access_fraction <= 1.0)) {
+        throw std::invalid_argument("workload hotspot fractions must be in (0, 1] and [0, 1]");
+    }
+
+    std::ostringstream name;
+    switch (spec_.distribution) {
+        case KeyDistribution::kUniform:
+            name << "uniform";
+            break;
+        case KeyDistribution::kZipfian: {
+            const double theta = spec_.zipf_theta;
+            if (!(theta > 0.0 && theta < 1.0)) {
+                throw std::invalid_argument("workload zipf_theta must be in (0, 1)");
+            }
+            for (std::uint64_t rank = 1; rank <= spec_.key_space; ++rank) {
+                zeta_n_ += 1.0 / std::pow(static_cast<double>(rank), theta);
+            }
+            const double zeta_2 = 1.0 + std::pow(0.5, theta);
+            alpha_ = 1.0 / (1.0 - theta);
+            half_pow_theta_ = std::pow(0.5, theta);
+            eta_ = (1.0 - std::pow(2.0 / static_cast<double>(spec_.key_space), 1.0 - theta)) /
+                   (1.0 - zeta_2 / zeta_n_);
+            name << "zipfian(theta=" << theta << ')';
+            break;
+        }
+        case KeyDistribution::kHotspot:
+            name << "hotspot(" << spec_.hot_access_fraction * 100.0 << "% on "
+                 << spec_.hot_key_fraction * 100.0 << "%)";
+            break;
+        case KeyDistribution::kScan:
+            name << "scan";
+            break;
+    }
+    name_ = name.str();
+}
+
+inline Workload::Workload(std::vector<Operation> trace, std::string name)
+    : name_(std::move(name)), trace_(std::make_shared<const std::vector<Operation>>(std::move(trace))) {
+    if (trace_->empty()) {
+        throw std::invalid_argument("workload trace must not be empty");
+    }
+
+    std::uint64_t reads = 0;
+    std::uint64_t largest = 0;
+    for (const Operation& operation : *trace_) {
+        reads += operation.write ? 0U : 1U;
+        largest = std::max(largest, operation.key);
+    }
+    spec_.key_space = largest + 1U;
+    spec_.read_ratio = static_cast<double>(reads) / static_cast<double>(trace_->size());
+}
+
+inline const std::string& Workload::Name() const noexcept {
+    return name_;
+}
+
+inline const WorkloadSpec& Workload::Spec() const noexcept {
+    return spec_;
+}
+
+inline bool Workload::IsTrace() const noexcept {
+    return trace_ != nullptr;
+}
+
+inline WorkloadGenerator::WorkloadGenerator(const Workload& workload, const std::size_t thread_index,
+                                            const std::size_t thread_count, const std::uint64_t seed)
+    : workload_(workload),
+      random_(seed * 0x9E3779B97F4A7C15ULL + thread_index),
+      position_(0),
+      stride_(std::max<std::size_t>(1U, thread_count)) {
+    if (workload_.IsTrace()) {
+        position_ = thread_index % workload_.trace_->size();
+    } else if (workload_.spec_.distribution == KeyDistribution::kScan) {
+        // Threads start evenly spread over the key space.
+        const std::uint64_t key_space = workload_.spec_.key_space;
+        position_ = static_cast<std::size_t>(key_space / stride_ * (thread_index % stride_));
+    }
+}
+
+inline Operation WorkloadGenerator::Next() {
+    if (workload_.IsTrace()) {
+        const std::vector<Operation>& trace = *workload_.trace_;
+        const Operation operation = trace[position_];
+        position_ = (position_ + stride_) % trace.size();
+        return operation;
+    }
+
+    Operation operation;
+    operation.key = NextKey();
+    operation.write = Uniform01() >= workload_.spec_.read_ratio;
+    return operation;
+}
+
+inline double WorkloadGenerator::Uniform01() {
+    // 53 random bits: every double in [0, 1) this can return is exact.
+    return static_cast<double>(random_() >> 11U) * 0x1.0p-53;
+}
+
+inline std::uint64_t WorkloadGenerator::UniformBelow(const std::uint64_t bound) {
+    // The modulo bias is below 2^-40 for key spaces under 2^24.
+    return random_() % bound;
+}
+
+inline std::uint64_t WorkloadGenerator::NextKey() {
+    const WorkloadSpec& spec = workload_.spec_;
+    switch (spec.distribution) {
+        case KeyDistribution::kUniform:
+            return UniformBelow(spec.key_space);
+        case KeyDistribution::kZipfian:
+            return NextZipfian();
+        case KeyDistribution::kHotspot: {
+            const auto hot_keys = std::max<std::uint64_t>(
+                1U, static_cast<std::uint64_t>(static_cast<double>(spec.key_space) * spec.hot_key_fraction));
+            if (hot_keys >= spec.key_space || Uniform01() < spec.hot_access_fraction) {
+                return UniformBelow(hot_keys);
+            }
+            return hot_keys + UniformBelow(spec.key_space - hot_keys);
+        }
+        case KeyDistribution::kScan: {
+            const std::uint64_t key = position_;
+            position_ = static_cast<std::size_t>((key + 1U) % spec.key_space);
+            return key;
+        }
+    }
+    return 0;
+}
+
+inline std::uint64_t WorkloadGenerator::NextZipfian() {
+    // Gray et al., "Quickly Generating Billion-Record Synthetic Databases";
+    // rank 0 is the most popular key.
+    const std::uint64_t key_space = workload_.spec_.key_space;
+    const double u = Uniform01();
+    const double uz = u * workload_.zeta_n_;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + workload_.half_pow_theta_) {
+        return std::min<std::uint64_t>(1U, key_space - 1U);
+    }
+    const double eta = workload_.eta_;
+    const double rank = static_cast<double>(key_space) * std::pow(eta * u - eta + 1.0, workload_.alpha_);
+    return std::min(static_cast<std::uint64_t>(rank), key_space - 1U);
+}
+
+#endif  // SHARDED_LRU_CACHE_WORKLOAD_CPP
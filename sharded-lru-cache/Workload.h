@@ -0,0 +1,103 @@
+#ifndef SHARDED_LRU_CACHE_WORKLOAD_H
+#define SHARDED_LRU_CACHE_WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Key distributions the benchmark harness can generate.
+enum class KeyDistribution {
+    // Every key equally likely.
+    kUniform,
+    // Key of rank r drawn with probability proportional to 1 / r^theta.
+    kZipfian,
+    // hot_access_fraction of accesses go to the first hot_key_fraction of
+    // the key space, uniformly; the rest go to the cold keys.
+    kHotspot,
+    // Each thread walks the key space in order from its own starting offset.
+    kScan,
+};
+
+struct WorkloadSpec {
+    KeyDistribution distribution = KeyDistribution::kUniform;
+    std::uint64_t key_space = std::uint64_t{1} << 20;
+    // Share of operations that are reads; the rest are writes.
+    double read_ratio = 0.9;
+    // Zipfian skew, in (0, 1); YCSB uses 0.99.
+    double zipf_theta = 0.99;
+    double hot_key_fraction = 0.2;
+    double hot_access_fraction = 0.8;
+};
+
+struct Operation {
+    std::uint64_t key = 0;
+    bool write = false;
+};
+
+// Parses a recorded trace: one operation per line, either `<key>` (a read)
+// or `<op> <key>` with op one of GET/R (read) or PUT/SET/W (write), in any
+// case. Blank lines and lines starting with '#' are skipped. Throws
+// std::runtime_error naming the first malformed line.
+[[nodiscard]] std::vector<Operation> ParseTrace(std::istream& input);
+// ParseTrace on a file; throws std::runtime_error if it cannot be opened.
+[[nodiscard]] std::vector<Operation> LoadTrace(const std::string& path);
+
+// A validated workload plus the state every thread's generator shares: the
+// Zipfian normalisation constants, or the trace being replayed.
+class Workload final {
+public:
+    // Throws std::invalid_argument for an empty key space, a ratio outside
+    // [0, 1] or a Zipfian theta outside (0, 1). A Zipfian workload sums
+    // key_space powers up front.
+    explicit Workload(WorkloadSpec spec);
+    // Replays `trace`, which must not be empty; `name` labels the results.
+    Workload(std::vector<Operation> trace, std::string name);
+
+    // Short label for reports, e.g. "zipfian(theta=0.99)".
+    [[nodiscard]] const std::string& Name() const noexcept;
+    [[nodiscard]] const WorkloadSpec& Spec() const noexcept;
+    [[nodiscard]] bool IsTrace() const noexcept;
+
+private:
+    friend class WorkloadGenerator;
+
+    WorkloadSpec spec_;
+    std::string name_;
+    // Zipfian constants (Gray et al., as in YCSB).
+    double zeta_n_ = 0.0;
+    double alpha_ = 0.0;
+    double eta_ = 0.0;
+    double half_pow_theta_ = 0.0;
+    std::shared_ptr<const std::vector<Operation>> trace_;
+};
+
+// Per-thread operation stream. Cheap to construct; not thread-safe.
+// Thread `thread_index` of `thread_count` replays trace operations
+// thread_index, thread_index + thread_count, ..., wrapping at the end, so the
+// threads together keep roughly the recorded order.
+class WorkloadGenerator final {
+public:
+    WorkloadGenerator(const Workload& workload, std::size_t thread_index, std::size_t thread_count,
+                      std::uint64_t seed);
+
+    [[nodiscard]] Operation Next();
+
+private:
+    [[nodiscard]] double Uniform01();
+    [[nodiscard]] std::uint64_t UniformBelow(std::uint64_t bound);
+    [[nodiscard]] std::uint64_t NextKey();
+    [[nodiscard]] std::uint64_t NextZipfian();
+
+    const Workload& workload_;
+    std::mt19937_64 random_;
+    std::size_t position_;
+    std::size_t stride_;
+};
+
+#include "Workload.cpp"
+
+#endif  // SHARDED_LRU_CACHE_WORKLOAD_H
@@ -0,0 +1,213 @@
+#include "BenchmarkHarness.h"
+#include "ConcurrentLRUCache.h"
+#include "ShardedLRUCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Sweeps workloads x read ratios x thread counts over ShardedLRUCache and
+// ConcurrentLRUCache and prints the results as JSON. Progress goes to stderr.
+namespace {
+
+struct BenchmarkConfig {
+    std::vector<std::size_t> threads;
+    std::vector<double> read_ratios{0.5, 0.9, 0.99};
+    std::vector<std::string> distributions{"uniform", "zipfian", "hotspot", "scan"};
+    std::uint64_t key_space = std::uint64_t{1} << 20;
+    std::size_t capacity = std::size_t{1} << 16;
+    std::size_t shards = 16;
+    double theta = 0.99;
+    std::optional<std::string> trace;
+    std::optional<std::string> output;
+    WorkloadRunOptions run;
+};
+
+void PrintUsage(std::ostream& output) {
+    output << "usage: benchmark [options]\n"
+              "  --threads N,N,...       thread counts (default 1, 2, 4, ... up to hardware threads)\n"
+              "  --read-ratios R,R,...   read shares in [0, 1] (default 0.5,0.9,0.99)\n"
+              "  --workloads W,W,...     uniform, zipfian, hotspot, scan (default all)\n"
+              "  --trace FILE            replay FILE instead of generating keys\n"
+              "  --key-space N           distinct keys (default 1048576)\n"
+              "  --capacity N            total cache entries (default 65536)\n"
+              "  --shards N              ShardedLRUCache shards (default 16)\n"
+              "  --theta X               Zipfian skew in (0, 1) (default 0.99)\n"
+              "  --ops N                 operations per thread (default 100000)\n"
+              "  --warmup N              untimed operations first (default 100000)\n"
+              "  --sample N              time one operation in N (default 16, 0 = off)\n"
+              "  --out FILE              write JSON to FILE instead of stdout\n";
+}
+
+template <typename T>
+[[nodiscard]] T ParseNumber(const std::string_view flag, const std::string& text) {
+    std::istringstream input(text);
+    T value{};
+    if (!(input >> value) || !input.eof()) {
+        throw std::invalid_argument("bad value for " + std::string(flag) + ": " + text);
+    }
+    return value;
+}
+
+template <typename T>
+[[nodiscard]] std::vector<T> ParseList(const std::string_view flag, const std::string& text) {
+    std::vector<T> values;
+    std::istringstream input(text);
+    std::string item;
+    while (std::getline(input, item, ',')) {
+        if constexpr (std::is_same_v<T, std::string>) {
+            values.push_back(item);
+        } else {
+            values.push_back(ParseNumber<T>(flag, item));
+        }
+    }
+    if (values.empty()) {
+        throw std::invalid_argument("empty list for " + std::string(flag));
+    }
+    return values;
+}
+
+[[nodiscard]] std::vector<std::size_t> DefaultThreadCounts() {
+    const std::size_t hardware = std::max(4U, std::thread::hardware_concurrency());
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads <= hardware; threads *= 2U) {
+        counts.push_back(threads);
+    }
+    return counts;
+}
+
+[[nodiscard]] BenchmarkConfig ParseArguments(const int argc, char** argv) {
+    BenchmarkConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view flag = argv[i];
+        if (flag == "--help" || flag == "-h") {
+            PrintUsage(std::cout);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("missing value for " + std::string(flag));
+        }
+        const std::string value = argv[++i];
+        if (flag == "--threads") {
+            config.threads = ParseList<std::size_t>(flag, value);
+        } else if (flag == "--read-ratios") {
+            config.read_ratios = ParseList<double>(flag, value);
+        } else if (flag == "--workloads") {
+            config.distributions = ParseList<std::string>(flag, value);
+        } else if (flag == "--trace") {
+            config.trace = value;
+        } else if (flag == "--key-space") {
+            config.key_space = ParseNumber<std::uint64_t>(flag, value);
+        } else if (flag == "--capacity") {
+            config.capacity = ParseNumber<std::size_t>(flag, value);
+        } else if (flag == "--shards") {
+            config.shards = ParseNumber<std::size_t>(flag, value);
+        } else if (flag == "--theta") {
+            config.theta = ParseNumber<double>(flag, value);
+        } else if (flag == "--ops") {
+            config.run.operations_per_thread = ParseNumber<std::size_t>(flag, value);
+        } else if (flag == "--warmup") {
+            config.run.warmup_operations = ParseNumber<std::size_t>(flag, value);
+        } else if (flag == "--sample") {
+            config.run.latency_sample_interval = ParseNumber<std::size_t>(flag, value);
+        } else if (flag == "--out") {
+            config.output = value;
+        } else {
+            throw std::invalid_argument("unknown option " + std::string(flag));
+        }
+    }
+    if (config.threads.empty()) {
+        config.threads = DefaultThreadCounts();
+    }
+    if (config.shards == 0U || config.capacity < config.shards) {
+        throw std::invalid_argument("--capacity must be at least --shards, and --shards at least 1");
+    }
+    return config;
+}
+
+[[nodiscard]] KeyDistribution ParseDistribution(const std::string& name) {
+    if (name == "uniform") {
+        return KeyDistribution::kUniform;
+    }
+    if (name == "zipfian") {
+        return KeyDistribution::kZipfian;
+    }
+    if (name == "hotspot") {
+        return KeyDistribution::kHotspot;
+    }
+    if (name == "scan") {
+        return KeyDistribution::kScan;
+    }
+    throw std::invalid_argument("unknown workload " + name);
+}
+
+// Both caches start empty for every run, so earlier runs do not warm them.
+void RunBothCaches(const BenchmarkConfig& config, const Workload& workload,
+                   std::vector<WorkloadResult>& results) {
+    for (const std::size_t threads : config.threads) {
+        WorkloadRunOptions options = config.run;
+        options.threads = threads;
+
+        ShardedLRUCache<std::uint64_t, std::uint64_t> sharded(config.capacity / config.shards, config.shards);
+        results.push_back(RunWorkload(sharded, "ShardedLRUCache", workload, options));
+        ConcurrentLRUCache<std::uint64_t, std::uint64_t> concurrent(config.capacity);
+        results.push_back(RunWorkload(concurrent, "ConcurrentLRUCache", workload, options));
+
+        for (auto result = results.end() - 2; result != results.end(); ++result) {
+            std::cerr << result->cache << ' ' << result->workload << " read=" << result->read_ratio << ' '
+                      << result->threads << " threads: " << result->ops_per_second / 1e6 << " M ops/s, hit "
+                      << result->hit_ratio << ", p99 " << result->p99.count() << " ns\n";
+        }
+    }
+}
+
+}  // namespace
+
+int main(const int argc, char** argv) {
+    try {
+        const BenchmarkConfig config = ParseArguments(argc, argv);
+        std::vector<WorkloadResult> results;
+        if (config.trace.has_value()) {
+            const Workload workload(LoadTrace(*config.trace), "trace(" + *config.trace + ")");
+            RunBothCaches(config, workload, results);
+        } else {
+            for (const std::string& distribution : config.distributions) {
+                for (const double read_ratio : config.read_ratios) {
+                    WorkloadSpec spec;
+                    spec.distribution = ParseDistribution(distribution);
+                    spec.key_space = config.key_space;
+                    spec.read_ratio = read_ratio;
+                    spec.zipf_theta = config.theta;
+                    RunBothCaches(config, Workload(spec), results);
+                }
+            }
+        }
+
+        if (config.output.has_value()) {
+            std::ofstream output(*config.output);
+            if (!output) {
+                throw std::runtime_error("cannot open " + *config.output);
+            }
+            WriteJson(output, results);
+        } else {
+            WriteJson(std::cout, results);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << "benchmark: " << error.what() << '\n';
+        PrintUsage(std::cerr);
+        return 1;
+    }
+    return 0;
+}
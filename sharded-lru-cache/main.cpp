@@ -1,14 +1,41 @@
+#include "BenchmarkHarness.h"
+#include "ConcurrentLRUCache.h"
 #include "ShardedLRUCache.h"
+#include "SharedMemoryLRUCache.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <coroutine>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace {
 
 void PrintResult(const std::string& name, const bool passed) {
@@ -53,18 +80,94 @@ bool TestBasicBehavior() {
     return updated.has_value() && updated.value() == "one-updated";
 }
 
-bool TestEvictionPerShard() {
-    // One shard gives deterministic LRU behavior while still exercising sharded API.
-    ShardedLRUCache<int, int> cache(2, 1);
+template <typename Policy>
+bool TestEvictionPerShard(const int expected_victim) {
+    // One shard gives deterministic eviction while still exercising sharded API.
+    ShardedLRUCache<int, int, Policy> cache(2, 1);
     cache.Put(1, 10);
     cache.Put(2, 20);
-    (void)cache.Get(1);  // Promote key 1 to MRU.
-    cache.Put(3, 30);  // Should evict key 2.
+    (void)cache.Get(1);  // Re-reference key 1.
+    cache.Put(3, 30);  // Evicts expected_victim.
 
-    const auto one = cache.Get(1);
-    const auto two = cache.Get(2);
+    const int survivor = expected_victim == 1 ? 2 : 1;
+    const auto survivor_value = cache.Get(survivor);
+    const auto victim_value = cache.Get(expected_victim);
     const auto three = cache.Get(3);
-    return one.has_value() && !two.has_value() && three.has_value();
+    return survivor_value.has_value() && !victim_value.has_value() && three.has_value() &&
+           cache.Size() == 2;
+}
+
+template <typename Policy>
+bool TestScanResistance() {
+    // Each round touches a small hot set twice, then scans more unique keys than
+    // the cache can hold. Strict LRU loses the hot set to every scan; a
+    // scan-resistant policy keeps serving it once it has seen it reused.
+    constexpr std::size_t kCapacity = 64;
+    constexpr int kHotKeys = 16;
+    constexpr int kScanLength = 80;
+    constexpr int kRounds = 10;
+    constexpr int kWarmupRounds = 2;
+
+    ShardedLRUCache<int, int, Policy> cache(kCapacity, 1);
+    int next_scan_key = 1000;
+    int hot_hits = 0;
+
+    for (int round = 0; round < kRounds; ++round) {
+        for (int key = 0; key < kHotKeys; ++key) {
+            if (cache.Get(key).has_value()) {
+                hot_hits += round >= kWarmupRounds ? 1 : 0;
+            } else {
+                cache.Put(key, key);
+            }
+            (void)cache.Get(key);
+        }
+        for (int i = 0; i < kScanLength; ++i) {
+            const int key = next_scan_key++;
+            if (!cache.Get(key).has_value()) {
+                cache.Put(key, key);
+            }
+        }
+    }
+
+    const int measured_lookups = (kRounds - kWarmupRounds) * kHotKeys;
+    return hot_hits == measured_lookups && cache.Size() <= kCapacity;
+}
+
+bool TestShardSelection() {
+    // Power-of-two counts use a mask, others multiply-shift; both must keep
+    // every key reachable and spread sequential integers over all shards.
+    for (const std::size_t shard_count : {std::size_t{1}, std::size_t{3}, std::size_t{8}}) {
+        ShardedLRUCache<int, int> cache(1000, shard_count);
+        for (int key = 0; key < 1000; ++key) {
+            cache.Put(key, key);
+        }
+        if (cache.Size() != 1000U) {
+            return false;
+        }
+        for (int key = 0; key < 1000; ++key) {
+            if (cache.Get(key) != key) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Routes every key to shard 0.
+struct FirstShardSelector {
+    [[nodiscard]] static constexpr std::uint64_t Hash(const std::uint64_t hash) noexcept { return hash; }
+    [[nodiscard]] static constexpr std::size_t Index(std::uint64_t, std::size_t) noexcept { return 0U; }
+};
+
+bool TestCustomShardSelector() {
+    // With every key in shard 0, a 4x2 cache holds only two entries.
+    ShardedLRUCache<int, int, LruPolicy<int>, UnitWeigher, FirstShardSelector> cache(2, 4);
+    for (int key = 0; key < 4; ++key) {
+        cache.Put(key, key);
+    }
+    return cache.Size() == 2U && !cache.Get(0).has_value() && !cache.Get(1).has_value() &&
+           cache.Get(2) == 2 && cache.Get(3) == 3;
 }
 
 bool TestClearAndSize() {
@@ -81,28 +184,111 @@ bool TestClearAndSize() {
     return cache.Size() == 0 && !cache.Get(1).has_value();
 }
 
-bool TestConcurrentStress() {
-    constexpr int kThreads = 12;
-    constexpr int kOpsPerThread = 4000;
-    constexpr int kShards = 16;
-    constexpr int kCapacityPerShard = 64;
+template <typename Policy>
+bool TestGetWithVisitsInPlace() {
+    ShardedLRUCache<int, std::string, Policy> cache(4, 2);
+    cache.Put(1, std::string(1024, 'x'));
+
+    // Both visits must see the very same stored string, not a copy.
+    const std::string* first = nullptr;
+    const std::string* second = nullptr;
+    const bool hit = cache.GetWith(1, [&first](const std::string& value) { first = &value; });
+    (void)cache.GetWith(1, [&second](const std::string& value) { second = &value; });
+    const bool miss = cache.GetWith(2, [](const std::string&) {});
+
+    return hit && !miss && first != nullptr && first == second && first->size() == 1024U;
+}
+
+bool TestSharedValuesOutliveEviction() {
+    SharedValueShardedLRUCache<int, std::string> cache(1, 1);
+    cache.Put(1, std::make_shared<const std::string>(4096, 'a'));
+
+    const auto held = cache.Get(1);
+    cache.Put(2, std::make_shared<const std::string>(4096, 'b'));
+
+    // Key 1 was evicted, but the handle returned by Get still owns the value.
+    return held.has_value() && held.value()->front() == 'a' && held.value().use_count() == 1 &&
+           !cache.Get(1).has_value();
+}
+
+template <typename Policy>
+bool TestMoveAndHeterogeneousLookup() {
+    // Move-only values can only get in through the rvalue Put or Emplace.
+    ShardedLRUCache<std::string, std::unique_ptr<int>, ClockPolicy<std::string>> owners(4, 4);
+    std::string url = "https://example.com/a";
+    owners.Put(std::move(url), std::make_unique<int>(7));
+    owners.Emplace(std::string_view("https://example.com/b"), std::make_unique<int>(8));
 
-    ShardedLRUCache<int, int> cache(kCapacityPerShard, kShards);
+    int seen = 0;
+    const bool found = owners.GetWith(std::string_view("https://example.com/a"),
+                                      [&seen](const std::unique_ptr<int>& value) { seen = *value; });
+    if (!found || seen != 7 || !owners.Contains("https://example.com/b") ||
+        owners.Contains(std::string_view("https://example.com/c"))) {
+        return false;
+    }
+
+    ShardedLRUCache<std::string, std::string, Policy> strings(2, 1);
+    strings.Emplace("a", 3U, 'x');
+    strings.Put("b", "bee");
+    const auto a = strings.Get(std::string_view("a"));
+    if (!a.has_value() || a.value() != "xxx") {
+        return false;
+    }
+
+    // Contains is not a hit: "a" was read last, so "b" is still the victim.
+    (void)strings.Contains("b");
+    strings.Put("c", "sea");
+    return !strings.Contains("b") && strings.Contains("a") && strings.Size() == 2U;
+}
+
+template <typename Policy>
+bool TestMultiGetAndMultiPut() {
+    ShardedLRUCache<int, int, Policy> cache(16, 4);
+    std::vector<std::pair<int, int>> entries;
+    for (int key = 0; key < 32; ++key) {
+        entries.emplace_back(key, key * 10);
+    }
+    entries.emplace_back(5, 555);  // A repeated key keeps the later value.
+    cache.MultiPut(entries);
+
+    const std::vector<int> keys = {31, 5, 1000, 0, 17, 5, 2};
+    const auto results = cache.MultiGet(keys);
+    if (results.size() != keys.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        const int expected = keys[i] == 5 ? 555 : keys[i] * 10;
+        const bool should_hit = keys[i] < 32;
+        if (results[i].has_value() != should_hit || (should_hit && results[i].value() != expected)) {
+            return false;
+        }
+    }
+
+    return cache.MultiGet(std::span<const int>()).empty() && cache.Size() == 32U;
+}
+
+bool TestGetOrLoadSingleFlight() {
+    constexpr int kThreads = 8;
+
+    ShardedLRUCache<int, std::string> cache(16, 4);
+    std::atomic<int> loads{0};
     std::atomic<bool> failed{false};
+    std::latch start(kThreads);
     std::vector<std::thread> threads;
     threads.reserve(kThreads);
 
     for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
-        threads.emplace_back([thread_id, &cache, &failed]() {
-            for (int i = 0; i < kOpsPerThread; ++i) {
-                // Spread accesses across shard space while maintaining overlap.
-                const int key = ((thread_id * 131) + i) % 1024;
-                cache.Put(key, i);
-                const auto value = cache.Get(key);
-                if (!value.has_value()) {
-                    failed.store(true);
-                    return;
-                }
+        threads.emplace_back([&]() {
+            start.arrive_and_wait();
+            const std::string value = cache.GetOrLoad(42, [&loads](const int key) {
+                loads.fetch_add(1);
+                // Keep the load open long enough for every caller to pile up.
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                return "value-" + std::to_string(key);
+            });
+            if (value != "value-42") {
+                failed.store(true);
             }
         });
     }
@@ -111,56 +297,2099 @@ bool TestConcurrentStress() {
         thread.join();
     }
 
-    const std::size_t max_possible = static_cast<std::size_t>(kShards * kCapacityPerShard);
-    return !failed.load() && cache.Size() <= max_possible;
+    // A later call is a plain hit and never runs its loader.
+    const std::string cached = cache.GetOrLoad(42, [](int) -> std::string { throw std::logic_error("hit"); });
+    return !failed.load() && loads.load() == 1 && cached == "value-42";
 }
 
-void RunConcurrentBenchmark() {
-    constexpr int kThreads = 12;
-    constexpr int kOpsPerThread = 20000;
-    constexpr int kShards = 16;
-    constexpr int kCapacityPerShard = 128;
-    constexpr int kKeySpace = 4096;
+bool TestGetOrLoadPropagatesExceptions() {
+    constexpr int kThreads = 4;
 
-    ShardedLRUCache<int, int> cache(kCapacityPerShard, kShards);
+    ShardedLRUCache<int, int> cache(16, 4);
+    std::atomic<int> loads{0};
+    std::atomic<int> rethrown{0};
+    std::latch start(kThreads);
     std::vector<std::thread> threads;
     threads.reserve(kThreads);
 
+    for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
+        threads.emplace_back([&]() {
+            start.arrive_and_wait();
+            try {
+                (void)cache.GetOrLoad(7, [&loads](int) -> int {
+                    loads.fetch_add(1);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    throw std::runtime_error("backend down");
+                });
+            } catch (const std::runtime_error&) {
+                rethrown.fetch_add(1);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // The failure is not cached: the next caller loads again.
+    const int retried = cache.GetOrLoad(7, [](const int key) { return key * 3; });
+    return loads.load() == 1 && rethrown.load() == kThreads && retried == 21 && !cache.Get(8).has_value();
+}
+
+bool TestTimingWheel() {
+    // Deadlines on every level, one past the wheel's span, one already due.
+    const std::vector<std::uint64_t> deadlines = {0, 3, 64, 100, 4095, 4096, 300000, 20000000, 1ULL << 31};
+    std::vector<int> keys(deadlines.size());
+    TimingWheel<int> wheel;
+    std::vector<TimingWheel<int>::Handle> handles;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = static_cast<int>(i);
+        handles.push_back(wheel.Schedule(keys[i], deadlines[i]));
+    }
+    wheel.Cancel(handles[3]);
+
+    std::vector<std::uint64_t> expired_at(keys.size(), 0U);
+    std::uint64_t now = 0;
+    bool in_order = true;
+    const auto advance = [&](const std::uint64_t to) {
+        now = to;
+        wheel.Advance(now, [&](const int& key) {
+            const auto index = static_cast<std::size_t>(key);
+            in_order = in_order && expired_at[index] == 0U && deadlines[index] <= now;
+            expired_at[index] = now;
+        });
+    };
+
+    // Walk tick by tick through the first levels, then jump.
+    for (std::uint64_t tick = 1; tick <= 5000; ++tick) {
+        advance(tick);
+    }
+    advance(299999);
+    const bool before_far = expired_at[6] == 0U;
+    advance(1ULL << 32);
+
+    bool exact = true;
+    for (const std::size_t i : {1U, 2U, 4U, 5U}) {
+        exact = exact && expired_at[i] == deadlines[i];
+    }
+    return in_order && exact && before_far && expired_at[0] == 1U && expired_at[3] == 0U &&
+           expired_at[6] != 0U && expired_at[8] != 0U && wheel.Size() == 0U;
+}
+
+template <typename Policy>
+bool TestTtlExpiry() {
+    using namespace std::chrono_literals;
+
+    ShardedLRUCache<int, std::string, Policy> cache(8, 2);
+    cache.Put(1, "short", 30ms);
+    cache.Put(2, "forever");
+    cache.Put(3, "long", 10s);
+    if (!cache.Get(1).has_value() || !cache.Contains(1)) {
+        return false;
+    }
+
+    std::this_thread::sleep_for(60ms);
+    const bool expired_reads_miss = !cache.Get(1).has_value() && !cache.Contains(1) &&
+                                    !cache.GetWith(1, [](const std::string&) {});
+    const bool others_live = cache.Get(2) == "forever" && cache.Get(3) == "long";
+
+    // Re-putting restores the key, and a TTL-less update clears its deadline.
+    cache.Put(1, "again", 30ms);
+    cache.Put(1, "pinned");
+    std::this_thread::sleep_for(60ms);
+    return expired_reads_miss && others_live && cache.Get(1) == "pinned";
+}
+
+bool TestDefaultTtlReclaimsOnPut() {
+    using namespace std::chrono_literals;
+
+    ShardedLRUCache<int, int> cache(64, 1, 30ms);
+    for (int key = 0; key < 32; ++key) {
+        cache.Put(key, key);
+    }
+    std::this_thread::sleep_for(60ms);
+
+    // The next insert reclaims everything that expired; no reads needed.
+    cache.Put(100, 100);
+    return cache.Size() == 1U && cache.Get(100) == 100;
+}
+
+struct StringBytes {
+    std::size_t operator()(const int&, const std::string& value) const noexcept {
+        return value.size();
+    }
+};
+
+bool TestWeightedEvictionOrder() {
+    try {
+        ShardedLRUCache<int, std::string, LruPolicy<int>, StringBytes> invalid(4, 1, 0);
+        (void)invalid;
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    // One shard: up to 100 entries, but only 10 bytes.
+    ShardedLRUCache<int, std::string, LruPolicy<int>, StringBytes> cache(100, 1, 10);
+    cache.Put(1, "aaaa");
+    cache.Put(2, "bbbb");
+    (void)cache.Get(1);
+    // Evicting key 2 alone frees enough room.
+    cache.Put(3, "cccccc");
+    if (cache.Contains(2) || !cache.Contains(1) || cache.WeightedSize() != 10U) {
+        return false;
+    }
+
+    // Growing key 3 evicts key 1; an oversized value drops its key only.
+    cache.Put(3, "ccccccccc");
+    const bool grown = !cache.Contains(1) && cache.WeightedSize() == 9U;
+    cache.Put(4, "d");
+    cache.Put(4, std::string(11, 'x'));
+    return grown && !cache.Contains(4) && cache.Get(3) == "ccccccccc" && cache.WeightedSize() == 9U;
+}
+
+template <typename Policy>
+bool TestWeightedBudget() {
+    constexpr std::size_t kShards = 4;
+    constexpr std::size_t kBytesPerShard = 64;
+
+    ShardedLRUCache<int, std::string, Policy, StringBytes> cache(1000, kShards, kBytesPerShard);
+    for (int key = 0; key < 2000; ++key) {
+        cache.Put(key, std::string(1U + static_cast<std::size_t>(key * 7 % 40), 'x'));
+        if (cache.WeightedSize() > kShards * kBytesPerShard) {
+            return false;
+        }
+    }
+    cache.Put(5000, std::string(kBytesPerShard + 1U, 'y'));
+
+    // The tracked weight matches what is actually resident.
+    std::size_t resident_bytes = 0;
+    for (int key = 0; key < 2000; ++key) {
+        (void)cache.GetWith(key, [&](const std::string& value) { resident_bytes += value.size(); });
+    }
+
+    ShardedLRUCache<int, int, Policy> counted(4, 2);
+    for (int key = 0; key < 20; ++key) {
+        counted.Put(key, key);
+    }
+    return !cache.Contains(5000) && resident_bytes == cache.WeightedSize() &&
+           counted.WeightedSize() == counted.Size();
+}
+
+// Keys that a cache with `shard_count` (a power of two) shards puts in shard 0.
+std::vector<int> KeysInFirstShard(const std::size_t count, const std::size_t shard_count) {
+    std::vector<int> keys;
+    for (int key = 0; keys.size() < count; ++key) {
+        if ((MixHash(static_cast<std::uint64_t>(std::hash<int>{}(key))) & (shard_count - 1U)) == 0U) {
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+template <typename Cache>
+std::size_t HitsOnLastCycle(Cache& cache, const std::vector<int>& keys, const std::size_t total,
+                            bool& bounded) {
+    std::size_t hits = 0;
+    for (int round = 0; round < 64; ++round) {
+        hits = 0;
+        for (const int key : keys) {
+            if (cache.Get(key).has_value()) {
+                ++hits;
+            } else {
+                cache.Put(key, key);
+            }
+        }
+        bounded = bounded && cache.Size() <= total;
+    }
+    return hits;
+}
+
+bool TestAdaptiveCapacity() {
+    bool too_small_thrown = false;
+    try {
+        ShardedLRUCache<int, int> invalid(SharedCapacity{3}, 4);
+        (void)invalid;
+    } catch (const std::invalid_argument&) {
+        too_small_thrown = true;
+    }
+
+    // 250 hot keys, all in one of four shards, against 400 entries total.
+    // Static quotas give that shard 100 entries, so a cyclic scan never hits.
+    const std::vector<int> hot = KeysInFirstShard(250, 4);
+    bool bounded = true;
+    ShardedLRUCache<int, int> fixed(100, 4);
+    const std::size_t fixed_hits = HitsOnLastCycle(fixed, hot, 400U, bounded);
+    ShardedLRUCache<int, int> adaptive(SharedCapacity{400}, 4);
+    const std::size_t adaptive_hits = HitsOnLastCycle(adaptive, hot, 400U, bounded);
+
+    return too_small_thrown && bounded && fixed_hits == 0U && adaptive_hits == hot.size();
+}
+
+bool TestAdaptiveCapacityUnderConcurrency() {
+    constexpr std::size_t kTotal = 512;
+    constexpr int kThreads = 4;
+
+    ShardedLRUCache<int, int, ClockPolicy<int>> cache(SharedCapacity{kTotal}, 8);
+    std::atomic<bool> done{false};
+    std::atomic<bool> bounded{true};
+    std::thread observer([&] {
+        while (!done.load()) {
+            if (cache.Size() > kTotal) {
+                bounded = false;
+            }
+        }
+    });
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&cache, t] {
+            std::mt19937 random(static_cast<std::uint32_t>(t));
+            // Skewed keys: most traffic lands on a few shards at a time.
+            std::geometric_distribution<int> distribution(0.002);
+            for (int i = 0; i < 40000; ++i) {
+                const int key = distribution(random);
+                if (!cache.Get(key).has_value()) {
+                    cache.Put(key, key);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    done = true;
+    observer.join();
+
+    return bounded.load() && cache.Size() <= kTotal;
+}
+
+bool TestAdaptiveListenerReenters() {
+    // Quota shrinks evict; a sync listener that reads the cache back must
+    // not deadlock against the rebalance.
+    using Event = RemovalEvent<int, int>;
+    ShardedLRUCache<int, int> cache(SharedCapacity{400}, 4);
+    std::size_t capacity_events = 0;
+    bool bounded = true;
+    cache.SetRemovalListener(
+        [&](const std::span<Event> batch) {
+            for (const Event& event : batch) {
+                capacity_events += event.cause == RemovalCause::kCapacity ? 1U : 0U;
+            }
+            bounded = bounded && cache.Size() <= 400U;
+        },
+        RemovalDelivery::kSync);
+    // Every shard starts full, so lending quota to shard 0 must evict.
+    for (int key = 1000; key < 1400; ++key) {
+        cache.Put(key, key);
+    }
+    const std::vector<int> hot = KeysInFirstShard(250, 4);
+    const std::size_t hits = HitsOnLastCycle(cache, hot, 400U, bounded);
+
+    return bounded && hits == hot.size() && capacity_events > 0U;
+}
+
+bool TestFrontCacheSeesWrites() {
+    ShardedLRUCache<int, std::string> cache(2, 1);
+    cache.EnableFrontCache();
+    cache.Put(1, "one");
+    cache.Put(2, "two");
+    // The second read is served from this thread's front cache.
+    if (cache.Get(1) != "one" || cache.Get(1) != "one") {
+        return false;
+    }
+
+    cache.Put(1, "uno");
+    if (cache.Get(1) != "uno") {
+        return false;
+    }
+
+    // A write from another thread, and an eviction, invalidate the copy too.
+    std::thread([&cache] { cache.Put(1, "eins"); }).join();
+    const bool remote_write_seen = cache.Get(1) == "eins";
+    cache.Put(3, "three");  // Evicts key 2, the least recently used.
+    (void)cache.Get(2);
+    const bool eviction_seen = !cache.Get(2).has_value();
+
+    // Entries with a TTL are not copied, so they still expire on time.
+    using namespace std::chrono_literals;
+    cache.Put(4, "four", 30ms);
+    const bool ttl_hit = cache.Get(4) == "four" && cache.Get(4) == "four";
+    std::this_thread::sleep_for(60ms);
+    return remote_write_seen && eviction_seen && ttl_hit && !cache.Get(4).has_value();
+}
+
+template <typename Policy>
+bool TestFrontCacheNeverStale() {
+    // A writer publishes each version only after Put returns; readers must
+    // never see an older value than the last one published.
+    constexpr int kWrites = 20000;
+    constexpr int kReaders = 3;
+
+    ShardedLRUCache<int, int, Policy> cache(64, 4);
+    cache.EnableFrontCache();
+    cache.Put(0, 0);
+    std::atomic<int> published{0};
+    std::atomic<bool> stale{false};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r) {
+        readers.emplace_back([&] {
+            while (published.load(std::memory_order_acquire) < kWrites) {
+                const int floor = published.load(std::memory_order_acquire);
+                const std::optional<int> value = cache.Get(0);
+                if (!value.has_value() || *value < floor) {
+                    stale = true;
+                }
+                // Keys in other shards keep the shared path busy as well.
+                (void)cache.Get(floor % 256);
+            }
+        });
+    }
+    for (int version = 1; version <= kWrites; ++version) {
+        cache.Put(0, version);
+        cache.Put(version % 256 + 1, version);
+        published.store(version, std::memory_order_release);
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    return !stale.load() && cache.Get(0) == kWrites;
+}
+
+bool TestResize() {
+    ShardedLRUCache<int, int> cache(8, 2);
+    for (int key = 0; key < 16; ++key) {
+        cache.Put(key, key);
+    }
+    cache.Resize(3);
+    const bool shrunk = cache.Size() == 6U;
+    cache.Resize(8);
+    for (int key = 16; key < 32; ++key) {
+        cache.Put(key, key);
+    }
+    const bool grown = cache.Size() == 16U;
+
+    bool zero_thrown = false;
+    try {
+        cache.Resize(0);
+    } catch (const std::invalid_argument&) {
+        zero_thrown = true;
+    }
+    bool adaptive_thrown = false;
+    ShardedLRUCache<int, int> adaptive(SharedCapacity{64}, 4);
+    try {
+        adaptive.Resize(32);
+    } catch (const std::logic_error&) {
+        adaptive_thrown = true;
+    }
+    return shrunk && grown && zero_thrown && adaptive_thrown;
+}
+
+std::string SnapshotTestPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("sharded_lru_cache_" + name + ".snapshot")).string();
+}
+
+// The TTL `key` has left, as SaveSnapshot records it (zero: none), or -1 if
+// the cache does not hold it.
+template <typename Cache>
+std::int64_t RemainingTtlMs(Cache& cache, const int key) {
+    const std::string path = SnapshotTestPath("remaining_ttl");
+    (void)cache.SaveSnapshot(path);
+    std::int64_t remaining = -1;
+    {
+        const SnapshotFile file(path);
+        for (const SnapshotFile::Section& section : file.Sections()) {
+            SnapshotReader in(section.bytes);
+            while (!in.AtEnd()) {
+                const std::int64_t ttl = ReadSnapshotTtl(in);
+                const int entry = SnapshotCodec<int>::Decode(in);
+                (void)SnapshotCodec<int>::Decode(in);
+                remaining = entry == key ? ttl : remaining;
+            }
+        }
+    }
+    std::filesystem::remove(path);
+    return remaining;
+}
+
+template <typename Policy>
+bool TestReshardKeepsEntries() {
+    // Capacity is large enough that nothing is evicted, so every key must
+    // stay readable, with its latest value, while the shards change.
+    constexpr int kKeys = 4000;
+    constexpr int kUpdated = 1000;
+    constexpr int kAdded = 2000;
+    constexpr int kOffset = 1000000;
+
+    ShardedLRUCache<int, int, Policy> cache(8192, 16);
+    for (int key = 0; key < kKeys; ++key) {
+        cache.Put(key, key);
+    }
+    // The TTL is far longer than the test, so the check below reads the
+    // moved deadline instead of waiting for it.
+    using namespace std::chrono_literals;
+    cache.Put(-1, -1, 30s);
+    const auto ttl_start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(50ms);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> updated{0};
+    std::atomic<bool> lost{false};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r] {
+            std::mt19937 random(static_cast<std::uint32_t>(r));
+            std::uniform_int_distribution<int> distribution(0, kKeys - 1);
+            while (!done.load()) {
+                const int floor = updated.load(std::memory_order_acquire);
+                const int key = distribution(random);
+                const std::optional<int> value = cache.Get(key);
+                const int expected = key < floor ? key + kOffset : key;
+                if (!value.has_value() || (*value != expected && *value != key + kOffset) ||
+                    !cache.Contains(key)) {
+                    lost = true;
+                }
+                const std::vector<int> batch{key, (key + 1) % kKeys, (key + 2) % kKeys};
+                for (const std::optional<int>& hit : cache.MultiGet(batch)) {
+                    if (!hit.has_value()) {
+                        lost = true;
+                    }
+                }
+            }
+        });
+    }
+    std::thread writer([&] {
+        for (int key = 0; key < kUpdated; ++key) {
+            cache.Put(key, key + kOffset);
+            updated.store(key + 1, std::memory_order_release);
+            cache.Put(kKeys + key * 2, key);
+            cache.Put(kKeys + key * 2 + 1, key);
+        }
+    });
+
+    for (const std::size_t shard_count : {5U, 32U, 1U, 16U}) {
+        cache.Reshard(shard_count);
+    }
+    writer.join();
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    bool all_present = cache.Size() == static_cast<std::size_t>(kKeys + kAdded + 1);
+    for (int key = 0; key < kKeys + kAdded; ++key) {
+        const int expected = key < kUpdated ? key + kOffset : key < kKeys ? key : (key - kKeys) / 2;
+        all_present = all_present && cache.Get(key) == expected;
+    }
+    // The moved entry kept its deadline: at least the 50 ms slept have run
+    // off it, which a deadline restarted by the migration would not show.
+    const auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ttl_start);
+    const std::int64_t remaining = RemainingTtlMs(cache, -1);
+    const bool ttl_kept = cache.Get(-1) == -1 && remaining > 0 && remaining <= (30s - elapsed + 20ms).count();
+    return !lost.load() && all_present && ttl_kept;
+}
+
+bool TestReshardKeepsLayoutsInUse() {
+    // A load registered on the first layout outlives three Reshards, which
+    // free the layouts between; the first must stay until the load is done.
+    ShardedLRUCache<int, int> cache(1024, 4);
+    for (int key = 0; key < 1000; ++key) {
+        cache.Put(key, key);
+    }
+    std::atomic<bool> loading{false};
+    std::atomic<bool> release{false};
+    int loaded = 0;
+    std::thread loader([&] {
+        loaded = cache.GetOrLoad(5000, [&](const int key) {
+            loading = true;
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            return key + 1;
+        });
+    });
+    while (!loading.load()) {
+        std::this_thread::yield();
+    }
+    for (const std::size_t shard_count : {8U, 2U, 16U, 4U}) {
+        cache.Reshard(shard_count);
+    }
+    release = true;
+    loader.join();
+    // Once the load is done the first layout is freed too.
+    cache.Reshard(8);
+
+    bool all_present = loaded == 5001 && cache.Get(5000) == 5001;
+    for (int key = 0; key < 1000; ++key) {
+        all_present = all_present && cache.Get(key) == key;
+    }
+    return all_present;
+}
+
+bool TestReshardPauseIsBounded() {
+    // Migration holds a lock for one batch at a time, so a reader never
+    // waits anywhere near as long as the whole migration takes.
+    constexpr int kKeys = 100000;
+
+    ShardedLRUCache<int, int> cache(8192, 16);
+    for (int key = 0; key < kKeys; ++key) {
+        cache.Put(key, key);
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<std::int64_t> worst_us{0};
+    std::atomic<std::uint64_t> reads{0};
+    std::thread reader([&] {
+        std::uint32_t key = 0;
+        while (!done.load()) {
+            const auto start = std::chrono::steady_clock::now();
+            (void)cache.Get(static_cast<int>(key++ % kKeys));
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            const std::int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            if (us > worst_us.load()) {
+                worst_us = us;
+            }
+            reads.fetch_add(1U);
+        }
+    });
+
     const auto start = std::chrono::steady_clock::now();
+    cache.Reshard(64);
+    const auto migration = std::chrono::steady_clock::now() - start;
+    done = true;
+    reader.join();
+
+    std::cout << "[INFO] Reshard 16 -> 64 shards, " << kKeys << " entries: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(migration).count()
+              << " ms total, worst Get " << worst_us.load() << " us over " << reads.load() << " reads\n";
+    return cache.Size() == static_cast<std::size_t>(kKeys) && reads.load() > 0U &&
+           worst_us.load() < 50000;
+}
+
+bool TestConcurrentCacheBasics() {
+    bool zero_capacity_thrown = false;
+    try {
+        ConcurrentLRUCache<int, int> invalid(0);
+        (void)invalid;
+    } catch (const std::invalid_argument&) {
+        zero_capacity_thrown = true;
+    }
+
+    ConcurrentLRUCache<int, int> cache(4);
+    for (int key = 1; key <= 4; ++key) {
+        cache.Put(key, key * 10);
+    }
+    cache.Put(2, 25);
+    const bool basic = cache.Get(1) == 10 && cache.Get(2) == 25 && cache.Contains(4) &&
+                       !cache.Get(9).has_value() && cache.Size() == 4U;
+
+    // Every fresh entry starts referenced, so the hand clears bits before it
+    // evicts; exactly four keys survive either way.
+    for (int key = 5; key <= 8; ++key) {
+        cache.Put(key, key * 10);
+    }
+    int resident = 0;
+    for (int key = 1; key <= 8; ++key) {
+        resident += cache.Contains(key) ? 1 : 0;
+    }
+    const bool bounded = cache.Size() == 4U && resident == 4;
+
+    ConcurrentLRUCache<std::string, std::string> strings(8);
+    strings.Emplace(std::string("alpha"), 3U, 'a');
+    const bool heterogeneous = strings.Get(std::string_view("alpha")) == "aaa" && strings.Contains("alpha");
+
+    cache.Clear();
+    const bool cleared = cache.Size() == 0U && !cache.Get(5).has_value() && !cache.Contains(6);
+    return zero_capacity_thrown && basic && bounded && heterogeneous && cleared;
+}
+
+bool TestConcurrentCacheStress() {
+    // Same pattern as TestConcurrentStress: with capacity above the key space
+    // nothing is evicted, so every read after a thread's own Put must hit.
+    constexpr int kThreads = 12;
+    constexpr int kOpsPerThread = 4000;
+    constexpr std::size_t kCapacity = 2048;
+
+    ConcurrentLRUCache<int, int> cache(kCapacity);
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
     for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
-        threads.emplace_back([thread_id, &cache]() {
+        threads.emplace_back([thread_id, &cache, &failed]() {
             for (int i = 0; i < kOpsPerThread; ++i) {
-                const int key = ((thread_id * 257) + i) % kKeySpace;
+                const int key = ((thread_id * 131) + i) % 1024;
                 cache.Put(key, i);
-                (void)cache.Get(key);
+                if (!cache.Get(key).has_value()) {
+                    failed.store(true);
+                    return;
+                }
             }
         });
     }
-
     for (auto& thread : threads) {
         thread.join();
     }
-    const auto end = std::chrono::steady_clock::now();
-
-    const auto elapsed_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    const double elapsed_s = static_cast<double>(elapsed_ms) / 1000.0;
-    const double total_operations = static_cast<double>(kThreads) * kOpsPerThread * 2.0;
-    const double ops_per_second = elapsed_s > 0.0 ? total_operations / elapsed_s : 0.0;
 
-    std::cout << "[INFO] Benchmark: " << static_cast<long long>(total_operations)
-              << " operations in " << elapsed_ms << " ms ("
-              << std::fixed << std::setprecision(2) << ops_per_second << " ops/s)\n";
+    return !failed.load() && cache.Size() <= kCapacity;
 }
 
-}  // namespace
+bool TestConcurrentCacheReadsUnderEviction() {
+    // 64 threads on a cache far smaller than the key space: readers must only
+    // ever see complete values while writers replace and evict nodes under
+    // them. Heap-allocated values make a premature free visible to sanitizers.
+    constexpr int kReaders = 48;
+    constexpr int kWriters = 16;
+    constexpr int kOpsPerThread = 3000;
+    constexpr int kKeySpace = 1024;
+    constexpr std::size_t kCapacity = 128;
+
+    ConcurrentLRUCache<int, std::string> cache(kCapacity);
+    for (int key = 0; key < kKeySpace; ++key) {
+        cache.Put(key, "value-" + std::to_string(key));
+    }
+    std::atomic<bool> failed{false};
+    std::atomic<int> hits{0};
+    std::vector<std::thread> threads;
+    for (int reader = 0; reader < kReaders; ++reader) {
+        threads.emplace_back([reader, &cache, &failed, &hits]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = ((reader * 37) + i) % kKeySpace;
+                cache.GetWith(key, [&](const std::string& value) {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    if (value != "value-" + std::to_string(key)) {
+                        failed.store(true);
+                    }
+                });
+            }
+        });
+    }
+    for (int writer = 0; writer < kWriters; ++writer) {
+        threads.emplace_back([writer, &cache]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = ((writer * 101) + (i * 7)) % kKeySpace;
+                cache.Put(key, "value-" + std::to_string(key));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return !failed.load() && hits.load() > 0 && cache.Size() <= kCapacity;
+}
+
+bool TestFrequencySketch() {
+    FrequencySketch<int> sketch(64);
+    for (int i = 0; i < 20; ++i) {
+        sketch.Increment(7);
+    }
+    if (sketch.Estimate(7) != 15U || sketch.Estimate(8) != 0U) {
+        return false;
+    }
+
+    // 10 * capacity increments trigger aging, which halves every counter.
+    for (int key = 1000; key < 1640; ++key) {
+        sketch.Increment(key);
+    }
+    const auto aged = sketch.Estimate(7);
+    sketch.Clear();
+    return aged < 15U && aged >= 7U && sketch.Estimate(7) == 0U;
+}
+
+bool TestTinyLfuRejectsOneHitWonders() {
+    constexpr std::size_t kCapacity = 100;
+    constexpr int kFrequentKeys = 50;
+
+    ShardedLRUCache<int, int, TinyLfuPolicy<int>> cache(kCapacity, 1);
+    for (int round = 0; round < 5; ++round) {
+        for (int key = 0; key < kFrequentKeys; ++key) {
+            if (!cache.Get(key).has_value()) {
+                cache.Put(key, key);
+            }
+        }
+    }
+
+    for (int key = 10000; key < 11000; ++key) {
+        cache.Put(key, key);
+    }
+
+    int retained = 0;
+    for (int key = 0; key < kFrequentKeys; ++key) {
+        retained += cache.Get(key).has_value() ? 1 : 0;
+    }
+    return retained >= kFrequentKeys - 2 && cache.Size() == kCapacity;
+}
+
+template <typename Policy>
+bool TestSharedReads() {
+    // Readers only record hits under a shared lock while writers keep
+    // inserting and evicting; every hit must still observe a consistent value.
+    constexpr int kReaders = 8;
+    constexpr int kWriters = 2;
+    constexpr int kOpsPerThread = 20000;
+    constexpr int kKeySpace = 512;
+
+    ShardedLRUCache<int, int, Policy> cache(32, 4);
+    for (int key = 0; key < kKeySpace; ++key) {
+        cache.Put(key, key * 2);
+    }
+
+    std::atomic<bool> failed{false};
+    std::atomic<int> hits{0};
+    std::vector<std::thread> threads;
+    threads.reserve(kReaders + kWriters);
+
+    for (int reader = 0; reader < kReaders; ++reader) {
+        threads.emplace_back([reader, &cache, &failed, &hits]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = ((reader * 37) + i) % kKeySpace;
+                const auto value = cache.Get(key);
+                if (value.has_value()) {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    if (value.value() != key * 2) {
+                        failed.store(true);
+                    }
+                }
+            }
+        });
+    }
+    for (int writer = 0; writer < kWriters; ++writer) {
+        threads.emplace_back([writer, &cache]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = ((writer * 101) + (i * 7)) % kKeySpace;
+                cache.Put(key, key * 2);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return !failed.load() && hits.load() > 0 && cache.Size() <= 32U * 4U;
+}
+
+template <typename Policy>
+bool TestConcurrentStress(const bool expect_read_after_put = true) {
+    constexpr int kThreads = 12;
+    constexpr int kOpsPerThread = 4000;
+    constexpr int kShards = 16;
+    // Twice the average keys per shard: hashed shard selection does not split
+    // the 1024-key space exactly evenly, and eviction between a thread's Put
+    // and Get would make the read-after-put check flaky.
+    constexpr int kCapacityPerShard = 128;
+
+    ShardedLRUCache<int, int, Policy> cache(kCapacityPerShard, kShards);
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    threads.reserve(kThreads);
+
+    for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
+        threads.emplace_back([thread_id, expect_read_after_put, &cache, &failed]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                // Spread accesses across shard space while maintaining overlap.
+                const int key = ((thread_id * 131) + i) % 1024;
+                cache.Put(key, i);
+                const auto value = cache.Get(key);
+                if (expect_read_after_put && !value.has_value()) {
+                    failed.store(true);
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const std::size_t max_possible = static_cast<std::size_t>(kShards * kCapacityPerShard);
+    return !failed.load() && cache.Size() <= max_possible;
+}
+
+struct BenchmarkResult {
+    double ops_per_second = 0.0;
+    std::size_t resident = 0;
+};
+
+// The shard selector ShardedLRUCache used before mixed hashing: raw
+// std::hash modulo the shard count. The sweep plugs it into the same cache so
+// only shard selection differs between the two runs.
+struct ModuloShardSelector {
+    [[nodiscard]] static constexpr std::uint64_t Hash(const std::uint64_t hash) noexcept { return hash; }
+    [[nodiscard]] static constexpr std::size_t Index(const std::uint64_t hash,
+                                                     const std::size_t shard_count) noexcept {
+        return static_cast<std::size_t>(hash % shard_count);
+    }
+};
+
+using ModuloShardedCache = ShardedLRUCache<int, int, LruPolicy<int>, UnitWeigher, ModuloShardSelector>;
+
+template <typename Cache>
+BenchmarkResult RunConcurrentBenchmark(const unsigned thread_count, const int key_stride) {
+    constexpr int kOpsPerThread = 20000;
+    constexpr int kShards = 16;
+    constexpr int kCapacityPerShard = 128;
+    constexpr int kKeySpace = 4096;
+
+    Cache cache(kCapacityPerShard, kShards);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned thread_id = 0; thread_id < thread_count; ++thread_id) {
+        threads.emplace_back([thread_id, key_stride, &cache]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = (((static_cast<int>(thread_id) * 257) + i) % kKeySpace) * key_stride;
+                cache.Put(key, i);
+                (void)cache.Get(key);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const double elapsed_s = std::chrono::duration<double>(end - start).count();
+    const double total_operations = static_cast<double>(thread_count) * kOpsPerThread * 2.0;
+    return BenchmarkResult{elapsed_s > 0.0 ? total_operations / elapsed_s : 0.0, cache.Size()};
+}
+
+void RunThreadSweepBenchmark() {
+    // Sweep 1..N threads (N = max(16, hardware threads)) with the mixed-hash
+    // selector and with the old `hash % shards` one. Stride 16 keys are all
+    // multiples of the shard count, which the old selector funnels into a
+    // single shard.
+    const unsigned max_threads = std::max(16U, std::thread::hardware_concurrency());
+    for (const int key_stride : {1, 16}) {
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2U) {
+            const BenchmarkResult mixed =
+                RunConcurrentBenchmark<ShardedLRUCache<int, int>>(threads, key_stride);
+            const BenchmarkResult modulo = RunConcurrentBenchmark<ModuloShardedCache>(threads, key_stride);
+            std::cout << "[INFO] Benchmark: key stride " << std::setw(2) << key_stride << ", "
+                      << std::setw(2) << threads << " threads, " << std::fixed << std::setprecision(2)
+                      << "mixed hash " << mixed.ops_per_second / 1e6 << " M ops/s (" << mixed.resident
+                      << " resident), hash % shards " << modulo.ops_per_second / 1e6 << " M ops/s ("
+                      << modulo.resident << " resident)\n";
+        }
+    }
+}
+
+void RunBatchBenchmark() {
+    // One thread looks up batches of 128 keys spread over all shards, first
+    // key by key and then through MultiGet.
+    constexpr int kShards = 16;
+    constexpr int kKeySpace = 1 << 16;
+    constexpr std::size_t kBatch = 128;
+    constexpr int kBatches = 4000;
+
+    ShardedLRUCache<int, int> cache(kKeySpace / kShards, kShards);
+    for (int key = 0; key < kKeySpace; ++key) {
+        cache.Put(key, key);
+    }
+
+    std::vector<int> keys(kBatch);
+    const auto measure = [&](const bool batched) {
+        std::size_t hits = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int batch = 0; batch < kBatches; ++batch) {
+            for (std::size_t i = 0; i < kBatch; ++i) {
+                keys[i] = static_cast<int>((static_cast<std::size_t>(batch) * 7919U + i * 104729U) % kKeySpace);
+            }
+            if (batched) {
+                for (const auto& value : cache.MultiGet(keys)) {
+                    hits += value.has_value() ? 1U : 0U;
+                }
+            } else {
+                for (const int key : keys) {
+                    hits += cache.Get(key).has_value() ? 1U : 0U;
+                }
+            }
+        }
+        const double elapsed_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::make_pair(static_cast<double>(kBatches) * kBatch / elapsed_s, hits);
+    };
+
+    const auto single = measure(false);
+    const auto batched = measure(true);
+    std::cout << "[INFO] Benchmark: batches of " << kBatch << " keys, Get loop " << std::fixed
+              << std::setprecision(2) << single.first / 1e6 << " M keys/s, MultiGet "
+              << batched.first / 1e6 << " M keys/s (" << single.second << '/' << batched.second
+              << " hits)\n";
+}
+
+void RunFrontCacheBenchmark() {
+    // Threads repeatedly read the same 256 hot keys, with and without the
+    // per-thread front cache.
+    constexpr int kShards = 16;
+    constexpr int kHotKeys = 256;
+    constexpr int kReadsPerThread = 400000;
+    const unsigned thread_count = std::max(2U, std::min(8U, std::thread::hardware_concurrency()));
+
+    const auto measure = [&](const bool front_cache) {
+        ShardedLRUCache<int, int> cache(1024, kShards);
+        for (int key = 0; key < kHotKeys; ++key) {
+            cache.Put(key, key);
+        }
+        cache.EnableFrontCache(front_cache);
+
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned thread_id = 0; thread_id < thread_count; ++thread_id) {
+            threads.emplace_back([&, thread_id] {
+                for (int i = 0; i < kReadsPerThread; ++i) {
+                    (void)cache.Get((i * 31 + static_cast<int>(thread_id)) % kHotKeys);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const double elapsed_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(thread_count) * kReadsPerThread / elapsed_s;
+    };
+
+    const double shared = measure(false);
+    const double front = measure(true);
+    std::cout << "[INFO] Benchmark: " << thread_count << " threads on " << kHotKeys
+              << " hot keys, shard path " << std::fixed << std::setprecision(2) << shared / 1e6
+              << " M ops/s, front cache " << front / 1e6 << " M ops/s\n";
+}
+
+bool TestStatsCountOperations() {
+    if constexpr (!kCacheMetricsEnabled) {
+        return true;
+    }
+
+    // One shard of two entries, so every count below is exact.
+    ShardedLRUCache<int, int> cache(2, 1);
+    cache.EnableLatencySampling(1);
+    cache.Put(1, 10);
+    cache.Put(2, 20);
+    cache.Put(3, 30);
+    (void)cache.Get(1);
+    (void)cache.Get(2);
+    (void)cache.Contains(3);
+    const std::vector<int> keys{2, 3, 4};
+    (void)cache.MultiGet(keys);
+    const std::vector<std::pair<int, int>> entries{{5, 50}};
+    cache.MultiPut(entries);
+
+    const CacheStats stats = cache.Stats();
+    const ShardStats& total = stats.total;
+    if (stats.shards.size() != 1U || total.hits != 3U || total.misses != 2U || total.puts != 4U ||
+        total.evictions != 2U || total.HitRatio() != 0.6) {
+        return false;
+    }
+    // Batched calls are not timed.
+    if (stats.get_latency.count != 2U || stats.put_latency.count != 3U) {
+        return false;
+    }
+
+    // Front-cache hits reach the shard counter in batches: at most one
+    // refresh interval (63 hits) is still pending.
+    ShardedLRUCache<int, int> front(8, 2);
+    front.EnableFrontCache();
+    front.Put(7, 70);
+    for (int i = 0; i < 100; ++i) {
+        (void)front.Get(7);
+    }
+    const std::uint64_t front_hits = front.Stats().total.hits;
+    return front_hits <= 100U && front_hits + 63U >= 100U;
+}
+
+bool TestLatencyHistogram() {
+    LatencyHistogram histogram;
+    for (int nanoseconds = 1; nanoseconds <= 1000; ++nanoseconds) {
+        histogram.Record(std::chrono::nanoseconds(nanoseconds));
+    }
+    histogram.Record(std::chrono::hours(1));
+
+    // Reported values are bucket upper bounds, at most 1/16 above the truth.
+    const LatencySnapshot snapshot = histogram.Snapshot();
+    const auto within = [](const std::chrono::nanoseconds reported, const std::int64_t expected) {
+        return reported.count() >= expected && reported.count() <= expected + expected / 16;
+    };
+    if (snapshot.count != 1001U || !within(snapshot.Percentile(50.0), 501) ||
+        !within(snapshot.Percentile(99.0), 991) || snapshot.Percentile(0.0).count() != 1) {
+        return false;
+    }
+
+    // Bucket bounds are contiguous and increasing.
+    for (std::size_t bucket = 1; bucket < LatencyHistogram::kBucketCount; ++bucket) {
+        const std::uint64_t lower = LatencyHistogram::UpperBound(bucket - 1U) + 1U;
+        if (LatencyHistogram::BucketOf(lower) != bucket ||
+            LatencyHistogram::BucketOf(LatencyHistogram::UpperBound(bucket)) != bucket) {
+            return false;
+        }
+    }
+    return LatencyHistogram::BucketOf(std::numeric_limits<std::uint64_t>::max()) ==
+           LatencyHistogram::kBucketCount - 1U;
+}
+
+bool TestStatsUnderConcurrency() {
+    if constexpr (!kCacheMetricsEnabled) {
+        return true;
+    }
+
+    // Relaxed counters lose nothing: hits plus misses equal the lookups made,
+    // while Stats() runs alongside the traffic.
+    constexpr int kThreads = 8;
+    constexpr int kOpsPerThread = 5000;
+    ShardedLRUCache<int, int> cache(64, 2);
+    cache.EnableLatencySampling(16);
+    std::atomic<bool> done{false};
+    std::thread reader([&cache, &done]() {
+        while (!done.load()) {
+            (void)cache.Stats();
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
+        threads.emplace_back([thread_id, &cache]() {
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                const int key = (thread_id * 53 + i) % 256;
+                if (i % 4 == 0) {
+                    cache.Put(key, i);
+                } else {
+                    (void)cache.Get(key);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    done.store(true);
+    reader.join();
+
+    const CacheStats stats = cache.Stats();
+    constexpr std::uint64_t kPuts = kThreads * kOpsPerThread / 4;
+    constexpr std::uint64_t kGets = kThreads * kOpsPerThread - kPuts;
+    return stats.total.puts == kPuts && stats.total.hits + stats.total.misses == kGets &&
+           stats.total.evictions > 0U && stats.get_latency.count > 0U &&
+           stats.total.lock_wait.count() >= 0;
+}
+
+bool TestWorkloadDistributions() {
+    constexpr int kSamples = 200000;
+    WorkloadSpec spec;
+    spec.key_space = 1000;
+    spec.read_ratio = 0.75;
+
+    // Zipfian: rank 0 is drawn with probability 1 / zeta(n, theta).
+    spec.distribution = KeyDistribution::kZipfian;
+    const Workload zipfian(spec);
+    WorkloadGenerator zipfian_keys(zipfian, 0, 1, 7);
+    double zeta = 0.0;
+    for (int rank = 1; rank <= 1000; ++rank) {
+        zeta += 1.0 / std::pow(rank, spec.zipf_theta);
+    }
+    int top_key = 0;
+    int reads = 0;
+    for (int i = 0; i < kSamples; ++i) {
+        const Operation operation = zipfian_keys.Next();
+        top_key += operation.key == 0U ? 1 : 0;
+        reads += operation.write ? 0 : 1;
+        if (operation.key >= spec.key_space) {
+            return false;
+        }
+    }
+    const double top_share = static_cast<double>(top_key) / kSamples;
+    if (std::abs(top_share - 1.0 / zeta) > 0.1 / zeta ||
+        std::abs(static_cast<double>(reads) / kSamples - 0.75) > 0.01) {
+        return false;
+    }
+
+    // Hotspot: 80% of accesses land on the first 20% of keys.
+    spec.distribution = KeyDistribution::kHotspot;
+    const Workload hotspot(spec);
+    WorkloadGenerator hotspot_keys(hotspot, 0, 1, 7);
+    int hot = 0;
+    for (int i = 0; i < kSamples; ++i) {
+        hot += hotspot_keys.Next().key < 200U ? 1 : 0;
+    }
+    if (std::abs(static_cast<double>(hot) / kSamples - 0.8) > 0.01) {
+        return false;
+    }
+
+    // Scan: the second of two threads starts halfway and wraps around.
+    spec.distribution = KeyDistribution::kScan;
+    const Workload scan(spec);
+    WorkloadGenerator scan_keys(scan, 1, 2, 7);
+    for (std::uint64_t i = 0; i < 1000U; ++i) {
+        if (scan_keys.Next().key != (500U + i) % 1000U) {
+            return false;
+        }
+    }
+
+    bool bad_theta_thrown = false;
+    try {
+        spec.distribution = KeyDistribution::kZipfian;
+        spec.zipf_theta = 1.0;
+        const Workload invalid(spec);
+    } catch (const std::invalid_argument&) {
+        bad_theta_thrown = true;
+    }
+    return bad_theta_thrown;
+}
+
+bool TestTraceReplay() {
+    std::istringstream input("# recorded trace\n7\nGET 3\n\nput 5\nW 7\nr 9\n");
+    const std::vector<Operation> trace = ParseTrace(input);
+    if (trace.size() != 5U || trace[0].key != 7U || trace[0].write || trace[1].key != 3U ||
+        !trace[2].write || trace[2].key != 5U || !trace[3].write || trace[4].write || trace[4].key != 9U) {
+        return false;
+    }
+
+    const Workload workload(trace, "trace");
+    if (workload.Spec().key_space != 10U || std::abs(workload.Spec().read_ratio - 0.6) > 1e-9) {
+        return false;
+    }
+    // Two threads take alternate operations and wrap at the end.
+    WorkloadGenerator first(workload, 0, 2, 1);
+    WorkloadGenerator second(workload, 1, 2, 1);
+    const std::vector<std::uint64_t> expected_first{7, 5, 9, 3, 7};
+    const std::vector<std::uint64_t> expected_second{3, 7, 7, 5, 9};
+    for (std::size_t i = 0; i < expected_first.size(); ++i) {
+        if (first.Next().key != expected_first[i] || second.Next().key != expected_second[i]) {
+            return false;
+        }
+    }
+
+    int malformed = 0;
+    for (const char* const text : {"GET\n", "DELETE 4\n", "GET 4x\n", "4 5\n"}) {
+        std::istringstream bad(text);
+        try {
+            (void)ParseTrace(bad);
+        } catch (const std::runtime_error&) {
+            ++malformed;
+        }
+    }
+    return malformed == 4;
+}
+
+bool TestWorkloadHarnessJson() {
+    WorkloadSpec spec;
+    spec.distribution = KeyDistribution::kZipfian;
+    spec.key_space = 4096;
+    WorkloadRunOptions options;
+    options.threads = 4;
+    options.operations_per_thread = 5000;
+    options.warmup_operations = 2000;
+    options.latency_sample_interval = 4;
+
+    ShardedLRUCache<std::uint64_t, std::uint64_t> sharded(64, 16);
+    ConcurrentLRUCache<std::uint64_t, std::uint64_t> concurrent(1024);
+    const Workload workload(spec);
+    const std::vector<WorkloadResult> results{RunWorkload(sharded, "sharded", workload, options),
+                                              RunWorkload(concurrent, "concurrent", workload, options)};
+    for (const WorkloadResult& result : results) {
+        if (result.operations != 20000U || result.threads != 4U || result.ops_per_second <= 0.0 ||
+            result.hit_ratio <= 0.2 || result.hit_ratio > 1.0 || result.p50 > result.p99 ||
+            result.p99 > result.p999) {
+            return false;
+        }
+    }
+
+    std::ostringstream json;
+    WriteJson(json, results);
+    const std::string text = json.str();
+    return text.find("\"cache\": \"concurrent\"") != std::string::npos &&
+           text.find("\"workload\": \"zipfian(theta=0.99)\"") != std::string::npos &&
+           text.find("\"latency_ns\": {\"p50\": ") != std::string::npos && text.back() == '\n';
+}
+
+bool TestSnapshotRoundTrip() {
+    const std::string path = SnapshotTestPath("round_trip");
+    ShardedLRUCache<int, int> original(32, 4);
+    for (int key = 0; key < 200; ++key) {
+        original.Put(key, key * 3);
+    }
+    for (int key = 190; key > 150; key -= 2) {
+        (void)original.Get(key);
+    }
+    original.Put(1000, 1, std::chrono::hours(1));
+    original.Put(1001, 1, std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    const std::size_t saved = original.SaveSnapshot(path);
+    // Reloaded into the same layout, recency must match: the same later
+    // inserts evict the same keys from both caches.
+    ShardedLRUCache<int, int> same_layout(32, 4);
+    const std::size_t loaded = same_layout.LoadSnapshot(path, 2);
+    // A different shard count re-hashes every entry.
+    ShardedLRUCache<int, int> other_layout(64, 8);
+    const std::size_t reloaded = other_layout.LoadSnapshot(path);
+    std::filesystem::remove(path);
+    // Size() still counts the expired entry; the snapshot leaves it out.
+    if (saved + 1U != original.Size() || loaded != saved || reloaded != saved ||
+        same_layout.Size() != saved || other_layout.Size() != saved || !same_layout.Contains(1000) ||
+        same_layout.Contains(1001)) {
+        return false;
+    }
+
+    for (int key = 2000; key < 2060; ++key) {
+        original.Put(key, 0);
+        same_layout.Put(key, 0);
+    }
+    for (int key = 0; key < 200; ++key) {
+        const auto expected = original.Get(key);
+        if (same_layout.Get(key) != expected ||
+            (other_layout.Contains(key) && other_layout.Get(key) != std::optional<int>(key * 3))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Point {
+    std::string label;
+    std::vector<int> coordinates;
+};
+
+// Codec for a value type that is not trivially copyable.
+struct PointCodec {
+    static void Encode(const Point& point, std::string& out) {
+        SnapshotCodec<std::string>::Encode(point.label, out);
+        SnapshotCodec<std::uint32_t>::Encode(static_cast<std::uint32_t>(point.coordinates.size()), out);
+        for (const int coordinate : point.coordinates) {
+            SnapshotCodec<int>::Encode(coordinate, out);
+        }
+    }
+
+    static Point Decode(SnapshotReader& in) {
+        Point point{SnapshotCodec<std::string>::Decode(in), {}};
+        const std::uint32_t count = SnapshotCodec<std::uint32_t>::Decode(in);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            point.coordinates.push_back(SnapshotCodec<int>::Decode(in));
+        }
+        return point;
+    }
+};
+
+bool TestSnapshotCodecs() {
+    const std::string path = SnapshotTestPath("codecs");
+    ShardedLRUCache<std::string, Point> original(16, 4);
+    for (int i = 0; i < 40; ++i) {
+        original.Put("point-" + std::to_string(i), Point{std::string(i, 'x'), std::vector<int>(i % 5, i)});
+    }
+    (void)original.SaveSnapshot<SnapshotCodec<std::string>, PointCodec>(path);
+
+    ShardedLRUCache<std::string, Point> restored(16, 4);
+    if (restored.LoadSnapshot<SnapshotCodec<std::string>, PointCodec>(path) != 40U) {
+        return false;
+    }
+    for (int i = 0; i < 40; ++i) {
+        const auto point = restored.Get("point-" + std::to_string(i));
+        if (!point.has_value() || point->label != std::string(i, 'x') ||
+            point->coordinates != std::vector<int>(i % 5, i)) {
+            return false;
+        }
+    }
+
+    // Wrong types, a truncated file and a missing file are all rejected.
+    int rejected = 0;
+    ShardedLRUCache<int, int> wrong_types(16, 4);
+    try {
+        (void)wrong_types.LoadSnapshot(path);
+    } catch (const std::runtime_error&) {
+        ++rejected;
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3U);
+    try {
+        ShardedLRUCache<std::string, Point> truncated(16, 4);
+        (void)truncated.LoadSnapshot<SnapshotCodec<std::string>, PointCodec>(path);
+    } catch (const std::runtime_error&) {
+        ++rejected;
+    }
+    std::filesystem::remove(path);
+    try {
+        (void)wrong_types.LoadSnapshot(path);
+    } catch (const std::system_error&) {
+        ++rejected;
+    }
+    return rejected == 3 && wrong_types.Size() == 0U;
+}
+
+bool TestSnapshotWhileWriting() {
+    // A background save runs while writers keep changing the cache; every
+    // saved value must be one some writer stored under that key.
+    const std::string path = SnapshotTestPath("concurrent");
+    ShardedLRUCache<int, int> cache(256, 8);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> writers;
+    for (int thread_id = 0; thread_id < 4; ++thread_id) {
+        writers.emplace_back([thread_id, &cache, &done]() {
+            for (int i = 0; !done.load() || i < 2000; ++i) {
+                const int key = (thread_id * 977 + i) % 4096;
+                cache.Put(key, key * 7 + thread_id % 2);
+            }
+        });
+    }
+    std::future<std::size_t> saved = cache.SaveSnapshotAsync(path);
+    const std::size_t saved_count = saved.get();
+    done.store(true);
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    ShardedLRUCache<int, int> restored(256, 8);
+    const std::size_t loaded = restored.LoadSnapshot(path, 4);
+    std::filesystem::remove(path);
+    if (loaded != saved_count || loaded == 0U || restored.Size() > 256U * 8U) {
+        return false;
+    }
+    for (int key = 0; key < 4096; ++key) {
+        const auto value = restored.Get(key);
+        if (value.has_value() && *value != key * 7 && *value != key * 7 + 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string DiskTierTestDirectory(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("sharded_lru_cache_disk_" + name)).string();
+}
+
+bool TestDiskTierSpillAndPromote() {
+    const std::string directory = DiskTierTestDirectory("promote");
+    bool ok = true;
+    {
+        ShardedLRUCache<std::string, std::string> cache(16, 4);
+        cache.EnableDiskTier(DiskTierOptions{directory});
+        for (int key = 0; key < 1000; ++key) {
+            cache.Put("key-" + std::to_string(key), std::string(static_cast<std::size_t>(key % 50), 'v') +
+                                                        std::to_string(key));
+        }
+        cache.Put("short-lived", "gone", std::chrono::milliseconds(30));
+        for (int key = 1000; key < 1100; ++key) {
+            cache.Put("key-" + std::to_string(key), "filler");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+        // Evicted keys read through from disk and are back in memory after.
+        ok = ok && !cache.Contains(std::string_view("key-3"));
+        for (int key = 0; key < 1000; ++key) {
+            const std::string name = "key-" + std::to_string(key);
+            const std::string expected =
+                std::string(static_cast<std::size_t>(key % 50), 'v') + std::to_string(key);
+            ok = ok && cache.Get(std::string_view(name)) == expected;
+        }
+        ok = ok && cache.Contains(std::string_view("key-999")) && !cache.Get("short-lived").has_value();
+
+        const DiskTierStats stats = cache.DiskStats();
+        ok = ok && stats.appended >= 1000U && stats.promoted > 0U && stats.segments > 0U;
+        ok = ok && std::filesystem::exists(directory);
+    }
+    // Segment files go with the cache.
+    ok = ok && std::filesystem::is_empty(directory);
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+bool TestDiskTierInvalidation() {
+    const std::string directory = DiskTierTestDirectory("invalidation");
+    ShardedLRUCache<int, int> cache(8, 2);
+    cache.EnableDiskTier(DiskTierOptions{directory});
+    bool threw = false;
+    try {
+        cache.EnableDiskTier(DiskTierOptions{directory});
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+
+    for (int key = 0; key < 400; ++key) {
+        cache.Put(key, key);
+    }
+    // Overwrites of spilled keys must hide the disk copies, whether they
+    // come through Put or MultiPut.
+    std::vector<std::pair<int, int>> batch;
+    for (int key = 0; key < 400; key += 2) {
+        if (key % 4 == 0) {
+            cache.Put(key, key + 1000);
+        } else {
+            batch.emplace_back(key, key + 1000);
+        }
+    }
+    cache.MultiPut(batch);
+    std::vector<int> keys(400);
+    std::iota(keys.begin(), keys.end(), 0);
+    const auto values = cache.MultiGet(keys);
+    bool ok = threw;
+    for (int key = 0; key < 400; ++key) {
+        const int expected = key % 2 == 0 ? key + 1000 : key;
+        ok = ok && values[static_cast<std::size_t>(key)] == expected;
+    }
+
+    cache.Clear();
+    for (int key = 0; key < 400; ++key) {
+        ok = ok && !cache.Get(key).has_value();
+    }
+    ok = ok && cache.DiskStats().entries == 0U;
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+bool TestDiskTierCompactionUnderLoad() {
+    // Small segments and budget so compaction and drops run constantly,
+    // with a Reshard in the middle. Whatever a reader gets must be a value
+    // some writer stored under that key.
+    const std::string directory = DiskTierTestDirectory("compaction");
+    DiskTierOptions options{directory};
+    options.segment_bytes = 4096;
+    options.max_bytes = 32768;
+    bool ok = true;
+    {
+        ShardedLRUCache<int, int> cache(16, 4);
+        cache.EnableDiskTier(options);
+        std::atomic<bool> bad{false};
+        std::vector<std::thread> threads;
+        for (int thread_id = 0; thread_id < 4; ++thread_id) {
+            threads.emplace_back([thread_id, &cache, &bad]() {
+                for (int i = 0; i < 20000; ++i) {
+                    const int key = (thread_id * 7919 + i * 31) % 2048;
+                    if (i % 3 == 0) {
+                        cache.Put(key, key * 4 + thread_id);
+                    } else if (const auto value = cache.Get(key); value.has_value() && *value / 4 != key) {
+                        bad.store(true);
+                    }
+                }
+            });
+        }
+        cache.Reshard(8);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const DiskTierStats stats = cache.DiskStats();
+        ok = !bad.load() && stats.compactions > 0U && stats.dropped > 0U && stats.promoted > 0U;
+        // Within budget but for the active segment and one batch past it.
+        ok = ok && stats.file_bytes <= options.max_bytes + 2U * options.segment_bytes;
+        ok = ok && stats.live_bytes <= stats.file_bytes;
+    }
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+bool TestDiskTierWritesDuringAppend() {
+    // Batches are appended with no lock held. Each thread owns its keys, so
+    // after its own Put or Erase it must never read an older value back.
+    const std::string directory = DiskTierTestDirectory("append");
+    bool ok = true;
+    {
+        ShardedLRUCache<int, int> cache(16, 2);
+        cache.EnableDiskTier(DiskTierOptions{directory});
+        std::atomic<bool> bad{false};
+        std::vector<std::thread> threads;
+        for (int thread_id = 0; thread_id < 4; ++thread_id) {
+            threads.emplace_back([thread_id, &cache, &bad]() {
+                std::vector<int> latest(251, -1);
+                for (int i = 0; i < 20000; ++i) {
+                    const std::size_t slot = static_cast<std::size_t>(i * 37) % latest.size();
+                    const int key = static_cast<int>(slot) * 4 + thread_id;
+                    if (i % 5 == 0) {
+                        cache.Erase(key);
+                        latest[slot] = -1;
+                    } else if (i % 2 == 0) {
+                        cache.Put(key, i);
+                        latest[slot] = i;
+                    } else if (const auto value = cache.Get(key);
+                               value.has_value() && *value != latest[slot]) {
+                        bad.store(true);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ok = !bad.load() && cache.DiskStats().promoted > 0U;
+    }
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+std::string SharedCacheTestName(const std::string& name) {
+    return "/sharded_lru_cache_" + name + "_" + std::to_string(::getpid());
+}
+
+// Forks a process that runs `child` and exits with status 0 if it returns
+// true.
+template <typename Child>
+pid_t ForkChild(Child child) {
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+        bool ok = false;
+        try {
+            ok = child();
+        } catch (...) {
+        }
+        std::_Exit(ok ? 0 : 1);
+    }
+    return pid;
+}
+
+bool ChildSucceeded(const pid_t pid) {
+    int status = 0;
+    return pid > 0 && ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool TestSharedMemoryAcrossProcesses() {
+    using SharedCache = SharedMemoryLRUCache<std::uint64_t, std::uint64_t>;
+    const std::string name = SharedCacheTestName("shared");
+    (void)SharedCache::Remove(name);
+    SharedCache cache(name, 64, 4);
+    const auto increment = [](const std::optional<std::uint64_t>& count) { return count.value_or(0U) + 1U; };
+
+    // The child attaches, fills keys and bumps a counter while the parent
+    // bumps the same counter; the parent must then see all of it.
+    const pid_t child = ForkChild([&name, &increment] {
+        SharedCache attached(name, 64, 4);
+        for (std::uint64_t key = 0; key < 100; ++key) {
+            attached.Put(key, key * 3U);
+        }
+        for (int i = 0; i < 500; ++i) {
+            (void)attached.Update(1000U, increment);
+        }
+        return true;
+    });
+    for (int i = 0; i < 500; ++i) {
+        (void)cache.Update(1000U, increment);
+    }
+    bool ok = ChildSucceeded(child);
+    for (std::uint64_t key = 0; key < 100; ++key) {
+        ok = ok && cache.Get(key) == key * 3U;
+    }
+    ok = ok && cache.Get(1000U) == 1000U && cache.Size() == 101U;
+
+    // Past capacity, each shard evicts its least recently used entries.
+    for (std::uint64_t key = 2000; key < 3000; ++key) {
+        cache.Put(key, key);
+    }
+    const SharedCacheStats stats = cache.Stats();
+    ok = ok && stats.evictions > 0U && stats.hits >= 101U && cache.Size() <= 256U;
+    ok = ok && cache.Get(2999U) == 2999U && cache.Erase(2999U) && !cache.Contains(2999U);
+
+    // Other sizes or types cannot attach to the same region.
+    const auto rejected = [](const auto& attach) {
+        try {
+            attach();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    ok = ok && rejected([&name] { SharedCache other(name, 32, 4); });
+    ok = ok && rejected([&name] { SharedMemoryLRUCache<std::uint64_t, std::uint32_t> other(name, 64, 4); });
+    ok = ok && SharedCache::Remove(name) && !SharedCache::Remove(name);
+    return ok;
+}
+
+bool TestSharedMemoryRecoversDeadLockOwner() {
+    // A process dies inside Update, holding a shard lock; the next process
+    // to lock that shard takes it over without losing the entries.
+    using SharedCache = SharedMemoryLRUCache<std::uint64_t, std::uint64_t>;
+    const std::string name = SharedCacheTestName("recovery");
+    (void)SharedCache::Remove(name);
+    SharedCache cache(name, 16, 2);
+    for (std::uint64_t key = 0; key < 20; ++key) {
+        cache.Put(key, key + 100U);
+    }
+
+    const pid_t child = ForkChild([&name] {
+        SharedCache attached(name, 16, 2);
+        const auto die = [](const std::optional<std::uint64_t>&) -> std::uint64_t { std::_Exit(0); };
+        (void)attached.Update(7U, die);
+        return false;
+    });
+    bool ok = ChildSucceeded(child);
+    for (std::uint64_t key = 0; key < 20; ++key) {
+        ok = ok && cache.Get(key) == key + 100U;
+    }
+    cache.Put(7U, 1U);
+    ok = ok && cache.Get(7U) == 1U && cache.Stats().recoveries == 1U;
+    (void)SharedCache::Remove(name);
+    return ok;
+}
+
+bool TestRemovalCausesSync() {
+    // The single-threaded cache reports through its handler, inline.
+    std::vector<std::tuple<int, std::string, RemovalCause>> handled;
+    LRUCache<int, std::string> lru(2);
+    lru.SetRemovalHandler(
+        [&handled](int&& key, std::string&& value, std::chrono::milliseconds, const RemovalCause cause) {
+            handled.emplace_back(key, std::move(value), cause);
+        });
+    lru.Put(1, "a");
+    lru.Put(2, "b");
+    lru.Put(3, "c");
+    lru.Put(2, "B");
+    (void)lru.Erase(3);
+    lru.Clear();
+    const std::vector<std::tuple<int, std::string, RemovalCause>> expected_handled{
+        {1, "a", RemovalCause::kCapacity},
+        {2, "b", RemovalCause::kReplaced},
+        {3, "c", RemovalCause::kExplicit},
+        {2, "B", RemovalCause::kCleared},
+    };
+    bool ok = handled == expected_handled;
+
+    // A sync listener has seen each removal by the time the call returns.
+    using Event = RemovalEvent<int, std::string>;
+    std::vector<std::tuple<int, std::string, RemovalCause>> events;
+    bool on_caller_thread = true;
+    const std::thread::id caller = std::this_thread::get_id();
+    ShardedLRUCache<int, std::string> cache(2, 1);
+    cache.SetRemovalListener(
+        [&](const std::span<Event> batch) {
+            on_caller_thread = on_caller_thread && std::this_thread::get_id() == caller;
+            for (Event& event : batch) {
+                events.emplace_back(event.key, std::move(event.value), event.cause);
+            }
+        },
+        RemovalDelivery::kSync);
+    const auto last_is = [&events](const int key, const std::string& value, const RemovalCause cause) {
+        return !events.empty() && events.back() == std::make_tuple(key, value, cause);
+    };
+    cache.Put(1, "a");
+    cache.Put(2, "b");
+    cache.Put(3, "c");
+    ok = ok && events.size() == 1U && last_is(1, "a", RemovalCause::kCapacity);
+    cache.Put(2, "B");
+    ok = ok && last_is(2, "b", RemovalCause::kReplaced);
+    ok = ok && cache.Erase(3) && last_is(3, "c", RemovalCause::kExplicit) && !cache.Erase(3);
+    cache.Put(4, "d", std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ok = ok && !cache.Get(4).has_value() && last_is(4, "d", RemovalCause::kExpired);
+    cache.Clear();
+    ok = ok && events.size() == 5U && last_is(2, "B", RemovalCause::kCleared);
+    // Entries Reshard moves stay in the cache, so nothing is reported.
+    cache.Put(5, "e");
+    cache.Reshard(4);
+    ok = ok && events.size() == 5U && cache.Get(5) == "e" && on_caller_thread;
+
+    bool threw = false;
+    try {
+        cache.SetRemovalListener([](std::span<Event>) {});
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    ok = ok && threw;
+
+    // With a disk tier, evictions spill instead of being reported.
+    const std::string directory = DiskTierTestDirectory("listener");
+    {
+        std::vector<RemovalCause> causes;
+        ShardedLRUCache<int, std::string> tiered(2, 1);
+        tiered.EnableDiskTier(DiskTierOptions{directory});
+        tiered.SetRemovalListener(
+            [&causes](const std::span<Event> batch) {
+                for (const Event& event : batch) {
+                    causes.push_back(event.cause);
+                }
+            },
+            RemovalDelivery::kSync);
+        for (int key = 0; key < 8; ++key) {
+            tiered.Put(key, std::to_string(key));
+        }
+        ok = ok && causes.empty() && tiered.Get(0) == "0";
+        ok = ok && tiered.Erase(0) && causes == std::vector<RemovalCause>{RemovalCause::kExplicit};
+    }
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+bool TestRemovalListenerAsync() {
+    using Event = RemovalEvent<int, int>;
+    constexpr int kThreads = 4;
+    constexpr int kKeysPerThread = 5000;
+    std::atomic<std::uint64_t> evicted{0};
+    std::atomic<std::uint64_t> cleared{0};
+    std::atomic<std::uint64_t> batches{0};
+    std::atomic<bool> bad{false};
+    const std::thread::id caller = std::this_thread::get_id();
+    std::size_t resident = 0;
+    bool ok = true;
+    {
+        ShardedLRUCache<int, int> cache(16, 4);
+        cache.SetRemovalListener([&](const std::span<Event> batch) {
+            batches.fetch_add(1U);
+            if (std::this_thread::get_id() == caller) {
+                bad.store(true);
+            }
+            for (const Event& event : batch) {
+                if (event.value != event.key * 2) {
+                    bad.store(true);
+                }
+                if (event.cause == RemovalCause::kCapacity) {
+                    evicted.fetch_add(1U);
+                } else if (event.cause == RemovalCause::kCleared) {
+                    cleared.fetch_add(1U);
+                } else {
+                    bad.store(true);
+                }
+            }
+        });
+
+        std::vector<std::thread> threads;
+        for (int thread_id = 0; thread_id < kThreads; ++thread_id) {
+            threads.emplace_back([thread_id, &cache]() {
+                for (int i = 0; i < kKeysPerThread; ++i) {
+                    const int key = thread_id * kKeysPerThread + i;
+                    cache.Put(key, key * 2);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        cache.FlushRemovals();
+        // Every distinct key put is either resident or was evicted once.
+        resident = cache.Size();
+        ok = evicted.load() == static_cast<std::uint64_t>(kThreads * kKeysPerThread) - resident;
+        // Removals still queued when the cache goes are delivered first.
+        cache.Clear();
+    }
+    ok = ok && cleared.load() == resident && !bad.load();
+    // Batched: far fewer listener calls than events.
+    ok = ok && batches.load() < evicted.load() / 2U;
+    return ok;
+}
+
+bool TestRefreshAhead() {
+    const auto eventually = [](const auto& condition) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    };
+
+    std::promise<void> release;
+    const std::shared_future<void> gate = release.get_future().share();
+    std::atomic<int> loads{0};
+    std::atomic<bool> failing{false};
+    ShardedLRUCache<int, int> cache(64, 2);
+    const RefreshOptions options{std::chrono::milliseconds(20), 2, 16};
+    cache.EnableRefreshAhead(options, [&](const int& key) {
+        loads.fetch_add(1);
+        gate.wait();
+        if (failing.load()) {
+            throw std::runtime_error("backend down");
+        }
+        return key * 100 + 1;
+    });
+    cache.Put(1, 100);
+    cache.Put(2, 200);
+    bool ok = cache.Get(1) == 100 && cache.RefreshStats().scheduled == 0U;
+
+    // Stale hits return the old value at once, while the reload is blocked,
+    // and schedule only one reload per key.
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    for (int i = 0; i < 100; ++i) {
+        ok = ok && cache.Get(1) == 100;
+    }
+    ok = ok && cache.Get(2) == 200;
+    // Overwritten while its reload runs: the reload must not win.
+    cache.Put(2, 222);
+    ok = ok && cache.RefreshStats().scheduled == 2U;
+    release.set_value();
+    ok = ok && eventually([&cache] {
+        const RefreshAheadStats stats = cache.RefreshStats();
+        return stats.replaced == 1U && stats.discarded == 1U;
+    });
+    ok = ok && cache.Get(1) == 101 && cache.Get(2) == 222 && loads.load() == 2;
+
+    // A failing loader leaves the entry in place; a later stale hit retries.
+    failing.store(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ok = ok && cache.Get(1) == 101;
+    ok = ok && eventually([&cache] { return cache.RefreshStats().failed == 1U; });
+    failing.store(false);
+    ok = ok && cache.Get(1) == 101;
+    ok = ok && eventually([&cache] { return cache.RefreshStats().replaced == 2U; });
+
+    bool threw_twice = false;
+    try {
+        cache.EnableRefreshAhead(options, [](const int& key) { return key; });
+    } catch (const std::logic_error&) {
+        threw_twice = true;
+    }
+    bool threw_invalid = false;
+    try {
+        ShardedLRUCache<int, int> other(4, 1);
+        other.EnableRefreshAhead(RefreshOptions{std::chrono::milliseconds(0)},
+                                 [](const int& key) { return key; });
+    } catch (const std::invalid_argument&) {
+        threw_invalid = true;
+    }
+    return ok && threw_twice && threw_invalid;
+}
+
+bool TestGetAsyncSharesLoads() {
+    RunLoop loop;
+    ShardedLRUCache<int, int> cache(64, 4);
+    int loads = 0;
+    const auto loader = [&loop, &loads](const int& key) -> Task<int> {
+        ++loads;
+        // Stays in flight across many turns of the loop.
+        for (int i = 0; i < 10; ++i) {
+            co_await Reschedule(loop);
+        }
+        if (key == 99) {
+            throw std::runtime_error("backend down");
+        }
+        co_return key * 10;
+    };
+
+    // One thread, 1000 coroutines, 10 missing keys: one load per key.
+    int correct = 0;
+    int failures = 0;
+    for (int i = 0; i < 1000; ++i) {
+        loop.Spawn([](ShardedLRUCache<int, int>& target, RunLoop& executor, auto load, int key, int& good,
+                      int& failed) -> Task<void> {
+            try {
+                if (co_await target.GetAsync(executor, key, load) == key * 10) {
+                    ++good;
+                }
+            } catch (const std::runtime_error&) {
+                ++failed;
+            }
+        }(cache, loop, loader, i % 10 == 9 ? 99 : i % 10, correct, failures));
+    }
+    loop.Run();
+    bool ok = loads == 10 && correct == 900 && failures == 100 && cache.Size() == 9U && !cache.Contains(99);
+
+    // A hit completes without calling the loader; a failed key loads again.
+    ok = ok && loop.Run(cache.GetAsync(loop, 3, loader)) == 30 && loads == 10;
+    bool threw = false;
+    try {
+        (void)loop.Run(cache.GetAsync(loop, 99, loader));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    return ok && threw && loads == 11;
+}
+
+bool TestGetAsyncYieldsOnContention() {
+    RunLoop loop;
+    ShardedLRUCache<int, int> cache(64, 1);
+    cache.Put(1, 100);
+
+    // Another thread holds the only shard lock until the loop releases it.
+    std::promise<void> held;
+    std::promise<void> release;
+    std::thread holder([&] {
+        (void)cache.GetWith(1, [&](const int&) {
+            held.set_value();
+            release.get_future().wait();
+        });
+    });
+    held.get_future().wait();
+
+    int value = 0;
+    bool pending_at_release = false;
+    loop.Spawn([](ShardedLRUCache<int, int>& target, RunLoop& executor, int& out) -> Task<void> {
+        out = co_await target.GetAsync(executor, 1, [](const int& key) -> Task<int> { co_return key; });
+    }(cache, loop, value));
+    // Gets to run only if GetAsync hands the thread back while it waits.
+    loop.Spawn([](RunLoop& executor, std::promise<void>& unblock, const int& got,
+                  bool& pending) -> Task<void> {
+        for (int i = 0; i < 100; ++i) {
+            co_await Reschedule(executor);
+        }
+        pending = got == 0;
+        unblock.set_value();
+    }(loop, release, value, pending_at_release));
+    loop.Run();
+    holder.join();
+    return pending_at_release && value == 100;
+}
+
+bool TestGetAsyncFinishesOnLoaderThread() {
+    // Resumes the awaiting coroutine on a new thread, as a loader whose I/O
+    // completes elsewhere would.
+    struct ResumeOnThread {
+        std::vector<std::thread>& threads;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            threads.emplace_back([handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::vector<std::thread> threads;
+    ShardedLRUCache<int, int> cache(64, 2);
+    const auto loader = [&threads](const int& key) -> Task<int> {
+        co_await ResumeOnThread{threads};
+        co_return key * 10;
+    };
+    bool ok = true;
+    for (int round = 0; round < 200; ++round) {
+        int waiter_value = 0;
+        int value = 0;
+        {
+            // The last task finishes on the loader's thread; the loop is
+            // destroyed as soon as Run returns.
+            RunLoop loop;
+            loop.Spawn([](ShardedLRUCache<int, int>& target, RunLoop& executor, auto load, int key,
+                          int& out) -> Task<void> {
+                out = co_await target.GetAsync(executor, key, load);
+            }(cache, loop, loader, round, waiter_value));
+            value = loop.Run(cache.GetAsync(loop, round, loader));
+        }
+        ok = ok && value == round * 10 && waiter_value == round * 10;
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return ok && threads.size() == 200U;
+}
+
+}  // namespace
+
+void RunConcurrentIndexBenchmark() {
+    // 64 threads, 90% reads over a key space twice the capacity: the sharded
+    // cache with 16 shards against the single lock-free index.
+    constexpr unsigned kThreads = 64;
+    constexpr int kOpsPerThread = 20000;
+    constexpr int kKeySpace = 4096;
+
+    const auto measure = [&](auto& cache) {
+        std::vector<std::thread> threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned thread_id = 0; thread_id < kThreads; ++thread_id) {
+            threads.emplace_back([&cache, thread_id] {
+                for (int i = 0; i < kOpsPerThread; ++i) {
+                    const int key = ((static_cast<int>(thread_id) * 257) + i * 13) % kKeySpace;
+                    if (i % 10 == 0) {
+                        cache.Put(key, i);
+                    } else {
+                        (void)cache.Get(key);
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const double elapsed_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(kThreads) * kOpsPerThread / elapsed_s;
+    };
+
+    ShardedLRUCache<int, int> sharded(128, 16);
+    ConcurrentLRUCache<int, int> concurrent(2048);
+    const double sharded_rate = measure(sharded);
+    const double concurrent_rate = measure(concurrent);
+    std::cout << "[INFO] Benchmark: " << kThreads << " threads, 90% reads, sharded (16 shards) " << std::fixed
+              << std::setprecision(2) << sharded_rate / 1e6 << " M ops/s, lock-free index "
+              << concurrent_rate / 1e6 << " M ops/s\n";
+}
 
 int main() {
     PrintResult("Constructor validation", TestConstructorValidation());
     PrintResult("Basic put/get/update", TestBasicBehavior());
-    PrintResult("Per-shard LRU eviction", TestEvictionPerShard());
+    PrintResult("Per-shard LRU eviction", TestEvictionPerShard<LruPolicy<int>>(2));
+    // 2Q treats a hit in A1in as correlated, so key 1 is not protected yet.
+    PrintResult("Per-shard 2Q eviction", TestEvictionPerShard<TwoQueuePolicy<int>>(1));
+    PrintResult("Per-shard ARC eviction", TestEvictionPerShard<ArcPolicy<int>>(2));
+    PrintResult("Per-shard S3-FIFO eviction", TestEvictionPerShard<S3FifoPolicy<int>>(2));
+    PrintResult("Per-shard W-TinyLFU eviction", TestEvictionPerShard<TinyLfuPolicy<int>>(2));
+    // Both entries carry a reference bit, so the CLOCK sweep falls back to FIFO.
+    PrintResult("Per-shard CLOCK eviction", TestEvictionPerShard<ClockPolicy<int>>(1));
+    PrintResult("Per-shard buffered LRU eviction", TestEvictionPerShard<BufferedPolicy<int>>(2));
+    PrintResult("2Q scan resistance", TestScanResistance<TwoQueuePolicy<int>>());
+    PrintResult("ARC scan resistance", TestScanResistance<ArcPolicy<int>>());
+    PrintResult("S3-FIFO scan resistance", TestScanResistance<S3FifoPolicy<int>>());
+    PrintResult("W-TinyLFU scan resistance", TestScanResistance<TinyLfuPolicy<int>>());
+    PrintResult("Frequency sketch saturates and ages", TestFrequencySketch());
+    PrintResult("W-TinyLFU rejects one-hit wonders", TestTinyLfuRejectsOneHitWonders());
+    PrintResult("Shard selection (mask and multiply-shift)", TestShardSelection());
+    PrintResult("Custom shard selector", TestCustomShardSelector());
     PrintResult("Clear and size", TestClearAndSize());
-    PrintResult("Concurrent stress", TestConcurrentStress());
-    RunConcurrentBenchmark();
+    PrintResult("GetWith visits in place (LRU)", TestGetWithVisitsInPlace<LruPolicy<int>>());
+    PrintResult("GetWith visits in place (CLOCK)", TestGetWithVisitsInPlace<ClockPolicy<int>>());
+    PrintResult("GetWith visits in place (buffered LRU)", TestGetWithVisitsInPlace<BufferedPolicy<int>>());
+    PrintResult("Shared values outlive eviction", TestSharedValuesOutliveEviction());
+    PrintResult("MultiGet/MultiPut (LRU)", TestMultiGetAndMultiPut<LruPolicy<int>>());
+    PrintResult("MultiGet/MultiPut (CLOCK)", TestMultiGetAndMultiPut<ClockPolicy<int>>());
+    PrintResult("MultiGet/MultiPut (buffered LRU)", TestMultiGetAndMultiPut<BufferedPolicy<int>>());
+    PrintResult("Timing wheel expires on time across levels", TestTimingWheel());
+    PrintResult("TTL expiry (LRU)", TestTtlExpiry<LruPolicy<int>>());
+    PrintResult("TTL expiry (CLOCK shared reads)", TestTtlExpiry<ClockPolicy<int>>());
+    PrintResult("TTL expiry (buffered LRU)", TestTtlExpiry<BufferedPolicy<int>>());
+    PrintResult("Default TTL reclaimed on Put", TestDefaultTtlReclaimsOnPut());
+    PrintResult("Weighted eviction order (LRU)", TestWeightedEvictionOrder());
+    PrintResult("Weighted budget (LRU)", TestWeightedBudget<LruPolicy<int>>());
+    PrintResult("Weighted budget (CLOCK)", TestWeightedBudget<ClockPolicy<int>>());
+    PrintResult("Weighted budget (W-TinyLFU)", TestWeightedBudget<TinyLfuPolicy<int>>());
+    PrintResult("Weighted budget (buffered LRU)", TestWeightedBudget<BufferedPolicy<int>>());
+    PrintResult("Adaptive capacity lends quota to the hot shard", TestAdaptiveCapacity());
+    PrintResult("Adaptive capacity stays bounded under concurrency", TestAdaptiveCapacityUnderConcurrency());
+    PrintResult("Adaptive capacity lets a sync listener re-enter", TestAdaptiveListenerReenters());
+    PrintResult("Front cache sees writes, evictions and TTLs", TestFrontCacheSeesWrites());
+    PrintResult("Front cache is never stale (LRU)", TestFrontCacheNeverStale<LruPolicy<int>>());
+    PrintResult("Front cache is never stale (CLOCK)", TestFrontCacheNeverStale<ClockPolicy<int>>());
+    PrintResult("Resize shrinks and grows shards", TestResize());
+    PrintResult("Reshard keeps entries under load (LRU)", TestReshardKeepsEntries<LruPolicy<int>>());
+    PrintResult("Reshard keeps entries under load (CLOCK)", TestReshardKeepsEntries<ClockPolicy<int>>());
+    PrintResult("Reshard keeps layouts a load still uses", TestReshardKeepsLayoutsInUse());
+    PrintResult("Reshard keeps entries under load (buffered LRU)",
+                TestReshardKeepsEntries<BufferedPolicy<int>>());
+    PrintResult("Reshard pauses stay bounded", TestReshardPauseIsBounded());
+    PrintResult("GetOrLoad runs one loader per key", TestGetOrLoadSingleFlight());
+    PrintResult("GetOrLoad propagates loader exceptions", TestGetOrLoadPropagatesExceptions());
+    PrintResult("Move-only values and string_view lookups (LRU)",
+                TestMoveAndHeterogeneousLookup<LruPolicy<std::string>>());
+    PrintResult("Move-only values and string_view lookups (buffered LRU)",
+                TestMoveAndHeterogeneousLookup<BufferedPolicy<std::string>>());
+    PrintResult("Concurrent stress (LRU)", TestConcurrentStress<LruPolicy<int>>());
+    PrintResult("Concurrent stress (2Q)", TestConcurrentStress<TwoQueuePolicy<int>>());
+    PrintResult("Concurrent stress (ARC)", TestConcurrentStress<ArcPolicy<int>>());
+    PrintResult("Concurrent stress (S3-FIFO)", TestConcurrentStress<S3FifoPolicy<int>>());
+    PrintResult("Concurrent stress (CLOCK)", TestConcurrentStress<ClockPolicy<int>>());
+    PrintResult("CLOCK shared-lock reads under writes", TestSharedReads<ClockPolicy<int>>());
+    PrintResult("Concurrent stress (buffered LRU)", TestConcurrentStress<BufferedPolicy<int>>());
+    PrintResult("Buffered reads under writes", TestSharedReads<BufferedPolicy<int>>());
+    // A concurrent insert into the same shard may legitimately reject a key
+    // that is still in the one-entry admission window, so only bounds are checked.
+    PrintResult("Concurrent stress (W-TinyLFU)", TestConcurrentStress<TinyLfuPolicy<int>>(false));
+    PrintResult("Stats count hits, misses, puts and evictions", TestStatsCountOperations());
+    PrintResult("Latency histogram buckets and percentiles", TestLatencyHistogram());
+    PrintResult("Stats stay exact under concurrency", TestStatsUnderConcurrency());
+    PrintResult("Lock-free index: basics, eviction and Clear", TestConcurrentCacheBasics());
+    PrintResult("Lock-free index: concurrent stress", TestConcurrentCacheStress());
+    PrintResult("Lock-free index: 64 threads, reads under eviction", TestConcurrentCacheReadsUnderEviction());
+    PrintResult("Workload generators match their distributions", TestWorkloadDistributions());
+    PrintResult("Trace parsing and interleaved replay", TestTraceReplay());
+    PrintResult("Workload harness reports results as JSON", TestWorkloadHarnessJson());
+    PrintResult("Snapshot round trip keeps recency and TTLs", TestSnapshotRoundTrip());
+    PrintResult("Snapshot codecs and rejected files", TestSnapshotCodecs());
+    PrintResult("Background snapshot while writing, parallel load", TestSnapshotWhileWriting());
+    PrintResult("Disk tier spills evictions and promotes hits", TestDiskTierSpillAndPromote());
+    PrintResult("Disk tier never serves overwritten or cleared values", TestDiskTierInvalidation());
+    PrintResult("Disk tier compaction and budget under load", TestDiskTierCompactionUnderLoad());
+    PrintResult("Disk tier writes stay visible while a batch is appended", TestDiskTierWritesDuringAppend());
+    PrintResult("Shared-memory cache shared across processes", TestSharedMemoryAcrossProcesses());
+    PrintResult("Shared-memory cache recovers a dead lock owner", TestSharedMemoryRecoversDeadLockOwner());
+    PrintResult("Removal causes reach a sync listener before returning", TestRemovalCausesSync());
+    PrintResult("Async removal listener gets batched events", TestRemovalListenerAsync());
+    PrintResult("Refresh-ahead serves stale values and reloads once", TestRefreshAhead());
+    PrintResult("GetAsync shares one load among concurrent awaiters", TestGetAsyncSharesLoads());
+    PrintResult("GetAsync suspends instead of blocking on a held shard", TestGetAsyncYieldsOnContention());
+    PrintResult("GetAsync may finish on a loader's thread", TestGetAsyncFinishesOnLoaderThread());
+    RunThreadSweepBenchmark();
+    RunBatchBenchmark();
+    RunFrontCacheBenchmark();
+    RunConcurrentIndexBenchmark();
     return 0;
 }